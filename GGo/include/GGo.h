@@ -11,12 +11,15 @@
 #include"address.h"
 #include"bytearray.h"
 #include"config.h"
+#include"configWatcher.h"
 #include"endianParser.h"
+#include"fdTable.h"
 #include"fdManager.h"
 #include"fiber.h"
 #include"TCPSever.h"
 #include"hook.h"
 #include"ioScheduler.h"
+#include"lockFreeQueue.h"
 #include"logSystem.h"
 #include"macro.h"
 #include"mutex.h"
@@ -40,6 +43,7 @@
 
 #include "http/servlets/configServlet.h"
 #include "http/servlets/statusServlet.h"
+#include "http/servlets/staticFileServlet.h"
 
 
 #include "streams/stream.h"
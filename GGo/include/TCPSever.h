@@ -138,6 +138,8 @@ public:
 
 
     /// @brief 批量绑定地址
+    /// @details accept_worker开启每线程epoll时，每个地址为每个事件循环线程各监听一个
+    ///          SO_REUSEPORT socket，由内核分发连接，连接在接受它的线程上处理至结束
     /// @param addrs 待绑定的地址数组
     /// @param fails 绑定失败的地址数组
     /// @param ssl 是否使用SSLScocket
@@ -195,6 +197,8 @@ protected:
 protected:
     // 被监听的sock数组
     std::vector<Socket::ptr> m_socks;
+    // 每个被监听sock固定的accept线程，-1表示任意线程
+    std::vector<int> m_sockThreads;
     IOScheduler* m_worker;
     IOScheduler* m_ioWorker;
     IOScheduler* m_acceptWorker;
@@ -9,12 +9,14 @@
  */
 #pragma once
 #include<memory>
+#include<atomic>
 #include<sstream>
 #include<string>
 #include<unordered_map>
 #include<vector>
 #include<functional>
 #include<list>
+#include<deque>
 #include<map>
 #include<set>
 #include<unordered_set>
@@ -299,12 +301,12 @@ public:
     ConfigVar(const std::string& name,const T& default_value
             ,const std::string& description)
             :ConfigVarBase(name,description)
-            ,m_val(default_value)
+            ,m_val(std::make_shared<const T>(default_value))
+            ,m_slot(s_slots++)
             {}
     std::string toString() override{
         try{
-            RWMutexType::readLock lock(m_mutex);
-            return ToStr()(m_val);
+            return ToStr()(*getSnapshot());
         }catch (std::exception& e){
             GGO_LOG_ERROR(GGO_LOG_ROOT()) << "ConfigVar::toString exception "
                 << e.what() <<" convert " << "XXX" << "to string"
@@ -325,26 +327,39 @@ public:
         return false;
     }
 
-    /// @brief 设定新的配置项值，执行委托的函数
+    /// @brief 设定新的配置项值，发布新的快照后执行委托的函数
+    /// @details 回调执行时getValue()已经返回新值；多个线程同时设置时按发布的顺序回调
     void setValue(const T& v){
+        Mutex::Lock write_lock(m_writeMutex);
+        std::shared_ptr<const T> old = m_val.load(std::memory_order_acquire);
+        if (*old == v)
+        {
+            return;
+        }
+        m_val.store(std::make_shared<const T>(v), std::memory_order_release);
+        m_version.fetch_add(1, std::memory_order_release);
+        std::map<uint64_t,on_change_callback> cbs;
         {
             RWMutexType::readLock lock(m_mutex);
-            if (m_val == v)
-            {
-                return;
-            }
-            for (auto &kv : m_cbs)
-            {
-                kv.second(m_val, v);
-            }
+            cbs = m_cbs;
+        }
+        for (auto &kv : cbs)
+        {
+            kv.second(*old, v);
         }
-        RWMutexType::writeLock lock(m_mutex);
-        m_val = v;
     }
 
-    const T getValue() {
-        RWMutexType::readLock lock(m_mutex);
-        return m_val;
+    /// @brief 返回配置项值的拷贝，不加锁
+    const T getValue() const {
+        return *cached();
+    }
+
+    /// @brief 返回配置项值的只读快照，不加锁也不拷贝值
+    /// @details 设置新值时整体替换成新的快照，已经拷贝出去的快照不受影响，
+    ///          vector、map等容器类型在热路径上应使用它代替getValue()。
+    ///          按值返回本线程缓存的shared_ptr，协程让出后在其他线程恢复也可以继续使用
+    std::shared_ptr<const T> getSnapshot() const {
+        return cached();
     }
 
     /// @brief 添加对应的回调函数委托
@@ -380,11 +395,43 @@ public:
         m_cbs.clear();
     }
 private:
-    T m_val;
+    /// @brief 线程缓存的快照
+    struct Cached{
+        uint64_t version = 0;
+        std::shared_ptr<const T> val;
+    };
+
+    /// @brief 返回本线程缓存的快照，版本没变时只有一次原子读，不碰共享的快照
+    /// @details 类似RCU，旧快照在所有线程换到新版本前由线程缓存持有
+    const std::shared_ptr<const T>& cached() const {
+        // 同类型的配置项按m_slot各占一项，deque扩容时已有的元素不移动
+        static thread_local std::deque<Cached> t_cached;
+        if(t_cached.size() <= m_slot){
+            t_cached.resize(m_slot + 1);
+        }
+        Cached& c = t_cached[m_slot];
+        uint64_t version = m_version.load(std::memory_order_acquire);
+        if(c.version != version){
+            c.val = m_val.load(std::memory_order_acquire);
+            c.version = version;
+        }
+        return c.val;
+    }
+
+    /// @brief 当前值的快照，设置时整体替换
+    std::atomic<std::shared_ptr<const T>> m_val;
+    /// @brief 快照的版本，每次替换加一
+    std::atomic<uint64_t> m_version = {1};
+    /// @brief 在线程缓存中的位置
+    size_t m_slot;
+    /// @brief 同类型配置项已分配的位置数
+    static inline std::atomic<size_t> s_slots = {0};
     /// @brief 委托模式，存储回调函数映射表
     std::map<uint64_t,on_change_callback> m_cbs;
-    // mutex
+    // 保护m_cbs
     RWMutexType m_mutex;
+    // 串行化setValue，保证回调顺序与发布顺序一致
+    Mutex m_writeMutex;
 };
 
 class Config{
@@ -447,6 +494,13 @@ public:
     /// @brief 读入yaml节点 将其转换为配置名和配置项
     /// @param root yaml节点对象
     static void loadFromYaml(YAML::Node& root);
+
+    /// @brief 与上一次读入的yaml节点比较，只重新解析内容发生变化的配置项
+    /// @param old_root 上一次读入的yaml节点
+    /// @param root 新读入的yaml节点
+    /// @details 一次后序遍历比较两棵树，子树未变化的配置项不会被解析也不会触发监听
+    /// @return 重新解析的配置项数量
+    static size_t loadFromYamlDiff(const YAML::Node& old_root, const YAML::Node& root);
     
     /// @brief 查找配置参数，返回其参数的基类指针
     /// @param name 配置名
@@ -0,0 +1,94 @@
+/**
+ * @file configWatcher.h
+ * @author GGo
+ * @brief 配置文件热加载
+ * @date 2024-03-20
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#pragma once
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+#include "ioScheduler.h"
+#include "mutex.h"
+#include "nonCopyable.h"
+
+namespace GGo{
+
+/// @brief 监听yaml配置文件的修改并增量更新配置项
+/// @details 用inotify监听文件所在目录（编辑器保存时常常是写新文件再rename覆盖），
+///          inotify句柄注册在IO协程调度器上，不占用单独的线程。
+///          连续的修改在debounce毫秒内合并为一次重新加载，
+///          重新加载时与上一次的yaml比较，只有内容变化的配置项才会被解析并通知监听者。
+///          回调中只持有弱引用，需要用std::make_shared创建
+class ConfigWatcher : public std::enable_shared_from_this<ConfigWatcher>
+                    , nonCopyable
+{
+public:
+    using ptr = std::shared_ptr<ConfigWatcher>;
+    using MutexType = Mutex;
+
+    /// @brief 构造函数
+    /// @param iom 监听与重新加载所在的IO协程调度器
+    /// @param debounce 合并连续修改的时间(ms)
+    ConfigWatcher(IOScheduler* iom = IOScheduler::getThis(), uint64_t debounce = 100);
+
+    /// @brief 析构函数，停止监听
+    ~ConfigWatcher();
+
+    /// @brief 添加监听的配置文件并立即加载一次
+    /// @param path 文件路径
+    /// @return 文件读取或解析失败返回false，之后文件被修正时仍会加载
+    bool addFile(const std::string& path);
+
+    /// @brief 开始监听
+    bool start();
+
+    /// @brief 停止监听
+    void stop();
+
+    /// @brief 重新加载发生过修改的文件
+    /// @param all 是否不论有没有修改都重新加载全部文件
+    /// @return 重新解析的配置项数量
+    size_t reload(bool all = false);
+
+    /// @brief 已经执行的重新加载次数
+    uint64_t getReloadCount() const { return m_reloads; }
+
+    /// @brief 合并连续修改的时间(ms)
+    uint64_t getDebounce() const { return m_debounce; }
+private:
+    /// @brief inotify句柄可读，读出全部事件后重新注册
+    void onReadable();
+
+    /// @brief 去抖定时器到期，距离最后一次修改已满debounce时重新加载
+    void onTimer();
+
+    /// @brief 监听文件所在的目录
+    bool watch(const std::string& path, int& wd);
+private:
+    /// @brief 被监听的文件
+    struct File{
+        std::string path;
+        std::string name;
+        int wd = -1;
+        bool dirty = false;
+        YAML::Node root;
+    };
+
+    IOScheduler* m_iom;
+    uint64_t m_debounce;
+    int m_fd = -1;
+    bool m_pending = false;
+    uint64_t m_lastEvent = 0;
+    std::vector<File> m_files;
+    std::atomic<uint64_t> m_reloads = {0};
+    MutexType m_mutex;
+    /// @brief 重新加载串行执行
+    MutexType m_reloadMutex;
+};
+
+}
@@ -10,10 +10,12 @@
 
 #pragma once
 
+#include<atomic>
 #include<memory>
 #include<vector>
 #include"thread.h"
 #include"singleton.h"
+#include"fdTable.h"
 
 namespace GGo{
 
@@ -103,10 +105,8 @@ public:
     void del(int fd);
 
 private:
-    // 读写锁
-    RWMutexType m_mutex;
-    // 文件句柄集合
-    std::vector<FdCtx::ptr> m_fds;
+    // 文件句柄集合，每个元素是独立的std::atomic<std::shared_ptr>，不经过全局的锁池
+    FdTable<std::atomic<FdCtx::ptr>> m_fds;
 };
 
 /// @brief  文件句柄管理器单例实现
@@ -0,0 +1,93 @@
+/**
+ * @file fdTable.h
+ * @author GGo
+ * @brief 以文件句柄为下标的分页表
+ * @date 2024-03-09
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+#include<atomic>
+#include<stddef.h>
+#include"nonCopyable.h"
+
+namespace GGo{
+
+/// @brief 两级分页的句柄表
+/// @details 一级目录在构造时固定大小，二级页在第一次访问时分配，分配后不再移动也不释放；
+///          查找与分配都是无锁的，元素本身的并发访问由使用者负责
+/// @tparam T 元素类型，需要能默认构造（值初始化）
+/// @tparam PageBits 每页元素数量的位数
+/// @tparam DirSize 一级目录的页数
+template<class T, size_t PageBits = 10, size_t DirSize = 1024>
+class FdTable : nonCopyable{
+public:
+    // 每页的元素数量
+    static constexpr size_t PAGE_SIZE = (size_t)1 << PageBits;
+    // 能容纳的最大句柄（不含）
+    static constexpr size_t MAX_FD = PAGE_SIZE * DirSize;
+
+    FdTable(){
+        for(size_t i = 0; i < DirSize; i++){
+            m_pages[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~FdTable(){
+        for(size_t i = 0; i < DirSize; i++){
+            delete m_pages[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief 取得fd对应的元素
+    /// @param fd 文件句柄
+    /// @param create 所在页不存在时是否分配
+    /// @return fd超出范围，或页不存在且不分配时返回nullptr
+    T* get(int fd, bool create){
+        if(fd < 0 || (size_t)fd >= MAX_FD){
+            return nullptr;
+        }
+        std::atomic<Page*>& entry = m_pages[(size_t)fd >> PageBits];
+        Page* page = entry.load(std::memory_order_acquire);
+        if(!page){
+            if(!create){
+                return nullptr;
+            }
+            // 多个线程同时分配时只有一个成功，其余的释放自己分配的页
+            Page* created = new Page();
+            if(entry.compare_exchange_strong(page, created, std::memory_order_acq_rel)){
+                page = created;
+            }else{
+                delete created;
+            }
+        }
+        return &page->slots[(size_t)fd & (PAGE_SIZE - 1)];
+    }
+
+    /// @brief 遍历所有已分配页中的元素
+    /// @param func 对每个元素调用 func(int fd, T& value)
+    template<class Func>
+    void foreach(Func func){
+        for(size_t i = 0; i < DirSize; i++){
+            Page* page = m_pages[i].load(std::memory_order_acquire);
+            if(!page){
+                continue;
+            }
+            for(size_t j = 0; j < PAGE_SIZE; j++){
+                func((int)(i * PAGE_SIZE + j), page->slots[j]);
+            }
+        }
+    }
+
+private:
+    /// @brief 二级页
+    struct Page{
+        T slots[PAGE_SIZE];
+    };
+
+    // 一级目录
+    std::atomic<Page*> m_pages[DirSize];
+};
+
+}
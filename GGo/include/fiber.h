@@ -11,9 +11,8 @@
 
 #include<memory>
 #include<functional>
-#include<ucontext.h>
+#include"fiberContext.h"
 
-// TODO:: 协程ID没有做回收，可以用最小堆
 // TODO:: 协程的恢复可能有内存安全问题
 // TODO:: 第一个主协程的创建能不能不让用户完成
 // TODO:: 修改协程挂起与调度的接口，不将调度器的接口暴露在外
@@ -21,9 +20,12 @@ namespace GGo{
 
 /// @brief  协程调度器
 class Scheduler;
+/// @brief 线程共享栈组
+struct SharedStackGroup;
 /// @brief 协程类
 class Fiber : public std::enable_shared_from_this<Fiber> {
 friend class Scheduler;
+friend struct SharedStackGroup;
 public:
     /// @brief 智能指针
     using ptr = std::shared_ptr<Fiber>;
@@ -55,9 +57,13 @@ public:
 
     /// @brief 协程构造函数
     /// @param cb 协程执行任务
-    /// @param stacksize 协程栈大小
+    /// @param stacksize 协程栈大小，共享栈模式下忽略
     /// @param use_caller 是否使用调度器
-    Fiber(mission cb, size_t stacksize = 0, bool use_scheduler = false);
+    /// @param shared_stack 是否使用共享栈模式
+    /// @details 共享栈模式下协程运行在线程的几个大栈上，切换时只拷贝已使用的部分；
+    ///          一旦开始运行就只能在同一线程上恢复，调度器会自动把它固定到该线程；
+    ///          不要把指向协程栈上变量的指针交给其他协程使用
+    Fiber(mission cb, size_t stacksize = 0, bool use_scheduler = false, bool shared_stack = false);
 
     /// @brief 析构函数
     ~Fiber();
@@ -106,6 +112,37 @@ public:
     /// @brief 返回当前协程的总数量
     static uint64_t TotalFibers();
 
+    /// @brief 协程栈从线程缓存池中复用的次数
+    static uint64_t StackPoolHits();
+
+    /// @brief 协程栈缓存池未命中、新mmap栈的次数
+    static uint64_t StackPoolMisses();
+
+    /// @brief 调度器创建的协程是否默认使用共享栈（配置fiber.shared_stack）
+    static bool SharedStackByDefault();
+
+    /// @brief 获取一个执行cb的协程，优先复用本线程缓存的已结束协程
+    /// @param cb 协程执行任务
+    /// @param shared_stack 是否使用共享栈
+    static Fiber::ptr Create(mission cb, bool shared_stack = false);
+
+    /// @brief 回收已结束的协程到本线程缓存
+    /// @details 仅当fiber是唯一引用且处于TERM/EXCEPT状态时回收，否则只是释放引用
+    /// @post fiber为空
+    static void Recycle(Fiber::ptr& fiber);
+
+    /// @brief Create新构造协程的次数
+    static uint64_t CreatedFibers();
+
+    /// @brief Create复用缓存协程的次数
+    static uint64_t ReusedFibers();
+
+    /// @brief 是否使用共享栈
+    bool isSharedStack() const { return m_sharedMode; }
+
+    /// @brief 共享栈协程绑定的线程ID，未绑定返回-1
+    int getStackThread() const { return m_stackThread; }
+
     /// @brief 协程执行函数
     static void mainFunc();
 
@@ -114,6 +151,16 @@ public:
 
     /// @brief 返回当前协程的ID
     static uint64_t getFiberID();
+private:
+    /// @brief 线程共享栈
+    struct SharedStack;
+
+    /// @brief 切入共享栈协程前，换出共享栈上原来的协程并换入自己的栈内容
+    /// @attention 必须在其他栈上（调度协程或线程主协程）调用
+    void switchToSharedStack();
+
+    /// @brief 将自己在共享栈上已使用的部分拷贝到私有缓冲区
+    void saveSharedStack(SharedStack* stack);
 private:
     // 协程ID
     uint64_t m_id = 0;
@@ -122,13 +169,25 @@ private:
     // 协程运行状态
     State m_state = State::INIT;
     // 协程上下文
-    ucontext_t m_ctx;
+    FiberContext m_ctx;
     // 协程栈指针
     void* m_stack = nullptr;
     // 协程运行函数
     mission m_cb;
     // 是否使用了调度器
     bool m_hasScheduler = false;
+    // 是否使用共享栈
+    bool m_sharedMode = false;
+    // 绑定的共享栈
+    SharedStack* m_sharedStack = nullptr;
+    // 共享栈所属线程
+    int m_stackThread = -1;
+    // 切出后保存的栈内容
+    char* m_saveBuffer = nullptr;
+    // 保存缓冲区容量
+    size_t m_saveCapacity = 0;
+    // 保存的栈内容大小
+    size_t m_saveSize = 0;
 
 };
 
@@ -0,0 +1,92 @@
+/**
+ * @file fiberContext.h
+ * @author GGo
+ * @brief 协程上下文切换
+ * @date 2024-03-05
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+#include<stddef.h>
+#include<ucontext.h>
+
+// 汇编上下文只支持 x86-64 和 aarch64，其他平台总是使用 ucontext
+#if defined(__x86_64__) || defined(__aarch64__)
+#define GGO_ASM_CONTEXT_SUPPORTED 1
+#endif
+
+extern "C"{
+    /// @brief 保存当前寄存器到 *from_sp 指向的栈，并切换到 to_sp
+    /// @attention 只保存被调用者保存寄存器与浮点控制字，不涉及信号掩码
+    void ggo_context_swap(void** from_sp, void* to_sp);
+}
+
+namespace GGo{
+
+/// @brief 协程入口函数
+using ContextEntry = void(*)();
+
+/// @brief 基于 ucontext 的上下文
+/// @details glibc 的 swapcontext 每次切换都会调用 rt_sigprocmask 系统调用
+class UContext{
+public:
+    /// @brief 保存当前执行流（用于线程主协程）
+    void init();
+
+    /// @brief 在指定栈上创建新的执行流
+    /// @param stack 栈底指针
+    /// @param size 栈大小
+    /// @param entry 入口函数，不允许返回
+    void make(void* stack, size_t size, ContextEntry entry);
+
+    /// @brief 保存当前执行流到from，切换到to
+    static void swap(UContext& from, UContext& to);
+
+    /// @brief 切出时保存的栈指针，平台不支持时返回nullptr
+    void* stackPointer() const;
+
+private:
+    // ucontext 上下文
+    ucontext_t m_ctx;
+};
+
+#ifdef GGO_ASM_CONTEXT_SUPPORTED
+/// @brief 基于汇编的上下文
+/// @details 切换时只保存被调用者保存寄存器，全部在用户态完成
+class AsmContext{
+public:
+    /// @brief 保存当前执行流（用于线程主协程），首次切出时才真正写入
+    void init() { m_sp = nullptr; }
+
+    /// @brief 在指定栈上创建新的执行流
+    /// @param stack 栈底指针
+    /// @param size 栈大小
+    /// @param entry 入口函数，不允许返回
+    void make(void* stack, size_t size, ContextEntry entry);
+
+    /// @brief 保存当前执行流到from，切换到to
+    static void swap(AsmContext& from, AsmContext& to){
+        ggo_context_swap(&from.m_sp, to.m_sp);
+    }
+
+    /// @brief 切出时保存的栈指针，保存的寄存器就在它上方
+    void* stackPointer() const { return m_sp; }
+
+private:
+    // 保存的栈顶指针，寄存器都保存在栈上
+    void* m_sp = nullptr;
+};
+#endif
+
+/// @brief 协程使用的上下文实现，编译时通过 GGO_FIBER_ASM_CONTEXT 选择
+#if defined(GGO_FIBER_ASM_CONTEXT) && defined(GGO_ASM_CONTEXT_SUPPORTED)
+using FiberContext = AsmContext;
+#else
+using FiberContext = UContext;
+#endif
+
+/// @brief 当前编译使用的上下文实现名称
+const char* FiberContextName();
+
+}
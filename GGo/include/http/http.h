@@ -10,6 +10,7 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 #include <iostream>
@@ -472,6 +473,136 @@ private:
     MapType m_cookies;
 };
 
+/// @brief 零拷贝的HTTP请求
+/// @details 持有接收缓存，路径、参数、头部和消息体都是指向缓存的string_view，
+///          头部按出现顺序保存在平坦数组中，查找时忽略大小写逐个比较。
+///          需要修改或在缓存释放后继续使用时，用toRequest()转换为HTTPRequest
+class HTTPRequestView{
+public:
+    using ptr = std::shared_ptr<HTTPRequestView>;
+    using Header = std::pair<std::string_view, std::string_view>;
+    using HeaderList = std::vector<Header>;
+
+    /// @brief 构造函数
+    HTTPRequestView();
+
+    /// @brief 获取HTTP方法
+    HTTPMethod getMethod() const { return m_method; }
+
+    /// @brief 获取HTTP版本
+    uint8_t getVersion() const { return m_version; }
+
+    /// @brief 返回请求路径
+    std::string_view getPath() const { return m_path; }
+
+    /// @brief 返回请求参数
+    std::string_view getQuery() const { return m_query; }
+
+    /// @brief 返回请求fragment
+    std::string_view getFragment() const { return m_fragment; }
+
+    /// @brief 返回请求消息体
+    std::string_view getBody() const { return m_body; }
+
+    /// @brief 返回全部头部
+    const HeaderList& getHeaders() const { return m_headers; }
+
+    /// @brief 设置HTTP请求方法
+    void setMethod(HTTPMethod method) { m_method = method; }
+
+    /// @brief 设置HTTP请求版本
+    void setVersion(uint8_t version) { m_version = version; }
+
+    /// @brief 设置HTTP请求路径
+    void setPath(std::string_view path) { m_path = path; }
+
+    /// @brief 设置HTTP请求参数
+    void setQuery(std::string_view query) { m_query = query; }
+
+    /// @brief 设置HTTP请求的fragment
+    void setFragment(std::string_view fragment) { m_fragment = fragment; }
+
+    /// @brief 设置指向接收缓存的消息体
+    void setBody(std::string_view body) { m_body = body; }
+
+    /// @brief 设置接收缓存放不下的消息体，由请求自己保存
+    void setBody(std::string&& body);
+
+    /// @brief 保存接收缓存，保证所有string_view有效
+    void setBuffer(std::shared_ptr<char> buffer) { m_buffer = buffer; }
+
+    /// @brief 添加头部
+    /// @param key 键
+    /// @param value 值
+    void addHeader(std::string_view key, std::string_view value) { m_headers.emplace_back(key, value); }
+
+    /// @brief 获取HTTP请求的头部参数（忽略大小写）
+    /// @param key 键
+    /// @param def 默认值
+    /// @return 如果对应键存在则返回第一个对应值，不存在则返回默认值
+    std::string_view getHeader(std::string_view key, std::string_view def = std::string_view()) const;
+
+    /// @brief 判断HTTP请求的头部参数是否存在
+    /// @param key 键
+    /// @param val 如果键存在，val非空
+    /// @return 是否存在
+    bool hasHeader(std::string_view key, std::string_view* val = nullptr) const;
+
+    /// @brief 获取消息体长度
+    uint64_t getContentLength() const;
+
+    /// @brief 返回是否自动关闭
+    bool isAutoClose() const;
+
+    /// @brief 转换为拥有全部数据的HTTPRequest
+    std::shared_ptr<HTTPRequest> toRequest() const;
+private:
+    // HTTP方法
+    HTTPMethod m_method;
+    // HTTP版本 0x11 = 1.1
+    uint8_t m_version;
+    // 请求路径
+    std::string_view m_path;
+    // 请求参数
+    std::string_view m_query;
+    // 请求fragment
+    std::string_view m_fragment;
+    // 请求消息体
+    std::string_view m_body;
+    // 请求头部
+    HeaderList m_headers;
+    // 接收缓存
+    std::shared_ptr<char> m_buffer;
+    // 接收缓存放不下的消息体
+    std::string m_bodyStorage;
+};
+
+/// @brief 用sendfile从文件直接发送的响应消息体
+struct HTTPFileBody{
+    using ptr = std::shared_ptr<HTTPFileBody>;
+
+    /// @brief 构造函数
+    /// @param _fd 文件句柄
+    /// @param _offset 文件中的起始位置
+    /// @param _length 发送的长度
+    /// @param _owner 保证发送完之前句柄不被关闭的对象
+    HTTPFileBody(int _fd, uint64_t _offset, uint64_t _length, std::shared_ptr<void> _owner = nullptr)
+        :fd(_fd)
+        ,offset(_offset)
+        ,length(_length)
+        ,owner(_owner){
+    }
+
+    // 文件句柄
+    int fd;
+    // 起始位置
+    uint64_t offset;
+    // 长度
+    uint64_t length;
+    // 句柄的持有者
+    std::shared_ptr<void> owner;
+};
+
 /// @brief HTTP相应封装类
 class HTTPResponse{
 public:
@@ -507,6 +638,15 @@ public:
     /// @brief 设置响应消息体
     void setBody(const std::string& body) { m_body = body; }
 
+    /// @brief 设置响应消息体，接管body的内存不拷贝
+    void setBody(std::string&& body) { m_body = std::move(body); }
+
+    /// @brief 返回从文件发送的消息体
+    HTTPFileBody::ptr getFileBody() const { return m_fileBody; }
+
+    /// @brief 设置从文件发送的消息体，发送时代替m_body
+    void setFileBody(HTTPFileBody::ptr body) { m_fileBody = body; }
+
     /// @brief 设置响应原因 
     void setReasons(const std::string& reasons) { m_reasons = reasons; }
 
@@ -583,6 +723,12 @@ public:
     /// @brief 将响应体内容转换成字符串
     std::string toString() const;
 
+    /// @brief 把状态行和头部（包括结尾的空行）追加到buffer，不包括消息体
+    /// @details 发送时消息体作为单独的iovec直接从m_body写出，不拷贝。
+    ///          已经设置了content-length头部时（例如HEAD请求）不再按消息体生成
+    /// @param buffer 目标缓存，可以重复使用
+    void serializeHeader(std::string& buffer) const;
+
 private:
     // HTTP相应状态
     HTTPStatus m_status;
@@ -601,6 +747,8 @@ private:
     MapType m_headers;
     // cookies
     std::vector<std::string> m_cookies;
+    // 从文件发送的消息体
+    HTTPFileBody::ptr m_fileBody;
 };  
 
 /// @brief 流式输出HTTP请求内容
@@ -22,13 +22,16 @@ class HTTPRequestParser{
 public:
     using ptr = std::shared_ptr<HTTPRequestParser>;
 
-    /// @brief 无参构造函数
-    HTTPRequestParser();
+    /// @brief 构造函数
+    /// @param view 是否解析为指向接收缓存的HTTPRequestView，不拷贝字段
+    HTTPRequestParser(bool view = false);
 
     /// @brief 解析HTTP请求协议
     /// @param data 文本数据
     /// @param len 文本数据长度
     /// @return 实际解析的长度，并将已经解析的数据移除
+    /// @attention view模式下字段指向data，数据不会被移除。
+    ///            字段可能被读取的边界截断，所以每次都从头解析，data需要是目前收到的完整请求
     size_t excute(char* data, size_t len);
 
     /// @brief 返回是否解析完成
@@ -40,6 +43,9 @@ public:
     /// @brief 获取解析后的HTTP请求结构体
     HTTPRequest::ptr getData() const { return m_request; }
 
+    /// @brief 获取view模式下解析后的HTTP请求，非view模式返回nullptr
+    HTTPRequestView::ptr getView() const { return m_view; }
+
     /// @brief 设置错误
     /// @param error 错误码
     void setError(int error) { m_error = error; }
@@ -62,11 +68,15 @@ private:
     http_parser m_parser;
     // 请求结构体
     HTTPRequest::ptr m_request;
+    // view模式下的请求
+    HTTPRequestView::ptr m_view;
     //错误码
     // 1000 : invalid method
     // 1001 : invalid version
     // 1002 : invalid field
     int m_error;
+    // 是否为view模式
+    bool m_isView;
 };
 
 /// @brief HTTP响应解析类
@@ -26,13 +26,57 @@ public:
     /// @brief 接收HTTP请求
     HTTPRequest::ptr recvRequest();
 
+    /// @brief 接收HTTP请求，字段不拷贝，直接指向请求持有的接收缓存
+    /// @details 接收缓存属于连接，一次读入的多个请求依次从读指针处解析，不再读取也不拷贝
+    HTTPRequestView::ptr recvRequestView();
+
+    /// @brief 取出接收缓存中已经完整的下一个请求，不读取socket
+    /// @return 缓存中没有完整的请求时返回nullptr
+    HTTPRequest::ptr recvBufferedRequest();
+
+    /// @brief 取出接收缓存中已经完整的下一个请求，不读取socket
+    /// @return 缓存中没有完整的请求时返回nullptr
+    HTTPRequestView::ptr recvBufferedRequestView();
+
     /// @brief 发送HTTP响应
     /// @param response HTTP响应对象
     /// @return 
     ///         @retval >0 发送成功
     ///         @retval =0 对方关闭
     ///         @retval <0 发生异常
-    int sendResponse(HTTPResponse::ptr response);
+    int64_t sendResponse(HTTPResponse::ptr response);
+
+    /// @brief 用一次writev按顺序发送多个HTTP响应
+    /// @param responses HTTP响应对象
+    /// @return 同sendResponse
+    int64_t sendResponses(const std::vector<HTTPResponse::ptr>& responses);
+private:
+    /// @brief 从读指针处解析一个请求
+    /// @param block 数据不完整时是否读取socket，不读取时数据不完整或出错都返回nullptr且不移动读指针
+    HTTPRequestView::ptr parseRequest(bool block);
+
+    /// @brief 头部写入复用的缓存，消息体作为单独的iovec，一次writev发送
+    int64_t sendResponses(const HTTPResponse::ptr* responses, size_t count);
+
+    /// @brief 为继续读入腾出空间
+    /// @details 请求全部处理完时回到缓存开头；只有被缓存末尾截断的请求才移到开头。
+    ///          还有请求引用缓存时换一块新的缓存，不覆盖它们指向的数据
+    void compact();
+private:
+    // 连接的接收缓存
+    std::shared_ptr<char> m_buffer;
+    // 接收缓存大小
+    size_t m_bufferSize = 0;
+    // 下一个请求的起始位置
+    size_t m_readPos = 0;
+    // 已读入数据的结束位置
+    size_t m_writePos = 0;
+    // 响应头部的发送缓存
+    std::string m_headerBuffer;
+    // 发送用的iovec
+    std::vector<iovec> m_iovs;
+    // 每个响应头部在缓存中的结束位置
+    std::vector<size_t> m_headerEnds;
 };
 
 }
@@ -0,0 +1,83 @@
+/**
+ * @file staticFileServlet.h
+ * @author GGo
+ * @brief 静态文件服务
+ * @version 0.1
+ * @date 2024-03-22
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+#include <sys/stat.h>
+#include <atomic>
+#include <unordered_map>
+#include "http/servlet.h"
+#include "mutex.h"
+
+namespace GGo{
+namespace HTTP{
+
+/// @brief 把目录下的文件作为静态资源提供
+/// @details 文件内容用sendfile由内核直接写到socket，不经过用户空间。
+///          打开的句柄与stat结果会缓存cache_ms毫秒，过期后重新stat，文件变化时重新打开。
+///          支持GET/HEAD、单个区间的Range、If-Range、If-None-Match(ETag)与If-Modified-Since
+class StaticFileServlet : public servlet{
+public:
+    using ptr = std::shared_ptr<StaticFileServlet>;
+    using RWMutexType = RWMutex;
+
+    /// @brief 构造函数
+    /// @param root 文件根目录
+    /// @param prefix 请求路径中去掉的前缀，例如注册为"/static/*"时传"/static"
+    /// @param cache_ms 缓存的stat结果的有效时间(ms)
+    /// @param max_cached 最多缓存的文件数量，超过时清空缓存
+    StaticFileServlet(const std::string& root, const std::string& prefix = ""
+                    , uint64_t cache_ms = 1000, size_t max_cached = 1024);
+
+    virtual int32_t handle(GGo::HTTP::HTTPRequest::ptr request
+                        , GGo::HTTP::HTTPResponse::ptr response
+                        , GGo::HTTP::HTTPSession::ptr session) override;
+private:
+    /// @brief 缓存的文件
+    struct File{
+        using ptr = std::shared_ptr<File>;
+        ~File();
+
+        // 文件句柄
+        int fd = -1;
+        // 打开时的文件信息
+        struct stat st;
+        // 实体标签
+        std::string etag;
+        // 最后修改时间（HTTP日期格式）
+        std::string lastModified;
+        // 上次检查文件是否变化的时间
+        std::atomic<uint64_t> checked = {0};
+    };
+
+    /// @brief 获取文件，缓存过期时检查文件是否变化
+    /// @param path 文件的完整路径
+    /// @return 不存在或不是普通文件时返回nullptr
+    File::ptr getFile(const std::string& path);
+
+    /// @brief 把请求路径转换为文件路径
+    /// @return 路径不在根目录下时返回空串
+    std::string toFilePath(const std::string& uri) const;
+private:
+    // 文件根目录
+    std::string m_root;
+    // 去掉的请求路径前缀
+    std::string m_prefix;
+    // 缓存有效时间
+    uint64_t m_cacheMs;
+    // 最多缓存的文件数量
+    size_t m_maxCached;
+    // 文件缓存
+    std::unordered_map<std::string, File::ptr> m_files;
+    // 文件缓存锁
+    RWMutexType m_mutex;
+};
+
+}
+}
@@ -10,10 +10,14 @@
 #pragma once
 #include"scheduler.h"
 #include"timer.h"
+#include"fdTable.h"
 
+struct io_uring_sqe;
 
 namespace GGo{
 
+class IOUring;
+
 
 class IOScheduler : public Scheduler, public TimerManager{
 public:
@@ -33,7 +37,19 @@ public:
         WRITE = 0x4,
     };
 
+    /// @brief IO事件后端，由 io_scheduler.backend 在构造时选择
+    enum Backend
+    {
+        // epoll 就绪通知
+        EPOLL = 0,
+        // io_uring 完成通知，总是每个工作线程一个环
+        IO_URING = 1,
+    };
+
 private:
+    /// @brief io_uring中一次未完成的请求
+    struct UringRequest;
+
     /// @brief 文件句柄上下文
     struct FdContext
     {
@@ -49,6 +65,8 @@ private:
             Fiber::ptr fiber;
             // 事件回调函数
             std::function<void()> cb;
+            // io_uring后端下正在等待的请求
+            UringRequest* request = nullptr;
         };
 
         /// @brief 获取事件上下文
@@ -62,7 +80,9 @@ private:
 
         /// @brief 触发事件
         /// @param event 事件类型
-        void tiggerEvent(Event event);
+        /// @param home 句柄所在的调度器
+        /// @param thread 事件属于home时固定到该线程执行，-1表示任意线程
+        void tiggerEvent(Event event, Scheduler* home = nullptr, int thread = -1);
 
         // 读事件
         EventContext read;
@@ -76,6 +96,26 @@ private:
         mutexType m_mutex;
         
     };
+
+    /// @brief epoll实例及其句柄上下文表
+    /// @details 默认所有线程共享一个；开启 io_scheduler.per_thread_epoll 后每个工作线程各有一个
+    struct Poller
+    {
+        // epoll 文件句柄
+        int epfd = -1;
+        // 唤醒用的 eventfd
+        int tickleFd = -1;
+        // 是否已有尚未被处理的唤醒，用于合并重复的tickle
+        std::atomic<bool> tickled = {false};
+        // 拥有者线程是否正在epoll_wait中睡眠，只在每线程模式下使用
+        std::atomic<bool> sleeping = {false};
+        // socket事件上下文表，上下文在第一次使用时创建，之后不再释放
+        FdTable<std::atomic<FdContext*>> fdContexts;
+        // io_uring后端的环，epoll后端为空
+        std::unique_ptr<IOUring> uring;
+        // 保护uring的SQ，CQ只由拥有者线程消费
+        Mutex uringMutex;
+    };
     
 public:
     /// @brief IO协程调度器构造函数
@@ -112,37 +152,106 @@ public:
     bool cancelAll(int fd);
 
     static IOScheduler* getThis();
+
+    /// @brief 是否每个工作线程使用独立的epoll实例（或io_uring环）
+    bool isPerThreadPoller() const { return m_perThread; }
+
+    /// @brief 当前使用的IO事件后端
+    Backend getBackend() const { return m_backend; }
+
+    /// @brief 是否每个工作线程使用私有的定时器存储
+    bool isPerThreadTimer() const { return m_perThreadTimer; }
+
+    /// @brief 在io_uring后端上直接提交一次IO，挂起当前协程直到完成
+    /// @param fd socket句柄
+    /// @param event 操作对应的事件，cancelEvent/cancelAll按事件取消
+    /// @param sqe 已填写好的请求，user_data由调度器设置
+    /// @param timeout 超时时间(ms)，~0ull表示不超时，超时返回-1且errno为ETIMEDOUT
+    /// @return 与对应系统调用相同，失败返回-1并设置errno
+    /// @pre getBackend() == IO_URING，在本调度器的工作线程中调用
+    ssize_t submitIO(int fd, Event event, const io_uring_sqe& sqe, uint64_t timeout);
+
+    /// @brief 持续运行事件循环的线程ID（不含use_caller的调用线程）
+    /// @details 每线程模式下，固定在这些线程上的协程注册的句柄只会在本线程上就绪
+    std::vector<int> getPollerThreads() const;
 protected:
     /// @brief 通知有新任务
     void tickle() override;
 
+    /// @brief 唤醒指定线程，只有每线程模式下才能精确唤醒
+    void tickleThread(int thread) override;
+
     /// @brief 待机时函数
     void idle() override;
 
-    /// @brief 重置socket句柄上下文容器的大小
-    void contextResize(size_t size);
-
     /// @brief 判断是否可以停止
     bool canStopNow() override;
 
     void onTimerInsertedAtFront() override;
 
+    /// @brief 工作线程使用自己队列下标对应的定时器存储，use_caller的调用线程使用共享存储
+    int getTimerStore() const override;
+
+    /// @brief 唤醒定时器存储的拥有者线程处理消息
+    void onTimerMessage(size_t index) override;
+
     /// @brief 判断是否可以停止
     /// @post timeout = 最近要触发的定时器事件间隔
     /// @return 是否可以停止
     bool canStopNow(uint64_t& timeout);
 
 private:
-    // epoll 文件句柄
-    int m_epollFd = 0;
-    /// pipe 文件句柄
-    int m_tickleFds[2];
-    // 当前等待执行的任务数量
+    /// @brief 下标为index的poller是否属于当前线程
+    bool isOwner(size_t index) const { return m_perThread && (int)index == currentQueueIndex(); }
+
+    /// @brief 当前线程注册事件使用的poller下标
+    /// @details 共享模式总是0；每线程模式为当前线程的队列下标，
+    ///          非工作线程与use_caller的调用线程按fd取模分到工作线程的poller上
+    size_t localPollerIndex(int fd) const;
+
+    /// @brief 获取poller中fd的上下文
+    /// @param auto_create 句柄表不够大时是否扩容
+    /// @return 不存在或无法扩容时返回nullptr
+    FdContext* getFdContext(size_t index, int fd, bool auto_create);
+
+    /// @brief 唤醒在poller上睡眠的线程
+    /// @return 是否真正写入了eventfd
+    bool wakeup(Poller& poller);
+
+    /// @brief 保证poller的环上至少有count个空闲SQE并取得第一个，其余通过IOUring::getSqe依次取得
+    /// @details 链接的请求必须在同一次提交中，空间不够时先提交已准备好的SQE
+    /// @pre 持有poller.uringMutex
+    io_uring_sqe* getSqes(Poller& poller, uint32_t count);
+
+    /// @brief 在io_uring上监听fd的单次就绪（addEvent）
+    /// @return 没有可用的SQE时返回false
+    /// @pre 持有fd_ctx的锁
+    bool uringArm(size_t index, UringRequest* request, int fd, Event event);
+
+    /// @brief 在io_uring上取消fd_ctx上的event
+    /// @details 监听请求立即触发（trigger）或移除；直接IO要等内核返回结果后才恢复协程
+    /// @pre 持有fd_ctx的锁
+    void uringCancel(size_t index, FdContext* fd_ctx, Event event, bool trigger);
+
+    /// @brief 处理io_uring的完成事件
+    void uringComplete(Poller& poller, uint64_t user_data, int32_t res, uint32_t flags, int thread);
+
+    /// @brief 在poller的环上监听tickle用的eventfd
+    void uringArmTickle(Poller& poller);
+
+private:
+    // IO事件后端
+    Backend m_backend = EPOLL;
+    // 是否每个工作线程使用独立的epoll实例
+    bool m_perThread = false;
+    // 是否每个工作线程使用私有的定时器存储
+    bool m_perThreadTimer = false;
+    // epoll实例，共享模式只有一个，每线程模式下标与工作队列一致
+    std::vector<std::unique_ptr<Poller>> m_pollers;
+    // 正在epoll_wait中睡眠的线程数量
+    std::atomic<size_t> m_sleepingThreadCount = {0};
+    // 当前等待执行的任务数量，io_uring后端下为内核中尚未完成的请求数量
     std::atomic<size_t> m_pendingEventCount = {0};
-    // 读写锁
-    RWMutexType m_mutex;
-    // socket事件上下文容器
-    std::vector<FdContext *> m_fdContexts;
 };
 
 
@@ -0,0 +1,106 @@
+/**
+ * @file ioUring.h
+ * @author GGo
+ * @brief io_uring 环形队列封装
+ * @date 2024-03-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+#include<stdint.h>
+#include<stddef.h>
+#include<linux/io_uring.h>
+#include"nonCopyable.h"
+
+namespace GGo{
+
+/// @brief io_uring 实例
+/// @details 直接使用系统调用与mmap，不依赖liburing；
+///          本类不加锁：SQ由调用方加锁保护，CQ只能由一个线程消费
+class IOUring : nonCopyable{
+public:
+    /// @brief 构造函数
+    /// @param entries SQ容量，创建失败时isValid()返回false
+    explicit IOUring(uint32_t entries);
+
+    /// @brief 析构函数
+    ~IOUring();
+
+    /// @brief 是否创建成功
+    bool isValid() const { return m_fd >= 0; }
+
+    /// @brief 取得一个已清零的空闲SQE
+    /// @return SQ已满时返回nullptr，需要先submit
+    io_uring_sqe* getSqe();
+
+    /// @brief SQ中还可以准备的SQE数量
+    uint32_t space() const;
+
+    /// @brief 将已准备好的SQE发布给内核，不进入内核
+    void flush();
+
+    /// @brief 发布并提交已准备好的SQE，不等待
+    /// @return 提交的数量，失败返回-errno
+    int submit();
+
+    /// @brief 提交已发布的SQE并等待至少一个完成事件
+    /// @details 只读取已发布的SQ尾，调用时无需持有SQ的锁
+    /// @param timeout_ms 最长等待时间(ms)
+    /// @return 提交的数量，超时或被中断时返回-errno
+    int wait(uint64_t timeout_ms);
+
+    /// @brief 消费完成队列中的全部CQE
+    /// @param func 对每个CQE调用 func(const io_uring_cqe&)
+    /// @return 消费的数量
+    template<class Func>
+    size_t forEachCqe(Func func){
+        uint32_t head = *m_cqHead;
+        uint32_t tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        size_t count = 0;
+        while(head != tail){
+            func(m_cqes[head & m_cqMask]);
+            head++;
+            count++;
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    /// @brief 当前内核是否支持本模块需要的io_uring特性
+    static bool IsSupported();
+
+private:
+    /// @brief 创建一个实例并提交一次多次监听的POLL_ADD，检查内核是否支持
+    static bool Probe();
+
+    /// @brief 调用 io_uring_enter
+    int enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags, void* arg, size_t argsz);
+
+private:
+    // io_uring 文件句柄
+    int m_fd = -1;
+    // mmap 的SQ/CQ环
+    void* m_ringPtr = nullptr;
+    size_t m_ringSize = 0;
+    // mmap 的SQE数组
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+
+    // SQ 环字段
+    uint32_t* m_sqHead = nullptr;
+    uint32_t* m_sqTail = nullptr;
+    uint32_t* m_sqArray = nullptr;
+    uint32_t m_sqMask = 0;
+    uint32_t m_sqEntries = 0;
+    // 本地维护的SQ尾，submit时发布给内核
+    uint32_t m_sqeTail = 0;
+
+    // CQ 环字段
+    uint32_t* m_cqHead = nullptr;
+    uint32_t* m_cqTail = nullptr;
+    io_uring_cqe* m_cqes = nullptr;
+    uint32_t m_cqMask = 0;
+};
+
+}
@@ -0,0 +1,130 @@
+/**
+ * @file lockFreeQueue.h
+ * @author GGo
+ * @brief 有界无锁队列
+ * @date 2024-03-02
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+#include<atomic>
+#include<memory>
+#include<stddef.h>
+#include<stdint.h>
+#include"nonCopyable.h"
+
+namespace GGo{
+
+/// @brief 有界多生产者无锁队列
+/// @details 基于每个槽位的序号实现（Dmitry Vyukov的有界队列），
+///          槽位在构造时一次性分配，入队只需一次CAS，不再申请内存；
+///          出队同样是无锁的，允许多个消费者并发出队
+/// @tparam T 元素类型，需要默认构造与移动赋值
+template<class T>
+class LockFreeQueue : nonCopyable{
+public:
+    /// @brief 构造函数
+    /// @param capacity 队列容量，向上取整到2的幂
+    explicit LockFreeQueue(size_t capacity = 1024){
+        size_t size = 2;
+        while(size < capacity){
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for(size_t i = 0; i < size; i++){
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    /// @brief 入队
+    /// @return 队列已满时返回false，元素保持不变
+    bool push(T& value){
+        Cell* cell = nullptr;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while(true){
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if(diff == 0){
+                if(m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }else if(diff < 0){
+                // 槽位还没有被消费，队列已满
+                return false;
+            }else{
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief 出队
+    /// @return 队列为空时返回false
+    bool pop(T& value){
+        Cell* cell = nullptr;
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        while(true){
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if(diff == 0){
+                if(m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }else if(diff < 0){
+                // 槽位还没有被写入，队列为空
+                return false;
+            }else{
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        // 释放槽位中残留的资源，避免对象生命周期被队列延长
+        cell->data = T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief 队列是否为空（近似值，并发时仅供参考）
+    bool empty() const {
+        return m_enqueuePos.load(std::memory_order_acquire)
+                == m_dequeuePos.load(std::memory_order_acquire);
+    }
+
+    /// @brief 队列中的元素数量（近似值，并发时仅供参考）
+    size_t size() const {
+        size_t tail = m_enqueuePos.load(std::memory_order_acquire);
+        size_t head = m_dequeuePos.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    /// @brief 队列容量
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    /// @brief 队列槽位
+    struct Cell{
+        // 槽位序号
+        std::atomic<size_t> sequence;
+        // 元素
+        T data;
+    };
+
+    // 槽位数组
+    std::unique_ptr<Cell[]> m_cells;
+    // 下标掩码
+    size_t m_mask = 0;
+    // 入队位置，与出队位置分属不同缓存行
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    // 出队位置
+    alignas(64) std::atomic<size_t> m_dequeuePos;
+};
+
+}
@@ -17,6 +17,11 @@
 #include<fstream>
 #include<functional>
 #include<cstdarg>
+#include<atomic>
+#include<string_view>
+#include<type_traits>
+#include<unordered_map>
+#include<sys/uio.h>
 #include"singleton.h"
 #include"thread.h"
 #include"util.h"
@@ -35,14 +40,39 @@
 #define GGO_LOG_NAME(name) GGo::LoggerMgr::GetInstance()->getLogger(name)
 
 /**
- * @brief 使用流式方式将日志级别level的日志写入到logger
+ * @brief 编译期的最低日志级别，低于它的日志语句被整个去掉
+ * @details 数值同LogLevel，例如 -DGGO_LOG_MIN_LEVEL=2 去掉所有DEBUG日志；
+ *          被去掉的语句仍会做语法检查，但参数不会求值
+ */
+#ifndef GGO_LOG_MIN_LEVEL
+#define GGO_LOG_MIN_LEVEL 0
+#endif
+
+/**
+ * @brief 构造日志级别level的日志事件包装器，包装器析构时写入logger
+ * @details 每个调用点缓存日志器当前能输出的最低级别，关闭的日志只需一次relaxed读，
+ *          日志器级别或目标改变时缓存失效
  */
-#define GGO_LOG_LEVEL(logger, level)                                                                                       	\
-	if (logger->getLevel() <= level)                                                                                       	\
-	GGo::LogEventWrap(GGo::LogEvent::ptr(new GGo::LogEvent(logger, level,                                                	\
+#define GGO_LOG_EVENT(logger, level)                                                                                       	\
+	if ((int)(level) < GGO_LOG_MIN_LEVEL) {}                                                                           	\
+	else if (GGo::LogSite& ggo_log_site = []() -> GGo::LogSite& { static GGo::LogSite s_site; return s_site; }();    	\
+			!GGo::LogSite::Enabled(ggo_log_site, logger, level)) {}                                                  	\
+	else GGo::LogEventWrap(GGo::LogEvent::Acquire(logger, level,                                                             	\
 																 __FILE__, __LINE__, 0, GGo::GetThreadID(),              	\
-																 GGo::GetFiberID(), time(0), GGo::Thread::GetThisName())))  \
-		.getSS()
+																 GGo::GetFiberID(), GGo::now(GGo::COARSE) / 1000, GGo::Thread::GetThisName(), \
+																 ggo_log_site.getId()))
+
+/**
+ * @brief 使用流式方式将日志级别level的日志写入到logger
+ */
+#define GGO_LOG_LEVEL(logger, level) GGO_LOG_EVENT(logger, level).getSS()
+
+/**
+ * @brief 使用格式串将日志级别level的日志写入到logger
+ * @details 格式串中的{}依次替换为参数，参数按原始类型保存在事件中，
+ *          文本输出时才格式化，二进制输出（BinaryLogAppender）直接写入原始值
+ */
+#define GGO_LOG_FMT_LEVEL(logger, level, fmt, ...) GGO_LOG_EVENT(logger, level).getEvent()->setFormat(fmt, ##__VA_ARGS__)
 
 /**
  * @brief 以流式方式写入不同级别的日志
@@ -54,13 +84,23 @@
 #define GGO_LOG_ERROR(logger) GGO_LOG_LEVEL(logger,GGo::LogLevel::ERROR)
 #define GGO_LOG_FATAL(logger) GGO_LOG_LEVEL(logger,GGo::LogLevel::FATAL)
 
+/**
+ * @brief 以格式串方式写入不同级别的日志
+ * 
+ */
+#define GGO_LOG_FMT_DEBUG(logger, fmt, ...) GGO_LOG_FMT_LEVEL(logger, GGo::LogLevel::DEBUG, fmt, ##__VA_ARGS__)
+#define GGO_LOG_FMT_INFO(logger, fmt, ...) GGO_LOG_FMT_LEVEL(logger, GGo::LogLevel::INFO, fmt, ##__VA_ARGS__)
+#define GGO_LOG_FMT_WARN(logger, fmt, ...) GGO_LOG_FMT_LEVEL(logger, GGo::LogLevel::WARN, fmt, ##__VA_ARGS__)
+#define GGO_LOG_FMT_ERROR(logger, fmt, ...) GGO_LOG_FMT_LEVEL(logger, GGo::LogLevel::ERROR, fmt, ##__VA_ARGS__)
+#define GGO_LOG_FMT_FATAL(logger, fmt, ...) GGO_LOG_FMT_LEVEL(logger, GGo::LogLevel::FATAL, fmt, ##__VA_ARGS__)
+
 
-// TODO::日志输出没有做异步IO
 namespace GGo {
 
 
 class Logger;
 class LoggerManager;
+class ByteArray;
 //日志级别
 enum class LogLevel {
 	//UNKNOWN等级
@@ -77,8 +117,82 @@ enum class LogLevel {
 	FATAL = 5
 };
 
+/**
+ * @brief 日志调用点缓存
+ * @details 每个GGO_LOG_*调用点一个静态实例，缓存上次使用的日志器地址与它能输出的最低级别，
+ *          二者打包在一个原子变量里（日志器地址按8字节对齐，低3位存级别）。
+ *          日志器级别或目标改变时所有调用点的缓存清零，下次使用时重新计算
+ */
+class LogSite {
+public:
+	constexpr LogSite() = default;
+
+	/// @brief 调用点上的日志是否会被输出
+	/// @param site 调用点缓存
+	/// @param logger 日志器
+	/// @param level 日志级别
+	static bool Enabled(LogSite& site, const std::shared_ptr<Logger>& logger, LogLevel level){
+		uintptr_t state = site.m_state.load(std::memory_order_relaxed);
+		if((state & ~LEVEL_MASK) == (uintptr_t)logger.get()){
+			return (uintptr_t)level >= (state & LEVEL_MASK);
+		}
+		return site.update(logger, level);
+	}
+
+	/// @brief 清除所有调用点的缓存，日志器配置改变时调用
+	static void InvalidateAll();
+
+	/// @brief 返回调用点编号，第一次使用时分配，进程内唯一，0表示还没有分配
+	uint32_t getId() const { return m_id.load(std::memory_order_relaxed); }
+
+private:
+	/// @brief 重新计算缓存，第一次使用时登记调用点
+	bool update(const std::shared_ptr<Logger>& logger, LogLevel level);
+
+private:
+	// 低3位保存级别
+	static constexpr uintptr_t LEVEL_MASK = 7;
+	// 日志器地址 | 能输出的最低级别，0表示无效
+	std::atomic<uintptr_t> m_state = {0};
+	// 是否已经登记
+	std::atomic<bool> m_registered = {false};
+	// 调用点编号
+	std::atomic<uint32_t> m_id = {0};
+	// 登记链表的下一个调用点
+	LogSite* m_next = nullptr;
+};
+
 
 
+/**
+ * @brief 日志内容流
+ * @details 内容写入一个字符串，清空时保留容量，复用时不再分配内存
+ */
+class LogStream : public std::ostream {
+public:
+	LogStream()
+		:std::ostream(&m_buf){
+	}
+
+	/// @brief 返回已写入的内容
+	const std::string& str() const { return m_buf.m_str; }
+
+	/// @brief 清空内容，并恢复默认的格式标志
+	void reset();
+
+private:
+	/// @brief 追加到字符串的流缓冲
+	class StringBuf : public std::streambuf {
+	public:
+		std::string m_str;
+	protected:
+		int_type overflow(int_type ch) override;
+		std::streamsize xsputn(const char* s, std::streamsize n) override;
+	};
+
+	StringBuf m_buf;
+};
+
 /**
  * @brief 日志事件
  * 
@@ -103,6 +217,35 @@ public:
 		, uint32_t fiber_id, uint64_t time
 		, const std::string& thread_name);
 
+	/// @brief 按原始类型保存的参数
+	struct Arg{
+		enum Type : uint8_t{
+			INT = 0,
+			UINT = 1,
+			DOUBLE = 2,
+			STRING = 3
+		};
+		Type type;
+		union{
+			int64_t i;
+			uint64_t u;
+			double d;
+		};
+		// STRING类型的内容在参数区中的位置与长度
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	/// @brief 取得一个日志事件，参数同构造函数
+	/// @details 每个线程缓存一个事件，没有其他地方持有时重置后复用，
+	///          避免每条日志都分配事件和内容流
+	/// @param site_id 调用点编号，0表示不是从日志宏写入的
+	static LogEvent::ptr Acquire(std::shared_ptr<Logger> logger, LogLevel level
+		, const char* file, int32_t line
+		, uint32_t elapse, uint32_t thread_id
+		, uint32_t fiber_id, uint64_t time
+		, const std::string& thread_name, uint32_t site_id = 0);
+
 	
 	/// @brief 得到文件名
 	const char* getFile()const { return m_file; }
@@ -125,8 +268,25 @@ public:
 	/// @brief 得到线程名 
 	const std::string& getThreadName()const { return m_threadName; }
 
-	/// @brief 得到日志内容 
-	std::string getContent()const { return m_ss.str(); }
+	/// @brief 得到日志内容，设置了格式串时在第一次调用时格式化
+	const std::string& getContent()const {
+		if(m_fmt && !m_rendered){
+			render();
+		}
+		return m_ss.str();
+	}
+
+	/// @brief 得到调用点编号
+	uint32_t getSiteId() const { return m_siteId; }
+
+	/// @brief 得到格式串，没有设置时返回nullptr
+	const char* getFormat() const { return m_fmt; }
+
+	/// @brief 得到按原始类型保存的参数
+	const std::vector<Arg>& getArgs() const { return m_args; }
+
+	/// @brief 得到STRING类型参数的内容
+	std::string_view getArgString(const Arg& arg) const { return std::string_view(m_argData.data() + arg.offset, arg.length); }
 
 	/// @brief 得到主日志器 
 	std::shared_ptr<Logger> getLogger() const { return m_logger; }
@@ -135,12 +295,62 @@ public:
 	LogLevel getLevel()const { return m_level; }
 	
 	//得到日志内容字符串流
-	std::stringstream& getSS() { return m_ss; }
+	std::ostream& getSS() { return m_ss; }
 
 	//格式化写入日志内容
 	void format(const char* fmt, ...);
 	void format(const char* fmt, va_list al);
 
+	/// @brief 设置格式串与参数，格式串中的{}依次替换为参数，多出的参数以空格分隔追加在末尾
+	/// @details 参数按原始类型保存，需要文本时才格式化；fmt在事件使用期间需要有效，一般是字符串字面量
+	template<class... Args>
+	void setFormat(const char* fmt, const Args&... args){
+		m_fmt = fmt;
+		(addArg(args), ...);
+	}
+
+	/// @brief 追加一个参数，整数、浮点数和字符串保存原始值，其他类型先用operator<<转成字符串
+	template<class T>
+	void addArg(const T& val){
+		using U = std::decay_t<T>;
+		if constexpr(std::is_same_v<U, bool>){
+			addUint(val);
+		}else if constexpr(std::is_same_v<U, char>){
+			addString(&val, 1);
+		}else if constexpr(std::is_integral_v<U> && std::is_signed_v<U>){
+			addInt(val);
+		}else if constexpr(std::is_integral_v<U>){
+			addUint(val);
+		}else if constexpr(std::is_floating_point_v<U>){
+			addDouble(val);
+		}else if constexpr(std::is_convertible_v<const T&, std::string_view>){
+			std::string_view str = val;
+			addString(str.data(), str.size());
+		}else{
+			std::ostringstream ss;
+			ss << val;
+			const std::string& str = ss.str();
+			addString(str.data(), str.size());
+		}
+	}
+
+	/// @brief 追加各种类型的参数
+	void addInt(int64_t val);
+	void addUint(uint64_t val);
+	void addDouble(double val);
+	void addString(const char* str, size_t len);
+
+private:
+	/// @brief 复用事件时重新设置内容，参数同构造函数
+	void reset(std::shared_ptr<Logger> logger, LogLevel level
+		, const char* file, int32_t line
+		, uint32_t elapse, uint32_t thread_id
+		, uint32_t fiber_id, uint64_t time
+		, const std::string& thread_name, uint32_t site_id);
+
+	/// @brief 按格式串和参数生成日志内容
+	void render() const;
+
 private:
 	//文件名
 	const char* m_file = nullptr;
@@ -156,12 +366,22 @@ private:
 	uint64_t m_time = 0;
 	//线程名
 	std::string m_threadName;
-	//日志内容流
-	std::stringstream m_ss;
+	//日志内容流，设置了格式串时在取内容时才写入
+	mutable LogStream m_ss;
 	//主日志器
 	std::shared_ptr<Logger> m_logger;
 	//日志等级
 	LogLevel m_level;
+	//调用点编号
+	uint32_t m_siteId = 0;
+	//格式串
+	const char* m_fmt = nullptr;
+	//按原始类型保存的参数
+	std::vector<Arg> m_args;
+	//STRING类型参数的内容
+	std::string m_argData;
+	//格式串是否已经写入内容流
+	mutable bool m_rendered = false;
 
 
 };
@@ -184,7 +404,7 @@ public:
 	LogEvent::ptr getEvent() const {return m_event;}
 
 	/// @brief 获取日志内容字符串流
-	std::stringstream& getSS();
+	std::ostream& getSS();
 
 private:
 	LogEvent::ptr m_event;
@@ -225,6 +445,12 @@ public:
 	std::string format(std::shared_ptr<Logger> logger,LogLevel level,LogEvent::ptr event);
 	std::ostream& format(std::ostream& ofs,std::shared_ptr<Logger> logger,LogLevel level,LogEvent::ptr event);
 
+	/// @brief 按预先解析的片段直接格式化到定长缓冲区，不经过流，也不分配内存
+	/// @param buf 缓冲区
+	/// @param size 缓冲区大小
+	/// @return 完整日志的长度，大于size时缓冲区中只有前size个字节
+	size_t format(char* buf, size_t size, std::shared_ptr<Logger> logger, LogLevel level, const LogEvent& event);
+
 public:
 	/// @brief 日志内容格式化单位
 	class FormatItem {
@@ -255,10 +481,22 @@ public:
 
 
 private:
+	/// @brief 快速格式化使用的片段
+	struct Segment{
+		// 格式字符，0表示原样输出的文本
+		char type;
+		// 原样输出的文本，或%d的时间格式
+		std::string text;
+	};
+
 	//日志格式模板
 	std::string m_pattern;
 	//日志解析后格式
 	std::vector<FormatItem::ptr> m_items;
+	//与m_items一一对应的片段
+	std::vector<Segment> m_segments;
+	//实例编号，用来区分线程缓存的时间字符串
+	uint64_t m_id;
 	//是否有错误
 	bool m_error = false;
 	
@@ -361,7 +599,11 @@ public:
 	LogLevel getLevel()const { return m_level; }
 
 	/// @brief 设置日志级别
-	void setLevel(LogLevel val) { m_level = val; }
+	void setLevel(LogLevel val);
+
+	/// @brief 返回实际能输出的最低级别，没有目标时取决于root日志器
+	/// @return 不会输出任何日志时返回FATAL+1
+	int getEffectiveLevel();
 
 	/// @brief 返回日志器名称
 	const std::string& getNanme() const { return m_name; }
@@ -385,8 +627,8 @@ private:
 	std::string m_name;
 	//日志级别
 	LogLevel m_level;
-	//日志目标集合
-	std::list<LogAppender::ptr> m_appenders;
+	//日志目标集合，修改时整体替换，写日志时只在锁内复制指针
+	std::shared_ptr<const std::list<LogAppender::ptr>> m_appenders;
 	//日志格式器
 	LogFormatter::ptr m_formatter;
 	//主日志器
@@ -433,6 +675,361 @@ private:
 	uint64_t m_lastTime = 0;
 };
 
+/// @brief 异步输出到文件的Appender
+/// @details 每个写日志的线程独占一个环形缓冲区（单生产者单消费者，无锁），调用线程只做格式化和拷贝；
+///          后台线程每隔flush_interval毫秒，或有缓冲区用量过半时，把所有缓冲区的内容用一次writev写入文件，
+///          后台线程读取已写入的部分的同时，调用线程继续写空闲部分，相当于双缓冲
+class AsyncFileLogAppender :public LogAppender {
+public:
+	using ptr = std::shared_ptr<AsyncFileLogAppender>;
+
+	/// @brief 缓冲区写满时的处理策略
+	enum Policy
+	{
+		// 丢弃并计数，后台线程在文件中记录丢弃的数量
+		DROP = 0,
+		// 等待后台线程腾出空间
+		BLOCK = 1,
+	};
+
+	/**
+	 * @brief 构造函数
+	 * 
+	 * @param filename 文件名
+	 * @param buffer_size 每个线程的缓冲区大小（字节），超过它的单条日志会被丢弃
+	 * @param flush_interval 后台线程写文件的间隔（毫秒）
+	 * @param policy 缓冲区写满时的处理策略
+	 */
+	AsyncFileLogAppender(const std::string& filename, size_t buffer_size = 256 * 1024
+						, uint64_t flush_interval = 1000, Policy policy = DROP);
+
+	/// @brief 析构函数，写完所有缓冲的日志后停止后台线程
+	~AsyncFileLogAppender();
+
+	void log(Logger::ptr logger,LogLevel level,LogEvent::ptr event) override;
+
+	std::string toYamlString() override;
+
+	/// @brief 等待调用前已进入缓冲区的日志全部写入文件
+	void flush();
+
+	/// @brief 返回因缓冲区写满而丢弃的日志数量
+	uint64_t getDropped() const { return m_dropped; }
+
+	/// @brief 返回缓冲区写满时的处理策略
+	Policy getPolicy() const { return m_policy; }
+
+	/// @brief 返回当前的线程缓冲区数量，线程退出且缓冲区写完后释放
+	size_t getBufferCount();
+
+	/// @brief 返回所有实例当前占用内存的缓冲区数量，实例析构后它的缓冲区立即释放
+	static size_t GetLiveBufferCount();
+
+	/// @brief 将策略文本（drop/block）转成策略，无法识别时返回DROP
+	static Policy PolicyFromString(const std::string& str);
+
+	/// @brief 将策略转成文本
+	static const char* PolicyToString(Policy policy);
+
+private:
+	/// @brief 单个线程的环形缓冲区
+	struct Buffer;
+
+	/// @brief 线程持有的各个实例的缓冲区
+	struct ThreadBuffers;
+
+	/// @brief 取得当前线程的缓冲区，第一次调用时创建
+	Buffer* getBuffer();
+
+	/// @brief 唤醒后台线程，已经唤醒过且后台线程还没处理时不再重复通知
+	void wakeup();
+
+	/// @brief 后台线程
+	void run();
+
+	/// @brief 把所有缓冲区当前的内容写入文件
+	void writeOut();
+
+	/// @brief 重新打开日志文件
+	bool reopen();
+private:
+	//文件路径
+	std::string m_filename;
+	//文件句柄，只由后台线程使用
+	int m_fd = -1;
+	//上次打开时间
+	uint64_t m_lastTime = 0;
+	//每个线程的缓冲区大小
+	size_t m_bufferSize;
+	//写文件的间隔
+	uint64_t m_flushInterval;
+	//缓冲区写满时的处理策略
+	Policy m_policy;
+	//实例槽位，线程缓存缓冲区时用来区分实例，实例析构后复用
+	uint64_t m_id;
+	//所有线程的缓冲区，线程退出后由后台线程写完剩余内容再移除
+	std::vector<std::shared_ptr<Buffer>> m_buffers;
+	//线程缓存已经析构的线程（例如线程退出时在其他析构函数中写日志）使用的缓冲区
+	std::map<pid_t, std::shared_ptr<Buffer>> m_lateBuffers;
+	//保护m_buffers与m_lateBuffers
+	Mutex m_buffersMutex;
+	//唤醒后台线程
+	Semaphore m_wakeup;
+	//是否已经通知过后台线程
+	std::atomic<bool> m_notified = {false};
+	//是否停止
+	std::atomic<bool> m_stopping = {false};
+	//丢弃的日志数量
+	std::atomic<uint64_t> m_dropped = {0};
+	//已经写入文件中的丢弃数量
+	uint64_t m_droppedReported = 0;
+	//请求刷新的次数
+	std::atomic<uint64_t> m_flushRequest = {0};
+	//已经完成的刷新请求
+	std::atomic<uint64_t> m_flushDone = {0};
+	//等待后台线程写完一轮的线程数量
+	std::atomic<int> m_waiters = {0};
+	//后台线程写完一轮后通知等待者
+	Semaphore m_written;
+	//后台线程
+	Thread::ptr m_thread;
+};
+
+/// @brief 写入内存映射分段文件的Appender
+/// @details 日志写入固定数量的分段文件filename.0 ~ filename.(segment_count - 1)，循环使用。
+///          每个分段预先分配segment_size字节并映射到内存，写日志只是在锁内预留位置，再在锁外memcpy；
+///          后台线程提前准备好下一个分段（会清空其中最旧的日志），当前分段写满时只需换一个指针，
+///          换下的分段也由后台线程截断到实际长度并关闭。
+///          数据写入映射内存后即使进程崩溃也会落盘，崩溃留下的分段末尾是0，重新打开时跳过；
+///          sync_interval大于0时后台线程按该间隔msync，防止机器掉电丢失
+class MmapFileLogAppender :public LogAppender {
+public:
+	using ptr = std::shared_ptr<MmapFileLogAppender>;
+
+	/**
+	 * @brief 构造函数，从最近修改过的分段接着写
+	 * 
+	 * @param filename 文件名，分段文件名为filename.序号
+	 * @param segment_size 分段大小（字节），超过它的单条日志会被丢弃
+	 * @param segment_count 分段数量，至少为2
+	 * @param sync_interval 后台线程msync的间隔（毫秒），0表示不主动同步
+	 */
+	MmapFileLogAppender(const std::string& filename, size_t segment_size = 64 * 1024 * 1024
+						, uint32_t segment_count = 8, uint64_t sync_interval = 0);
+
+	/// @brief 析构函数，停止后台线程并截断当前分段
+	~MmapFileLogAppender();
+
+	void log(Logger::ptr logger,LogLevel level,LogEvent::ptr event) override;
+
+	std::string toYamlString() override;
+
+	/// @brief 把当前分段已写入的内容同步到磁盘
+	void flush();
+
+	/// @brief 返回序号为index的分段文件名
+	std::string getSegmentName(uint32_t index) const;
+
+	/// @brief 返回正在写入的分段序号
+	uint32_t getCurrentIndex();
+
+	/// @brief 返回丢弃的日志数量
+	uint64_t getDropped() const { return m_dropped; }
+
+private:
+	/// @brief 一个映射到内存的分段
+	struct Segment;
+
+	/// @brief 打开并映射分段
+	/// @param resume 是否接着文件中已有的内容写，否则清空
+	/// @return 失败或无法接着写时返回nullptr
+	std::shared_ptr<Segment> openSegment(uint32_t index, bool resume);
+
+	/// @brief 准备下一个分段，已经准备好时直接返回
+	/// @return 创建分段失败时返回false
+	bool prepare();
+
+	/// @brief 换到已经准备好的下一个分段，需要持有m_mutex
+	void rotateLocked();
+
+	/// @brief 后台线程
+	void run();
+
+	/// @brief 当前分段文件被外部移走或删除时换到下一个分段
+	void checkMoved();
+
+	/// @brief 同步当前分段
+	/// @param all 是否从头同步
+	void sync(bool all);
+private:
+	//文件路径
+	std::string m_filename;
+	//分段大小
+	size_t m_segmentSize;
+	//分段数量
+	uint32_t m_segmentCount;
+	//同步间隔
+	uint64_t m_syncInterval;
+	//正在写入的分段
+	std::shared_ptr<Segment> m_current;
+	//准备好的下一个分段
+	std::shared_ptr<Segment> m_next;
+	//换下来还可能有线程在写的分段，由后台线程关闭
+	std::vector<std::shared_ptr<Segment>> m_retired;
+	//保证同时只有一个线程在准备下一个分段
+	Mutex m_prepareMutex;
+	//唤醒后台线程
+	Semaphore m_wakeup;
+	//是否停止
+	std::atomic<bool> m_stopping = {false};
+	//丢弃的日志数量
+	std::atomic<uint64_t> m_dropped = {0};
+	//后台线程
+	Thread::ptr m_thread;
+};
+
+/// @brief 以二进制记录输出到文件的Appender
+/// @details 不做文本格式化，每条日志只写调用点编号、时间、线程与协程ID和参数的原始值，整数用ByteArray的变长编码。
+///          调用点的文件名、行号和格式串，线程名，日志器名称在文件中第一次出现时各写一条定义记录，之后只引用编号；
+///          流式写入的日志内容作为一个字符串参数。用BinaryLogReader或BinaryLogDecoder工具还原成文本。
+///          文件格式：8字节文件头"GGOBLOG\1"，之后是记录，每条记录以Uint32的类型开头：
+///          SITE   Uint32调用点编号 String文件名 Int32行号 String格式串
+///          THREAD Uint32线程ID String线程名
+///          LOGGER Uint32日志器编号 String名称
+///          EVENT  Uint32调用点编号（为0时紧跟String文件名 Int32行号 String格式串） Fixeduint8级别 Uint32日志器编号
+///                 Uint64时间 Uint32累计毫秒 Uint32线程ID Uint32协程ID Uint32参数个数 参数（Fixeduint8类型 + 值）
+///          buffer_size大于0时由后台线程每隔flush_interval毫秒写出缓冲区，
+///          没有新日志时缓冲的内容也最多停留flush_interval毫秒
+class BinaryLogAppender :public LogAppender {
+public:
+	using ptr = std::shared_ptr<BinaryLogAppender>;
+
+	/// @brief 记录类型
+	enum RecordType
+	{
+		SITE = 1,
+		THREAD = 2,
+		LOGGER = 3,
+		EVENT = 4
+	};
+
+	/// @brief 文件头
+	static constexpr char MAGIC[] = "GGOBLOG\1";
+	static constexpr size_t MAGIC_SIZE = 8;
+
+	/**
+	 * @brief 构造函数
+	 * 
+	 * @param filename 文件名
+	 * @param buffer_size 缓冲的字节数，0表示每条日志直接写文件；
+	 *        大于0时缓冲区满、时间进入下一秒、ERROR以上的日志、flush和析构时写文件
+	 * @param flush_interval buffer_size大于0时后台线程写文件的间隔（毫秒）
+	 */
+	BinaryLogAppender(const std::string& filename, size_t buffer_size = 0, uint64_t flush_interval = 1000);
+
+	/// @brief 析构函数，停止后台线程并写出缓冲的日志
+	~BinaryLogAppender();
+
+	void log(Logger::ptr logger,LogLevel level,LogEvent::ptr event) override;
+
+	std::string toYamlString() override;
+
+	/// @brief 把缓冲的日志写入文件
+	void flush();
+
+	/// @brief 重新打开日志文件，文件已被移走或删除时创建新文件并重新写定义记录
+	/// @return 成功返回true
+	bool reopen();
+
+private:
+	/// @brief 写出缓冲区，需要持有m_writeMutex
+	void writeOut();
+
+	/// @brief 打开文件，需要持有m_writeMutex
+	bool reopenLocked();
+
+	/// @brief 后台线程，定时写出缓冲区
+	void run();
+
+private:
+	//文件路径
+	std::string m_filename;
+	//文件句柄
+	int m_fd = -1;
+	//上次检查文件的时间
+	uint64_t m_lastTime = 0;
+	//上次写文件的时间
+	uint64_t m_flushTime = 0;
+	//缓冲的字节数
+	size_t m_bufferSize;
+	//后台线程写文件的间隔
+	uint64_t m_flushInterval;
+	//编码缓冲区
+	std::unique_ptr<ByteArray> m_buffer;
+	//写文件用的iovec，复用避免分配
+	std::vector<struct iovec> m_iovs;
+	//调用点编号到当前文件中定义的格式串，nullptr表示还没有定义
+	std::vector<const char*> m_sites;
+	//当前文件中定义过的线程名
+	std::unordered_map<uint32_t, std::string> m_threads;
+	//当前文件中定义过的日志器编号
+	std::unordered_map<std::string, uint32_t> m_loggers;
+	//保护以上所有状态，编码和写文件都在锁内
+	Mutex m_writeMutex;
+	//唤醒后台线程
+	Semaphore m_wakeup;
+	//是否停止
+	std::atomic<bool> m_stopping = {false};
+	//后台线程，buffer_size为0时不创建
+	Thread::ptr m_thread;
+};
+
+/// @brief 读取BinaryLogAppender输出的文件，还原成日志事件
+class BinaryLogReader {
+public:
+	/// @brief 构造函数
+	BinaryLogReader();
+
+	/// @brief 析构函数
+	~BinaryLogReader();
+
+	/// @brief 读入整个文件
+	/// @return 文件不存在或文件头不对时返回false
+	bool open(const std::string& filename);
+
+	/// @brief 读取下一条日志
+	/// @return 没有更多日志或遇到损坏、截断的记录时返回nullptr；返回的事件在下次调用前有效
+	LogEvent::ptr next();
+
+	/// @brief 是否遇到了损坏或截断的记录
+	bool hasError() const { return m_error; }
+
+private:
+	/// @brief 调用点定义
+	struct Site{
+		std::string file;
+		int32_t line = 0;
+		std::string fmt;
+	};
+
+	/// @brief 读取一条日志记录的内容
+	LogEvent::ptr readEvent();
+
+private:
+	//文件内容
+	std::unique_ptr<ByteArray> m_data;
+	//调用点定义
+	std::unordered_map<uint32_t, Site> m_sites;
+	//线程名
+	std::unordered_map<uint32_t, std::string> m_threads;
+	//日志器，只用来提供名称
+	std::unordered_map<uint32_t, Logger::ptr> m_loggers;
+	//没有编号的调用点
+	Site m_inline;
+	//是否遇到了损坏或截断的记录
+	bool m_error = false;
+};
+
 
 
 /// @brief 日志管理器类
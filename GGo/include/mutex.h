@@ -31,6 +31,10 @@ public:
     /// @brief 获取信号量
     void wait();
 
+    /// @brief 最多等待timeout_ms毫秒获取信号量
+    /// @return 超时返回false
+    bool waitFor(uint64_t timeout_ms);
+
     /// @brief 释放信号量
     void notify();
 
@@ -11,11 +11,14 @@
 #pragma once
 #include<memory>
 #include<list>
+#include<deque>
+#include<atomic>
 #include<vector>
 #include<iostream>
 
 #include"fiber.h"
 #include"thread.h"
+#include"lockFreeQueue.h"
 
 
 
@@ -60,32 +63,35 @@ public:
     void stop();
 
     /// @brief 调度任务
+    /// @param thread 指定执行线程，-1表示任意线程
     template<class FiberOrCb>
     void schedule(FiberOrCb fc, int thread = -1){
-        bool need_tickle = false;
-        {
-            mutexType::Lock lock(m_mutex);
-            need_tickle = scheduleNoLock(fc, thread);
-        }
+        bool need_tickle = scheduleNoLock(fc, thread);
         if(need_tickle){
-            tickle();
+            if(thread == -1){
+                tickle();
+            }else{
+                tickleThread(thread);
+            }
         }
     }
 
     /// @brief 批量调度任务
     /// @tparam InputIterator 任务迭代器
+    /// @param thread 指定执行线程，-1表示任意线程
     template<class InputIterator>
-    void schedule(InputIterator begin, InputIterator end){
+    void schedule(InputIterator begin, InputIterator end, int thread = -1){
         bool need_tickle = false;
-        {
-            mutexType::Lock lock(m_mutex);
-            while(begin != end){
-                need_tickle = scheduleNoLock(&*begin, -1) || need_tickle;
-                begin++;
-            }
+        while(begin != end){
+            need_tickle = scheduleNoLock(&*begin, thread) || need_tickle;
+            begin++;
         }
         if(need_tickle){
-            tickle();
+            if(thread == -1){
+                tickle();
+            }else{
+                tickleThread(thread);
+            }
         }
     }
 protected:
@@ -93,6 +99,10 @@ protected:
     /// @brief 通知调度器有新任务了
     virtual void tickle();
 
+    /// @brief 通知指定线程有只能由它执行的新任务，默认等同于tickle
+    /// @param thread 线程ID
+    virtual void tickleThread(int thread) { tickle(); }
+
     /// @brief 调度器调度算法
     void run();
 
@@ -107,6 +117,23 @@ protected:
 
     /// @brief 是否有空闲线程
     bool hasIdleThread() const { return m_idleThreadCount > 0; }
+
+    /// @brief 是否还有当前线程可以执行的任务
+    /// @details 本线程队列中的任务，以及其他线程队列中可以窃取的任务；
+    ///          其他线程的pinned任务不计入，避免空闲线程为此空转
+    bool hasMisson();
+
+    /// @brief 工作队列数量，use_caller时包含调用线程
+    size_t getQueueCount() const { return m_queues.size(); }
+
+    /// @brief 拥有指定队列的线程ID
+    int getQueueOwner(size_t index) const { return m_queues[index]->owner; }
+
+    /// @brief 根据线程ID查找其队列下标，找不到返回-1
+    int queueIndexOf(int thread) const;
+
+    /// @brief 返回当前线程在本调度器中的队列下标，非本调度器线程返回-1
+    int currentQueueIndex() const;
 private:
     /// @brief 任务内容构造体
     struct Misson{
@@ -145,23 +172,76 @@ private:
         }
     };
 
-    /// @brief 向任务队列中添加任务（无锁）
+    /// @brief 工作线程的本地任务队列
+    /// @details 每个工作线程拥有一个队列，本线程从队首取任务，
+    ///          空闲线程从其他队列的队尾窃取任务；
+    ///          指定了线程的任务放入pinned，不参与窃取；
+    ///          其他线程提交的普通任务走无锁的inject队列，满了或者关闭时才退回加锁的missons
+    struct alignas(64) WorkQueue{
+        /// @brief 构造函数
+        /// @param inject_size 无锁注入队列的容量
+        WorkQueue(size_t inject_size)
+            :inject(inject_size){}
+
+        // 队列锁
+        mutexType mutex;
+        // 拥有该队列的线程ID
+        std::atomic<int> owner = {-1};
+        // 指定由本线程执行的任务
+        std::deque<Misson> pinned;
+        // 可被窃取的任务
+        std::deque<Misson> missons;
+        // 其他线程提交任务的无锁注入队列
+        LockFreeQueue<Misson> inject;
+    };
+
+    /// @brief 向任务队列中添加任务（调用方无需持有调度器锁）
+    /// @param[in,out] thread 指定线程，返回任务实际被固定到的线程
+    /// @return 是否需要唤醒空闲线程
     template<class FiberOrCb>
-    bool scheduleNoLock(FiberOrCb fc, int thread){
-        bool need_tickle = m_missons.empty();
-        Misson misson(fc,thread);
-        if(misson.cb || misson.fiber){
-            m_missons.push_back(misson);
+    bool scheduleNoLock(FiberOrCb fc, int& thread){
+        Misson misson(fc, thread);
+        if(!misson.cb && !misson.fiber){
+            return false;
         }
+        bool need_tickle = pushMisson(misson);
+        thread = misson.thread;
         return need_tickle;
     }
+
+    /// @brief 将任务放入合适的工作队列
+    /// @details 指定线程的任务直接进入该线程的队列；
+    ///          本调度器线程提交的任务进入本线程队列；
+    ///          外部线程提交的任务轮转分配到各队列的无锁注入队列
+    /// @return 目标队列原本是否为空
+    bool pushMisson(Misson& misson);
+
+    /// @brief 为当前工作线程取出一个任务
+    /// @param[out] misson 取出的任务
+    /// @param[out] tickle_me 是否还有剩余任务需要唤醒其他线程
+    /// @return 是否取到任务
+    bool popMisson(Misson& misson, bool& tickle_me);
+
+    /// @brief 从其他线程的队列尾部窃取任务
+    /// @param self 当前线程的队列下标
+    bool stealMisson(size_t self, Misson& misson, bool& tickle_me);
+
+    /// @brief 从注入队列中取出一个可以执行的任务
+    /// @details 取到仍在运行中的协程时，将其放回owner的missons稍后再试
+    bool popInject(WorkQueue& queue, Misson& misson, bool& tickle_me);
+
+    /// @brief 所有队列是否都为空
+    bool allQueuesEmpty();
+
 private:
     // 互斥量
     mutexType m_mutex;
     // 线程池
     std::vector<Thread::ptr> m_threads;
-    // 任务队列
-    std::list<Misson> m_missons;
+    // 每个工作线程的任务队列，use_caller时下标0为调用线程
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    // 外部线程是否使用无锁注入队列，scheduler.inject_queue_size为0时全部走加锁的missons
+    bool m_useInject = true;
     // 调度协程
     Fiber::ptr m_rootFiber;
     // 调度器名称
@@ -126,6 +126,10 @@ public:
         return setOption(level, option, &value, sizeof(T));
     }
 
+    /// @brief 开启SO_REUSEPORT，允许多个socket绑定同一地址
+    /// @pre 需要在bind之前调用，socket尚未创建时会先创建
+    bool enableReusePort();
+
 public:
 
     /// @brief 绑定地址
@@ -174,6 +178,16 @@ public:
     ///        @retval < 0 socket出错
     virtual int send(const iovec* buffers, size_t len, int flags = 0);
 
+    /// @brief 用sendfile把文件内容直接发送到socket，不经过用户空间
+    /// @param fd 文件句柄
+    /// @param offset 文件中的起始位置，返回时更新为发送结束的位置
+    /// @param len 待发送的数据长度
+    /// @return
+    ///        @retval > 0 成功发送的数据长度
+    ///        @retval = 0 socket被关闭或已到文件末尾
+    ///        @retval < 0 socket出错
+    virtual int sendFile(int fd, off_t* offset, size_t len);
+
     /// @brief 向指定地址发送指定长度的数据
     /// @param buffer 待发送的数据内存指针
     /// @param len 待发送的数据长度
@@ -65,6 +65,25 @@ public:
     ///        @retval <0 出现错误
     virtual int write(ByteArray::ptr ba, size_t len) override;
 
+    /// @brief 聚集写，一次系统调用写出多块数据，直到全部写完或出错
+    /// @param iovs 待写入的数据块，写的过程中会被修改
+    /// @param count 数据块数量
+    /// @return
+    ///        @retval >0 写入的数据总长度
+    ///        @retval =0 被关闭
+    ///        @retval <0 出现错误
+    int64_t writevFixSize(iovec* iovs, size_t count);
+
+    /// @brief 用sendfile发送文件的一段，直到全部发送完或出错
+    /// @param fd 文件句柄
+    /// @param offset 文件中的起始位置
+    /// @param len 发送的长度
+    /// @return
+    ///        @retval >0 发送的数据总长度
+    ///        @retval =0 被关闭或文件被截断
+    ///        @retval <0 出现错误
+    int64_t sendFileFixSize(int fd, off_t offset, size_t len);
+
     /// @brief 关闭socket
     virtual void close() override;
 
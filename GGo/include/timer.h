@@ -11,28 +11,38 @@
 #include<memory>
 #include<vector>
 #include<set>
+#include<atomic>
 #include"thread.h"
 
 namespace GGo{
 
 class TimerManager;
+class TimerQueue;
 
 class Timer : public std::enable_shared_from_this<Timer>{
 friend class TimerManager;
+friend class TimerSet;
+friend class TimingWheel;
 public:
     // 智能指针类
     using ptr = std::shared_ptr<Timer>;
 
     /// @brief 取消定时器
+    /// @details 定时器在其他线程的存储中时只发出取消消息，返回值表示是否是第一次取消
     bool cancel();
 
     /// @brief 刷新定时器 
+    /// @details 定时器在其他线程的存储中时只发出消息并返回true，下同
     bool refresh();
 
     /// @brief 重置定时器
     /// @param ms 执行间隔时间
     /// @param from_now 是否从当前时间开始计算
     bool reset(uint64_t ms, bool from_now);
+
+    /// @brief 把定时器迁移到调用线程的存储中
+    /// @details 用于句柄的处理转移到其他线程之后，让它的超时定时器也跟过去
+    bool migrate();
 private:
     /// @brief 构造函数
     /// @param ms 定时器执行的间隔时间
@@ -56,6 +66,18 @@ private:
     std::function<void()> m_cb;
     // 定时器管理器
     TimerManager* m_manager = nullptr;
+    // 时间轮中所在的层与槽，不在时间轮中时层为-1
+    int m_wheelLevel = -1;
+    uint32_t m_wheelSlot = 0;
+    // 时间轮槽内的双向链表
+    Timer* m_wheelPrev = nullptr;
+    Timer* m_wheelNext = nullptr;
+    // 在时间轮中时持有自身，离开时间轮时释放
+    Timer::ptr m_wheelHold;
+    // 所在的定时器存储，-1为加锁的共享存储
+    std::atomic<int> m_store = {-1};
+    // 是否已被取消，其他线程取消时拥有者线程可能还没处理取消消息
+    std::atomic<bool> m_cancelled = {false};
 private:
     struct Comparator{
         /// @brief  按执行顺序为定时器比大小
@@ -99,23 +121,59 @@ public:
     /// @brief 是否有定时器
     bool hasTimer();
 private:
+    /// @brief 一份定时器存储
+    struct Store;
+    /// @brief 发给定时器所在存储的操作
+    struct Message;
+
     /// @brief 检测服务器时间是否回滚并重置
-    bool detectClockRollover(uint64_t now_ms);
+    bool detectClockRollover(Store& store, uint64_t now_ms);
+
+    /// @brief 在定时器所在的存储上执行操作：共享存储加锁执行，本线程的存储直接执行，其他线程的存储发送消息
+    bool apply(Message& msg);
+
+    /// @brief 在store上执行操作
+    /// @param index store的下标，-1为共享存储
+    /// @param lock 共享存储的写锁，重新加入共享存储时会被释放
+    /// @pre 共享存储需要持有写锁，线程私有的存储只能由拥有者调用
+    bool handle(Store& store, int index, Message& msg, RWMutexType::writeLock* lock);
+
+    /// @brief 发送消息给index号存储的拥有者线程
+    void post(size_t index, Message& msg);
+
+    /// @brief 处理其他线程发给本存储的消息
+    void drain(Store& store, int index);
+
+    /// @brief 取出store中到期的定时器回调
+    void expire(Store& store, uint64_t now_ms, std::vector<std::function<void()>>& cbs);
+
+    /// @brief 加入本线程私有的存储，或加锁后加入共享存储
+    void insert(Timer::ptr timer, int index);
 protected:
     /// @brief 当有新的定时器加入到容器首部，执行该函数
     virtual void onTimerInsertedAtFront() = 0;
 
-    /// @brief 将定时器加入到管理器内
+    /// @brief 调用线程拥有的定时器存储下标，-1表示使用加锁的共享存储
+    virtual int getTimerStore() const { return -1; }
+
+    /// @brief 有消息发给index号存储时调用，用于唤醒它的拥有者线程
+    virtual void onTimerMessage(size_t index) {}
+
+    /// @brief 创建count个线程私有的定时器存储，需要在添加定时器之前调用
+    /// @details 私有存储只由拥有者线程读写，不加锁；其他线程对其中定时器的操作以消息的形式发送
+    void initTimerStores(size_t count);
+
+    /// @brief 将定时器加入到共享存储内
     void addTimer(Timer::ptr timer, RWMutexType::writeLock& lock);
 private:
-    // 互斥量
+    // 共享存储的互斥量
     RWMutexType m_mutex;
-    // 定时器容器
-    std::set<Timer::ptr, Timer::Comparator> m_timers;
+    // 共享存储，由不拥有私有存储的线程使用
+    std::unique_ptr<Store> m_shared;
+    // 线程私有的存储，下标由getTimerStore()给出
+    std::vector<std::unique_ptr<Store>> m_stores;
     // 是否执行onTimerInsertedAtFront()
-    bool m_tickled = false;
-    // 上次执行时间
-    uint64_t m_previouseTime = 0;
+    std::atomic<bool> m_tickled = {false};
 
 };
 
@@ -0,0 +1,113 @@
+/**
+ * @file timerQueue.h
+ * @author GGo
+ * @brief 定时器的存储结构
+ * @date 2024-03-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+#include<set>
+#include<vector>
+#include<stdint.h>
+#include"timer.h"
+
+namespace GGo{
+
+/// @brief 定时器存储结构接口
+/// @details 本身不加锁，由TimerManager负责同步
+class TimerQueue{
+public:
+    virtual ~TimerQueue(){}
+
+    /// @brief 加入定时器
+    /// @return 是否成为最早到期的定时器
+    virtual bool insert(const Timer::ptr& timer) = 0;
+
+    /// @brief 移除定时器
+    /// @return 定时器是否在队列中
+    virtual bool erase(const Timer::ptr& timer) = 0;
+
+    /// @brief 最早的到期时间戳，可能早于实际值（但不会晚于），为空时返回~0ull
+    virtual uint64_t nextExpire() = 0;
+
+    /// @brief 取出到期时间不晚于now_ms的定时器，按到期顺序追加到expired
+    virtual void popExpired(uint64_t now_ms, std::vector<Timer::ptr>& expired) = 0;
+
+    /// @brief 取出全部定时器（服务器时间回滚时使用）
+    virtual void popAll(std::vector<Timer::ptr>& expired) = 0;
+
+    /// @brief 定时器数量
+    virtual size_t size() const = 0;
+};
+
+/// @brief 基于红黑树的定时器队列，插入与删除 O(logN)
+class TimerSet : public TimerQueue{
+public:
+    bool insert(const Timer::ptr& timer) override;
+    bool erase(const Timer::ptr& timer) override;
+    uint64_t nextExpire() override;
+    void popExpired(uint64_t now_ms, std::vector<Timer::ptr>& expired) override;
+    void popAll(std::vector<Timer::ptr>& expired) override;
+    size_t size() const override { return m_timers.size(); }
+
+private:
+    // 按到期时间排序的定时器
+    std::set<Timer::ptr, Timer::Comparator> m_timers;
+};
+
+/// @brief 分层时间轮，精度1ms，插入与删除 O(1)
+/// @details 第0层256个槽，每槽1ms；第1~4层各64个槽，每槽为下一层一圈的时长，共覆盖2^32ms；
+///          更远的定时器先放在最高层，转到时重新计算位置。
+///          每个槽是定时器的侵入式双向链表，每层一个位图记录非空的槽
+class TimingWheel : public TimerQueue{
+public:
+    /// @brief 构造函数
+    /// @param now_ms 时间轮的起始时间
+    explicit TimingWheel(uint64_t now_ms);
+    ~TimingWheel();
+
+    bool insert(const Timer::ptr& timer) override;
+    bool erase(const Timer::ptr& timer) override;
+    uint64_t nextExpire() override;
+    void popExpired(uint64_t now_ms, std::vector<Timer::ptr>& expired) override;
+    void popAll(std::vector<Timer::ptr>& expired) override;
+    size_t size() const override { return m_size; }
+
+private:
+    // 层数
+    static const int LEVELS = 5;
+    // 第0层槽数的位数
+    static const int ROOT_BITS = 8;
+    // 其余各层槽数的位数
+    static const int LEVEL_BITS = 6;
+
+    /// @brief 第level层一个槽覆盖的时长的位数
+    static int shift(int level) { return level == 0 ? 0 : ROOT_BITS + (level - 1) * LEVEL_BITS; }
+    /// @brief 第level层的槽数
+    static uint32_t slots(int level) { return level == 0 ? (1u << ROOT_BITS) : (1u << LEVEL_BITS); }
+
+    /// @brief 按当前时间把定时器挂到对应的槽上
+    void place(Timer* timer);
+    /// @brief 把定时器从所在的槽上摘下
+    void unlink(Timer* timer);
+    /// @brief 把第level层当前的槽重新分配到下层
+    void cascade(int level);
+    /// @brief 第level层从slot开始（含）第一个非空槽与slot的距离，没有时返回-1
+    int findSlot(int level, uint32_t slot) const;
+
+private:
+    // 各层的槽，存放链表头
+    std::vector<Timer*> m_slots[LEVELS];
+    // 各层非空槽的位图
+    std::vector<uint64_t> m_bitmaps[LEVELS];
+    // 下一个要处理的时间(ms)，早于它的槽都已处理
+    uint64_t m_current;
+    // 定时器数量
+    size_t m_size = 0;
+    // 最早到期时间的下界，用于判断新定时器是否在最前面
+    uint64_t m_earliest = ~0ull;
+};
+
+}
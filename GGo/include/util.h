@@ -61,6 +61,31 @@ uint64_t getCurrentMS();
 /// @brief 获取当前时间的微秒数
 uint64_t getCurrentUS();
 
+/// @brief 时钟精度
+enum ClockType
+{
+    // 每次都读取系统时钟
+    PRECISE = 0,
+    // 优先读取本线程缓存的时间，没有缓存时读取CLOCK_REALTIME_COARSE
+    COARSE = 1,
+};
+
+/// @brief 返回当前时间的毫秒数
+/// @details COARSE在IOScheduler工作线程上是事件循环最近一次唤醒或调度器最近一次执行完任务的时间，
+///          落后于真实时间的部分最多是当前任务已经执行的时间
+/// @param type 时钟精度
+uint64_t now(ClockType type = PRECISE);
+
+/// @brief 用精确时间刷新本线程缓存的时间，由事件循环在每次唤醒后调用
+/// @return 刷新后的毫秒数
+uint64_t updateCoarseClock();
+
+/// @brief 本线程有缓存时间时用精确时间刷新，由调度器在每个任务执行完后调用
+void refreshCoarseClock();
+
+/// @brief 清除本线程缓存的时间，事件循环退出后调用，之后COARSE回退到系统粗粒度时钟
+void clearCoarseClock();
+
 ///@brief 常用文件操作辅助工具
 class FSUtil{
 public:
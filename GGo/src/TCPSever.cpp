@@ -43,7 +43,10 @@ void TCPSever::startAccept(Socket::ptr sock)
         Socket::ptr cilent = sock->accept();
         if(cilent){
             cilent->setRecvTimeout(m_recvTimeout);
-            m_ioWorker->schedule(std::bind(&TCPSever::handleCilent, shared_from_this(), cilent));
+            // 每线程epoll模式下连接留在接受它的线程上，句柄上下文不会跨核访问
+            int thread = (m_ioWorker == m_acceptWorker && m_ioWorker->isPerThreadPoller())
+                            ? GGo::GetThreadID() : -1;
+            m_ioWorker->schedule(std::bind(&TCPSever::handleCilent, shared_from_this(), cilent), thread);
         }else{
             GGO_LOG_ERROR(g_logger) << "accept errno=" << errno << " errstr=" << strerror(errno);
         }
@@ -66,6 +69,7 @@ TCPSever::~TCPSever()
         sock->close();
     }
     m_socks.clear();
+    m_sockThreads.clear();
 }
 bool TCPSever::bind(GGo::Address::ptr addr, bool ssl)
 {
@@ -77,27 +81,50 @@ bool TCPSever::bind(GGo::Address::ptr addr, bool ssl)
 bool TCPSever::bind(const std::vector<Address::ptr> &addrs, std::vector<Address::ptr> &fails, bool ssl)
 {
     m_ssl = ssl;
+    std::vector<int> threads;
+    if(m_acceptWorker && m_acceptWorker->isPerThreadPoller()){
+        threads = m_acceptWorker->getPollerThreads();
+    }
     for(auto& addr : addrs){
-        Socket::ptr sock = Socket::CreateTCP(addr);
-        if(!sock->bind(addr)){
-            GGO_LOG_ERROR(g_logger) << "bind fail errno=" << errno
-                                << " errstr=" << strerror(errno)
-                                << " addr=[" << addr->toString() << "]";
-            fails.push_back(addr);
-            continue;
-        }
-        if(!sock->listen()){
-            GGO_LOG_ERROR(g_logger) << "listen fail errno=" << errno
-                                << " errstr=" << strerror(errno)
-                                << " addr=[" << addr->toString() << "]";
-            fails.push_back(addr);
-            continue;
+        // unix socket不支持SO_REUSEPORT，只监听一个
+        bool sharded = !threads.empty()
+                    && (addr->getFamily() == AF_INET || addr->getFamily() == AF_INET6);
+        size_t count = sharded ? threads.size() : 1;
+        Address::ptr bind_addr = addr;
+        for(size_t i = 0; i < count; i++){
+            Socket::ptr sock = Socket::CreateTCP(bind_addr);
+            if(sharded && !sock->enableReusePort()){
+                GGO_LOG_ERROR(g_logger) << "reuse port fail errno=" << errno
+                                    << " errstr=" << strerror(errno)
+                                    << " addr=[" << addr->toString() << "]";
+                fails.push_back(addr);
+                break;
+            }
+            if(!sock->bind(bind_addr)){
+                GGO_LOG_ERROR(g_logger) << "bind fail errno=" << errno
+                                    << " errstr=" << strerror(errno)
+                                    << " addr=[" << addr->toString() << "]";
+                fails.push_back(addr);
+                break;
+            }
+            if(!sock->listen()){
+                GGO_LOG_ERROR(g_logger) << "listen fail errno=" << errno
+                                    << " errstr=" << strerror(errno)
+                                    << " addr=[" << addr->toString() << "]";
+                fails.push_back(addr);
+                break;
+            }
+            if(i == 0 && count > 1){
+                // 端口为0时由内核分配，其余socket需要绑定到同一个端口
+                bind_addr = sock->getLocalAddress();
+            }
+            m_socks.push_back(sock);
+            m_sockThreads.push_back(sharded ? threads[i] : -1);
         }
-        m_socks.push_back(sock);
-        
     }
     if(!fails.empty()){
             m_socks.clear();
+            m_sockThreads.clear();
             return false;
     }
     for(auto& success_sock : m_socks){
@@ -115,8 +142,9 @@ bool TCPSever::start()
         return true;
     }
     m_isStop = false;
-    for(auto& sock : m_socks){
-        m_acceptWorker->schedule(std::bind(&TCPSever::startAccept, shared_from_this(), sock));
+    for(size_t i = 0; i < m_socks.size(); i++){
+        m_acceptWorker->schedule(std::bind(&TCPSever::startAccept, shared_from_this(), m_socks[i]),
+                                m_sockThreads[i]);
     }
     return true;
 }
@@ -125,12 +153,15 @@ void TCPSever::stop()
     //TODO:: 这里的m_isStop要加锁吗
     m_isStop = true;
     auto self = shared_from_this();
-    m_acceptWorker->schedule([this, self](){
-        for(auto& sock : m_socks){
+    for(size_t i = 0; i < m_socks.size(); i++){
+        // 在accept循环所在的线程上关闭，否则它可能在取消之后才注册事件，永远等不到唤醒
+        Socket::ptr sock = m_socks[i];
+        m_acceptWorker->schedule([sock, self](){
             sock->cancelAll();
             sock->close();
-        }
-        m_socks.clear();
-    });
+        }, m_sockThreads[i]);
+    }
+    m_socks.clear();
+    m_sockThreads.clear();
 }
 }
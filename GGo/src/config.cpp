@@ -46,6 +46,111 @@ void Config::loadFromYaml(YAML::Node& root)
     }
 }
 
+/// @brief 比较两个yaml节点的内容是否相同
+static bool yamlEqual(const YAML::Node& a, const YAML::Node& b)
+{
+    if(a.Type() != b.Type()){
+        return false;
+    }
+    switch(a.Type()){
+        case YAML::NodeType::Scalar:
+            return a.Scalar() == b.Scalar();
+        case YAML::NodeType::Sequence:
+            if(a.size() != b.size()){
+                return false;
+            }
+            for(size_t i = 0; i < a.size(); i++){
+                if(!yamlEqual(a[i], b[i])){
+                    return false;
+                }
+            }
+            return true;
+        case YAML::NodeType::Map:
+            if(a.size() != b.size()){
+                return false;
+            }
+            for(auto it = a.begin(); it != a.end(); it++){
+                const YAML::Node other = b[it->first.Scalar()];
+                if(!other.IsDefined() || !yamlEqual(it->second, other)){
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+/// @brief 后序遍历新节点，把内容发生变化的配置名按父节点在前的顺序记录到output
+/// @return node与old_node的内容是否不同
+static bool listChangedMembers(const std::string& prefix,
+                               const YAML::Node& old_node,
+                               const YAML::Node& node,
+                               std::list<std::pair<std::string, const YAML::Node> >& output)
+{
+    if(prefix.find_first_not_of("avcdefghijklmnopqrstuvwxyz._0123456789") != std::string::npos)
+    {   //日志项目名非法
+        GGO_LOG_ERROR(GGO_LOG_ROOT()) << "Config invalid name: " 
+                                      << prefix << " . " << node;
+        return false;
+    }
+    if(!node.IsMap()){
+        if(yamlEqual(old_node, node)){
+            return false;
+        }
+        output.emplace_back(std::make_pair(prefix, node));
+        return true;
+    }
+    //先占住父节点的位置，子节点比较完之后再决定是否保留
+    output.emplace_back(std::make_pair(prefix, node));
+    auto self = std::prev(output.end());
+    bool changed = !old_node.IsMap() || old_node.size() != node.size();
+    for(auto it = node.begin(); it != node.end(); it++){
+        const std::string& key = it->first.Scalar();
+        YAML::Node old_child(YAML::NodeType::Undefined);
+        if(old_node.IsMap()){
+            //不存在的键返回无效节点，不能直接比较
+            const YAML::Node child = old_node[key];
+            if(child.IsDefined()){
+                old_child.reset(child);
+            }
+        }
+        if(listChangedMembers(prefix.empty() ? key : prefix + "." + key, old_child, it->second, output)){
+            changed = true;
+        }
+    }
+    if(!changed){
+        output.erase(self);
+    }
+    return changed;
+}
+
+size_t Config::loadFromYamlDiff(const YAML::Node& old_root, const YAML::Node& root)
+{
+    std::list<std::pair<std::string, const YAML::Node> > changed_nodes;
+    listChangedMembers("", old_root, root, changed_nodes);
+    size_t count = 0;
+    for(auto& i : changed_nodes){
+        std::string key = i.first;
+        if(key.empty()){
+            continue;
+        }
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        ConfigVarBase::ptr var = lookupBase(key);
+        if(var){
+            if(i.second.IsScalar()){
+                var->fromString(i.second.Scalar());
+            }else{
+                std::stringstream ss;
+                ss << i.second;
+                var->fromString(ss.str());
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
 ConfigVarBase::ptr Config::lookupBase(const std::string &name)
 {
     RWMutexType::readLock lock(GetMutex());
@@ -0,0 +1,214 @@
+#include "configWatcher.h"
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <string.h>
+#include <chrono>
+#include "config.h"
+#include "logSystem.h"
+#include "util.h"
+
+namespace GGo{
+
+static GGo::Logger::ptr g_logger = GGO_LOG_NAME("system");
+
+/// @brief 拆分出文件所在目录与文件名
+static void splitPath(const std::string& path, std::string& dir, std::string& name)
+{
+    size_t pos = path.rfind('/');
+    if(pos == std::string::npos){
+        dir = ".";
+        name = path;
+    }else{
+        dir = pos == 0 ? "/" : path.substr(0, pos);
+        name = path.substr(pos + 1);
+    }
+}
+
+ConfigWatcher::ConfigWatcher(IOScheduler* iom, uint64_t debounce)
+    :m_iom(iom)
+    ,m_debounce(debounce){
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    stop();
+}
+
+bool ConfigWatcher::addFile(const std::string& path)
+{
+    File file;
+    std::string dir;
+    file.path = path;
+    splitPath(path, dir, file.name);
+    bool ok = true;
+    try{
+        file.root = YAML::LoadFile(path);
+        Config::loadFromYaml(file.root);
+    }catch(std::exception& e){
+        GGO_LOG_ERROR(g_logger) << "ConfigWatcher load file=" << path
+                                << " failed: " << e.what();
+        ok = false;
+    }
+    MutexType::Lock lock(m_mutex);
+    if(m_fd != -1){
+        watch(path, file.wd);
+    }
+    m_files.push_back(std::move(file));
+    return ok;
+}
+
+bool ConfigWatcher::watch(const std::string& path, int& wd)
+{
+    std::string dir, name;
+    splitPath(path, dir, name);
+    wd = inotify_add_watch(m_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if(wd == -1){
+        GGO_LOG_ERROR(g_logger) << "ConfigWatcher inotify_add_watch dir=" << dir
+                                << " errno=" << errno << " " << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool ConfigWatcher::start()
+{
+    MutexType::Lock lock(m_mutex);
+    if(m_fd != -1){
+        return true;
+    }
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(m_fd == -1){
+        GGO_LOG_ERROR(g_logger) << "ConfigWatcher inotify_init1 errno=" << errno
+                                << " " << strerror(errno);
+        return false;
+    }
+    for(auto& file : m_files){
+        watch(file.path, file.wd);
+    }
+    //事件回调发往注册时所在的调度器，需要在m_iom中注册
+    m_iom->schedule(std::bind(&ConfigWatcher::onReadable, shared_from_this()));
+    return true;
+}
+
+void ConfigWatcher::stop()
+{
+    MutexType::Lock lock(m_mutex);
+    if(m_fd == -1){
+        return;
+    }
+    m_iom->delEvent(m_fd, IOScheduler::READ);
+    close(m_fd);
+    m_fd = -1;
+}
+
+void ConfigWatcher::onReadable()
+{
+    MutexType::Lock lock(m_mutex);
+    if(m_fd == -1){
+        return;
+    }
+    //边沿触发，必须读到EAGAIN
+    alignas(struct inotify_event) char buf[4096];
+    bool changed = false;
+    while(true){
+        ssize_t n = read(m_fd, buf, sizeof(buf));
+        if(n <= 0){
+            break;
+        }
+        for(char* ptr = buf; ptr < buf + n; ){
+            struct inotify_event* event = (struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+            if(event->mask & IN_Q_OVERFLOW){
+                //丢失了事件，无法确定哪些文件被修改
+                for(auto& file : m_files){
+                    file.dirty = true;
+                }
+                changed = true;
+                continue;
+            }
+            if(event->len == 0){
+                continue;
+            }
+            for(auto& file : m_files){
+                if(file.wd == event->wd && file.name == event->name){
+                    file.dirty = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+    if(changed){
+        m_lastEvent = getCurrentMS();
+        if(!m_pending){
+            m_pending = true;
+            m_iom->addConditionTimer(m_debounce, std::bind(&ConfigWatcher::onTimer, this)
+                                    , shared_from_this());
+        }
+    }
+    std::weak_ptr<ConfigWatcher> weak(shared_from_this());
+    m_iom->addEvent(m_fd, IOScheduler::READ, [weak](){
+        if(auto self = weak.lock()){
+            self->onReadable();
+        }
+    });
+}
+
+void ConfigWatcher::onTimer()
+{
+    {
+        MutexType::Lock lock(m_mutex);
+        uint64_t elapse = getCurrentMS() - m_lastEvent;
+        if(elapse < m_debounce){
+            //等待期间又有修改，从最后一次修改重新计时
+            m_iom->addConditionTimer(m_debounce - elapse, std::bind(&ConfigWatcher::onTimer, this)
+                                    , shared_from_this());
+            return;
+        }
+        m_pending = false;
+    }
+    reload();
+}
+
+size_t ConfigWatcher::reload(bool all)
+{
+    MutexType::Lock reload_lock(m_reloadMutex);
+    std::vector<std::pair<std::string, YAML::Node> > files;
+    {
+        MutexType::Lock lock(m_mutex);
+        for(auto& file : m_files){
+            if(all || file.dirty){
+                file.dirty = false;
+                files.emplace_back(file.path, file.root);
+            }
+        }
+    }
+    size_t count = 0;
+    for(auto& i : files){
+        auto begin = std::chrono::steady_clock::now();
+        YAML::Node root;
+        try{
+            root = YAML::LoadFile(i.first);
+        }catch(std::exception& e){
+            //文件写了一半或格式错误时保留原来的配置
+            GGO_LOG_ERROR(g_logger) << "ConfigWatcher reload file=" << i.first
+                                    << " failed: " << e.what();
+            continue;
+        }
+        size_t changed = Config::loadFromYamlDiff(i.second, root);
+        count += changed;
+        std::chrono::duration<double, std::micro> used = std::chrono::steady_clock::now() - begin;
+        GGO_LOG_INFO(g_logger) << "ConfigWatcher reload file=" << i.first
+                               << " changed=" << changed << " used=" << used.count() << "us";
+        MutexType::Lock lock(m_mutex);
+        for(auto& file : m_files){
+            if(file.path == i.first){
+                //赋值会修改原节点共享的数据，这里只替换引用
+                file.root.reset(root);
+            }
+        }
+    }
+    m_reloads++;
+    return count;
+}
+
+}
@@ -76,41 +76,29 @@ bool FdCtx::init()
 }
 FdManager::FdManager()
 {
-    m_fds.resize(64);
 }
 FdCtx::ptr FdManager::get(int fd, bool auto_create)
 {
-    if(fd == -1){
+    std::atomic<FdCtx::ptr>* slot = m_fds.get(fd, auto_create);
+    if(!slot){
         return nullptr;
     }
-    RWMutexType::readLock lock(m_mutex);
-    if(fd >= (int)m_fds.size()){
-        if(auto_create == false){
-            return nullptr;
-        }
-    }else{
-        if(m_fds[fd] || !auto_create){
-            return m_fds[fd];
-        }
+    FdCtx::ptr ctx = slot->load(std::memory_order_acquire);
+    if(ctx || !auto_create){
+        return ctx;
     }
-    lock.unlock();
-    
-    RWMutexType::writeLock lock2(m_mutex);
-    FdCtx::ptr ctx(new FdCtx(fd));
-    if(fd >= (int)m_fds.size()){
-        m_fds.resize(fd * 2);
+    FdCtx::ptr created(new FdCtx(fd));
+    if(slot->compare_exchange_strong(ctx, created, std::memory_order_acq_rel)){
+        return created;
     }
-    m_fds[fd] = ctx;
     return ctx;
-
-
 }
 void FdManager::del(int fd)
 {
-    RWMutexType::writeLock lock(m_mutex);
-    if(fd >= (int)m_fds.size()){
+    std::atomic<FdCtx::ptr>* slot = m_fds.get(fd, false);
+    if(!slot){
         return;
     }
-    m_fds[fd].reset();
+    slot->store(nullptr, std::memory_order_release);
+}
 }
-}
\ No newline at end of file
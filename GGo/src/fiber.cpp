@@ -4,6 +4,12 @@
 #include"config.h"
 #include"scheduler.h"
 #include <atomic>
+#include <map>
+#include <algorithm>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
 
 
 namespace GGo
@@ -11,8 +17,45 @@ namespace GGo
 //系统日志
 static Logger::ptr g_logger = GGO_LOG_NAME("system");
 
-static std::atomic<uint64_t> s_fiber_id{0};
 static std::atomic<uint64_t> s_fiber_count{0};
+static std::atomic<uint64_t> s_fiber_created{0};
+static std::atomic<uint64_t> s_fiber_reused{0};
+
+/// @brief 协程ID分配器
+/// @details 释放的ID放入最小堆，优先复用最小的ID，使ID范围与同时存在的协程数量相当
+class FiberIdAllocator{
+public:
+    uint64_t alloc(){
+        SpinLock::Lock lock(m_mutex);
+        if(!m_free.empty()){
+            uint64_t id = m_free.front();
+            std::pop_heap(m_free.begin(), m_free.end(), std::greater<uint64_t>());
+            m_free.pop_back();
+            return id;
+        }
+        return ++m_maxID;
+    }
+
+    void release(uint64_t id){
+        SpinLock::Lock lock(m_mutex);
+        m_free.push_back(id);
+        std::push_heap(m_free.begin(), m_free.end(), std::greater<uint64_t>());
+    }
+
+    /// @brief 全局分配器，不析构，保证进程退出时析构的协程仍可归还ID
+    static FiberIdAllocator* GetInstance(){
+        static FiberIdAllocator* s_allocator = new FiberIdAllocator;
+        return s_allocator;
+    }
+
+private:
+    // 互斥量
+    SpinLock m_mutex;
+    // 已分配过的最大ID
+    uint64_t m_maxID = 0;
+    // 空闲ID最小堆
+    std::vector<uint64_t> m_free;
+};
 
 static thread_local Fiber* t_fiber = nullptr;
 static thread_local Fiber::ptr t_threadFiber = nullptr;
@@ -20,19 +63,182 @@ static thread_local Fiber::ptr t_threadFiber = nullptr;
 static ConfigVar<uint32_t>::ptr g_fiber_stack_size =
     Config::Lookup<uint32_t>("fiber.stack_size", 128 * 1024, "fiber stack size");
 
-class MallocStackAlloactor{
+static ConfigVar<uint32_t>::ptr g_fiber_stack_pool_size =
+    Config::Lookup<uint32_t>("fiber.stack_pool_size", 64, "max cached fiber stacks per thread");
+
+static std::atomic<uint64_t> s_stack_pool_hit{0};
+static std::atomic<uint64_t> s_stack_pool_miss{0};
+static uint32_t s_stack_pool_size = 64;
+
+/// @brief 基于mmap的协程栈分配器
+/// @details 栈的低地址端放一个PROT_NONE保护页，栈溢出时直接触发SIGSEGV而不是破坏堆；
+///          释放的栈先MADV_DONTNEED归还物理内存，再放入线程本地的缓存池复用虚拟地址
+class MmapStackAllocator{
 public:
     static void* Alloc(size_t size){
-        return malloc(size);
+        size = RoundUp(size);
+        StackPool& pool = t_pool;
+        auto it = pool.stacks.find(size);
+        if(it != pool.stacks.end() && !it->second.empty()){
+            void* vp = it->second.back();
+            it->second.pop_back();
+            pool.count--;
+            s_stack_pool_hit++;
+            return vp;
+        }
+        s_stack_pool_miss++;
+
+        size_t page = PageSize();
+        void* base = mmap(nullptr, size + page, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(GGO_UNLIKELY(base == MAP_FAILED)){
+            GGO_LOG_ERROR(g_logger) << "mmap fiber stack size=" << size
+                                    << " errno=" << errno << " " << strerror(errno);
+            throw std::bad_alloc();
+        }
+        // 栈向低地址增长，保护页放在最低处
+        if(mprotect(base, page, PROT_NONE)){
+            GGO_LOG_ERROR(g_logger) << "mprotect fiber stack guard page errno="
+                                    << errno << " " << strerror(errno);
+        }
+        return (char*)base + page;
     }
 
     static void Dealloc(void* vp, size_t size){
-        return free(vp);
+        size = RoundUp(size);
+        if(GGO_UNLIKELY(t_pool_destroyed)){
+            // 线程退出时缓存池已经析构
+            Unmap(vp, size);
+            return;
+        }
+        StackPool& pool = t_pool;
+        if(pool.count < s_stack_pool_size){
+            // 归还物理页，下次使用时按需缺页，虚拟地址保留在池中
+            madvise(vp, size, MADV_DONTNEED);
+            pool.stacks[size].push_back(vp);
+            pool.count++;
+            return;
+        }
+        Unmap(vp, size);
     }
 
+private:
+    /// @brief 线程本地的栈缓存池，按栈大小分组
+    struct StackPool{
+        ~StackPool(){
+            t_pool_destroyed = true;
+            for(auto& i : stacks){
+                for(auto& vp : i.second){
+                    Unmap(vp, i.first);
+                }
+            }
+        }
+        // 栈大小 -> 空闲栈
+        std::map<size_t, std::vector<void*>> stacks;
+        // 空闲栈总数
+        uint32_t count = 0;
+    };
+
+    static size_t PageSize(){
+        static size_t s_page = sysconf(_SC_PAGESIZE);
+        return s_page;
+    }
 
+    static size_t RoundUp(size_t size){
+        size_t page = PageSize();
+        return (size + page - 1) / page * page;
+    }
+
+    static void Unmap(void* vp, size_t size){
+        size_t page = PageSize();
+        munmap((char*)vp - page, size + page);
+    }
+
+    static thread_local StackPool t_pool;
+    static thread_local bool t_pool_destroyed;
+};
+thread_local MmapStackAllocator::StackPool MmapStackAllocator::t_pool;
+thread_local bool MmapStackAllocator::t_pool_destroyed = false;
+
+using StackAlloactor = MmapStackAllocator;
+
+static ConfigVar<bool>::ptr g_fiber_shared_stack =
+    Config::Lookup<bool>("fiber.shared_stack", false, "scheduler creates fibers on shared stacks");
+static ConfigVar<uint32_t>::ptr g_fiber_shared_stack_size =
+    Config::Lookup<uint32_t>("fiber.shared_stack_size", 1024 * 1024, "size of each per-thread shared fiber stack");
+static ConfigVar<uint32_t>::ptr g_fiber_shared_stack_count =
+    Config::Lookup<uint32_t>("fiber.shared_stack_count", 4, "number of shared fiber stacks per thread");
+
+static ConfigVar<uint32_t>::ptr g_fiber_pool_size =
+    Config::Lookup<uint32_t>("fiber.pool_size", 256, "max cached terminated fibers per thread");
+
+static bool s_shared_stack = false;
+static uint32_t s_fiber_pool_size = 256;
+
+/// @brief 缓存栈池上限与共享栈开关，避免每次使用都读取配置
+struct __StackPoolIniter{
+    __StackPoolIniter(){
+        s_stack_pool_size = g_fiber_stack_pool_size->getValue();
+        g_fiber_stack_pool_size->addListener([](const uint32_t& oldv, const uint32_t& newv){
+            GGO_LOG_INFO(g_logger) << "fiber stack pool size changed from "
+                                   << oldv << " to " << newv;
+            s_stack_pool_size = newv;
+        });
+        s_fiber_pool_size = g_fiber_pool_size->getValue();
+        g_fiber_pool_size->addListener([](const uint32_t& oldv, const uint32_t& newv){
+            GGO_LOG_INFO(g_logger) << "fiber pool size changed from "
+                                   << oldv << " to " << newv;
+            s_fiber_pool_size = newv;
+        });
+        s_shared_stack = g_fiber_shared_stack->getValue();
+        g_fiber_shared_stack->addListener([](const bool& oldv, const bool& newv){
+            GGO_LOG_INFO(g_logger) << "fiber shared stack changed from "
+                                   << oldv << " to " << newv;
+            s_shared_stack = newv;
+        });
+    }
+};
+static __StackPoolIniter s_stack_pool_initer;
+
+struct Fiber::SharedStack{
+    // 栈底指针
+    void* stack = nullptr;
+    // 栈大小
+    size_t size = 0;
+    // 当前栈上运行（或最后运行）的协程
+    std::weak_ptr<Fiber> occupant;
 };
-using StackAlloactor = MallocStackAlloactor;
+
+/// @brief 线程本地的共享栈组，按轮转分配给新协程
+struct SharedStackGroup{
+    ~SharedStackGroup(){
+        for(auto& i : stacks){
+            StackAlloactor::Dealloc(i.stack, i.size);
+        }
+    }
+
+    Fiber::SharedStack* next(){
+        if(GGO_UNLIKELY(stacks.empty())){
+            size_t count = std::max(1u, g_fiber_shared_stack_count->getValue());
+            size_t size = g_fiber_shared_stack_size->getValue();
+            stacks.resize(count);
+            for(auto& i : stacks){
+                i.size = size;
+                i.stack = StackAlloactor::Alloc(size);
+            }
+        }
+        return &stacks[index++ % stacks.size()];
+    }
+
+    // 共享栈
+    std::vector<Fiber::SharedStack> stacks;
+    // 下一个分配的下标
+    size_t index = 0;
+};
+static thread_local SharedStackGroup t_shared_stacks;
+
+/// @brief 线程本地的已结束协程缓存，下标0为独立栈协程，1为共享栈协程
+static thread_local std::vector<Fiber::ptr> t_fiber_pool[2];
 
 
 Fiber::Fiber()
@@ -40,35 +246,31 @@ Fiber::Fiber()
     m_state = State::EXEC;
     setThis(this);
 
-    if(getcontext(&m_ctx)){
-        GGO_ASSERT2(false, "getcontext");
-    }
+    m_ctx.init();
 
     s_fiber_count++;
 
 }
 
-Fiber::Fiber(mission cb, size_t stacksize, bool use_scheduler)
-    :m_id(++s_fiber_id)
+Fiber::Fiber(mission cb, size_t stacksize, bool use_scheduler, bool shared_stack)
+    :m_id(FiberIdAllocator::GetInstance()->alloc())
     ,m_cb(cb)
     ,m_hasScheduler(use_scheduler)
+    ,m_sharedMode(shared_stack)
 {
     s_fiber_count++;
 
+    if(shared_stack){
+        // 共享栈在第一次切入时才绑定，此时才知道运行在哪个线程
+        return;
+    }
     m_stacksize = stacksize ? stacksize : g_fiber_stack_size->getValue();
     m_stack = StackAlloactor::Alloc(m_stacksize);
-    if(getcontext(&m_ctx)){
-        GGO_ASSERT2(false,"getcontext");
-    }
-
-    m_ctx.uc_link = nullptr;
-    m_ctx.uc_stack.ss_sp = m_stack;
-    m_ctx.uc_stack.ss_size = m_stacksize;
 
     if(use_scheduler){
-        makecontext(&m_ctx, &Fiber::schedulerMainFunc, 0);
+        m_ctx.make(m_stack, m_stacksize, &Fiber::schedulerMainFunc);
     }else{
-        makecontext(&m_ctx, &Fiber::mainFunc, 0);
+        m_ctx.make(m_stack, m_stacksize, &Fiber::mainFunc);
     }
 
 }
@@ -76,12 +278,18 @@ Fiber::Fiber(mission cb, size_t stacksize, bool use_scheduler)
 Fiber::~Fiber()
 {
     s_fiber_count--;
-    if(m_stack){
+    if(m_id){
+        FiberIdAllocator::GetInstance()->release(m_id);
+    }
+    if(m_stack || m_sharedMode){
         //释放一般协程的资源
         GGO_ASSERT(m_state == State::TERM 
                 || m_state == State::INIT
                 || m_state == State::EXCEPT);
-        StackAlloactor::Dealloc(m_stack,m_stacksize);
+        if(m_stack){
+            StackAlloactor::Dealloc(m_stack,m_stacksize);
+        }
+        free(m_saveBuffer);
     }else{
         //主协程没有stack和cb，状态一直为运行中
         GGO_ASSERT(!m_cb);
@@ -97,57 +305,106 @@ Fiber::~Fiber()
 
 void Fiber::call()
 {
+    if(m_sharedMode){
+        switchToSharedStack();
+    }
     setThis(this);
     m_state = State::EXEC;
-    if(swapcontext(&t_threadFiber->m_ctx, &m_ctx)){
-        GGO_ASSERT2(false, "swapcontext");
-    }
+    FiberContext::swap(t_threadFiber->m_ctx, m_ctx);
 }
 
 void Fiber::back()
 {
     setThis(t_threadFiber.get());
-    if(swapcontext(&m_ctx, &t_threadFiber->m_ctx)){
-        GGO_ASSERT2(false, "swapcontext");
-    }
+    FiberContext::swap(m_ctx, t_threadFiber->m_ctx);
 }
 
 void Fiber::reset(mission cb)
 {
-    GGO_ASSERT(m_stack);
+    GGO_ASSERT(m_stack || m_sharedMode);
     GGO_ASSERT(m_state == State::TERM || m_state == State::INIT || m_state == State::EXCEPT);
 
     m_cb = cb;
 
-    if (getcontext(&m_ctx))
-    {
-        GGO_ASSERT2(false, "getcontext");
+    if(m_sharedMode){
+        // 解除绑定，下次切入时在当前线程重新绑定共享栈
+        m_sharedStack = nullptr;
+        m_stackThread = -1;
+        m_saveSize = 0;
+    }else{
+        m_ctx.make(m_stack, m_stacksize, &Fiber::mainFunc);
     }
-    m_ctx.uc_link = nullptr;
-    m_ctx.uc_stack.ss_sp = m_stack;
-    m_ctx.uc_stack.ss_size = m_stacksize;
-    makecontext(&m_ctx, &Fiber::mainFunc, 0);
 
     m_state = State::INIT;
 }
 
 void Fiber::swapIn()
 {
+    if(m_sharedMode){
+        switchToSharedStack();
+    }
     setThis(this);
     GGO_ASSERT(m_state != State::EXEC);
     m_state = State::EXEC;
-    if(swapcontext(&Scheduler::getMainFiber()->m_ctx, &m_ctx)){
-        GGO_ASSERT2(false, "swapcontext");
-    }
+    FiberContext::swap(Scheduler::getMainFiber()->m_ctx, m_ctx);
 
 }
 
 void Fiber::swapOut()
 {
     setThis(Scheduler::getMainFiber());
-    if(swapcontext(&m_ctx, &Scheduler::getMainFiber()->m_ctx)){
-        GGO_ASSERT2(false, "swapcontext");
+    FiberContext::swap(m_ctx, Scheduler::getMainFiber()->m_ctx);
+}
+
+void Fiber::switchToSharedStack()
+{
+    bool fresh = !m_sharedStack;
+    if(fresh){
+        m_sharedStack = t_shared_stacks.next();
+        m_stackThread = GGo::GetThreadID();
+        m_saveSize = 0;
+    }
+    // 共享栈上的地址只在绑定的线程内有效
+    GGO_ASSERT2(m_stackThread == GGo::GetThreadID(), "shared stack fiber resumed on another thread");
+
+    SharedStack* ss = m_sharedStack;
+    Fiber::ptr occupant = ss->occupant.lock();
+    if(occupant && occupant.get() != this){
+        occupant->saveSharedStack(ss);
+    }
+    if(fresh){
+        m_ctx.make(ss->stack, ss->size, m_hasScheduler ? &Fiber::schedulerMainFunc : &Fiber::mainFunc);
+    }else if(occupant.get() != this && m_saveSize){
+        memcpy((char*)ss->stack + ss->size - m_saveSize, m_saveBuffer, m_saveSize);
     }
+    ss->occupant = shared_from_this();
+}
+
+void Fiber::saveSharedStack(SharedStack *stack)
+{
+    if(m_sharedStack != stack
+            || m_state == State::INIT
+            || m_state == State::TERM
+            || m_state == State::EXCEPT){
+        // 已经结束或重置的协程不需要保存
+        return;
+    }
+    char* bottom = (char*)stack->stack;
+    char* top = bottom + stack->size;
+    char* sp = (char*)m_ctx.stackPointer();
+    if(sp){
+        // 留出红区，避免漏掉栈指针下方仍然有效的数据
+        sp = sp - 128 > bottom ? sp - 128 : bottom;
+    }else{
+        sp = bottom;
+    }
+    m_saveSize = top - sp;
+    if(m_saveCapacity < m_saveSize){
+        free(m_saveBuffer);
+        m_saveBuffer = (char*)malloc(m_saveSize);
+        m_saveCapacity = m_saveSize;
+    }
+    memcpy(m_saveBuffer, sp, m_saveSize);
 }
 
 uint64_t Fiber::getFiberID()
@@ -196,6 +453,65 @@ uint64_t Fiber::TotalFibers()
     return s_fiber_count;
 }
 
+uint64_t Fiber::StackPoolHits()
+{
+    return s_stack_pool_hit;
+}
+
+uint64_t Fiber::StackPoolMisses()
+{
+    return s_stack_pool_miss;
+}
+
+bool Fiber::SharedStackByDefault()
+{
+    return s_shared_stack;
+}
+
+uint64_t Fiber::CreatedFibers()
+{
+    return s_fiber_created;
+}
+
+uint64_t Fiber::ReusedFibers()
+{
+    return s_fiber_reused;
+}
+
+Fiber::ptr Fiber::Create(mission cb, bool shared_stack)
+{
+    auto& pool = t_fiber_pool[shared_stack];
+    if(!pool.empty()){
+        Fiber::ptr fiber = std::move(pool.back());
+        pool.pop_back();
+        fiber->reset(std::move(cb));
+        s_fiber_reused++;
+        return fiber;
+    }
+    s_fiber_created++;
+    return Fiber::ptr(new Fiber(std::move(cb), 0, false, shared_stack));
+}
+
+void Fiber::Recycle(Fiber::ptr &fiber)
+{
+    if(!fiber || fiber.use_count() != 1
+            || fiber->m_hasScheduler
+            || (fiber->m_state != State::TERM && fiber->m_state != State::EXCEPT)
+            || (!fiber->m_sharedMode && fiber->m_stacksize != g_fiber_stack_size->getValue())){
+        // 仍被其他地方引用、调度协程或者栈大小特殊的协程不回收
+        fiber.reset();
+        return;
+    }
+    auto& pool = t_fiber_pool[fiber->m_sharedMode];
+    if(pool.size() >= s_fiber_pool_size){
+        fiber.reset();
+        return;
+    }
+    // 提前释放任务对象持有的资源
+    fiber->reset(nullptr);
+    pool.push_back(std::move(fiber));
+}
+
 void Fiber::mainFunc()
 {
     Fiber::ptr cur = Fiber::getThis();
@@ -0,0 +1,174 @@
+#include"fiberContext.h"
+#include"macro.h"
+#include<stdint.h>
+
+#if defined(__x86_64__)
+// 栈布局（低地址到高地址）：mxcsr/x87控制字, r15, r14, r13, r12, rbx, rbp, 返回地址
+asm(R"(
+    .text
+    .globl ggo_context_swap
+    .type ggo_context_swap, @function
+    .align 16
+ggo_context_swap:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size ggo_context_swap, .-ggo_context_swap
+
+    .globl ggo_context_trampoline
+    .type ggo_context_trampoline, @function
+    .align 16
+ggo_context_trampoline:
+    callq *%r12
+    ud2
+    .size ggo_context_trampoline, .-ggo_context_trampoline
+)");
+#elif defined(__aarch64__)
+// 栈布局（低地址到高地址）：d8-d15, x19-x28, x29, x30
+asm(R"(
+    .text
+    .globl ggo_context_swap
+    .type ggo_context_swap, %function
+    .align 4
+ggo_context_swap:
+    sub sp, sp, #0xa0
+    stp d8, d9, [sp, #0x00]
+    stp d10, d11, [sp, #0x10]
+    stp d12, d13, [sp, #0x20]
+    stp d14, d15, [sp, #0x30]
+    stp x19, x20, [sp, #0x40]
+    stp x21, x22, [sp, #0x50]
+    stp x23, x24, [sp, #0x60]
+    stp x25, x26, [sp, #0x70]
+    stp x27, x28, [sp, #0x80]
+    stp x29, x30, [sp, #0x90]
+    mov x9, sp
+    str x9, [x0]
+    mov sp, x1
+    ldp d8, d9, [sp, #0x00]
+    ldp d10, d11, [sp, #0x10]
+    ldp d12, d13, [sp, #0x20]
+    ldp d14, d15, [sp, #0x30]
+    ldp x19, x20, [sp, #0x40]
+    ldp x21, x22, [sp, #0x50]
+    ldp x23, x24, [sp, #0x60]
+    ldp x25, x26, [sp, #0x70]
+    ldp x27, x28, [sp, #0x80]
+    ldp x29, x30, [sp, #0x90]
+    add sp, sp, #0xa0
+    ret
+    .size ggo_context_swap, .-ggo_context_swap
+
+    .globl ggo_context_trampoline
+    .type ggo_context_trampoline, %function
+    .align 4
+ggo_context_trampoline:
+    blr x19
+    brk #0
+    .size ggo_context_trampoline, .-ggo_context_trampoline
+)");
+#endif
+
+extern "C"{
+    /// @brief 新上下文第一次被切入时的落脚点，调用保存在寄存器中的入口函数
+    void ggo_context_trampoline();
+}
+
+namespace GGo{
+
+void UContext::init()
+{
+    if(getcontext(&m_ctx)){
+        GGO_ASSERT2(false, "getcontext");
+    }
+}
+
+void UContext::make(void *stack, size_t size, ContextEntry entry)
+{
+    if(getcontext(&m_ctx)){
+        GGO_ASSERT2(false, "getcontext");
+    }
+    m_ctx.uc_link = nullptr;
+    m_ctx.uc_stack.ss_sp = stack;
+    m_ctx.uc_stack.ss_size = size;
+    makecontext(&m_ctx, entry, 0);
+}
+
+void UContext::swap(UContext &from, UContext &to)
+{
+    if(swapcontext(&from.m_ctx, &to.m_ctx)){
+        GGO_ASSERT2(false, "swapcontext");
+    }
+}
+
+void *UContext::stackPointer() const
+{
+#if defined(__x86_64__)
+    return (void*)m_ctx.uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+    return (void*)m_ctx.uc_mcontext.sp;
+#else
+    return nullptr;
+#endif
+}
+
+#ifdef GGO_ASM_CONTEXT_SUPPORTED
+void AsmContext::make(void *stack, size_t size, ContextEntry entry)
+{
+    // 栈从高地址向低地址增长，栈顶按16字节对齐
+    uintptr_t top = ((uintptr_t)stack + size) & ~(uintptr_t)15;
+#if defined(__x86_64__)
+    // 8个槽位：控制字, r15, r14, r13, r12, rbx, rbp, 返回地址
+    // ret之后rsp = sp + 64，保持16字节对齐，trampoline中call时满足ABI要求
+    uint64_t* sp = (uint64_t*)(top - 64 - 16);
+    uint32_t* ctrl = (uint32_t*)sp;
+    ctrl[0] = 0x1F80;   // mxcsr 默认值
+    ctrl[1] = 0x037F;   // x87 控制字默认值
+    sp[1] = 0;                      // r15
+    sp[2] = 0;                      // r14
+    sp[3] = 0;                      // r13
+    sp[4] = (uint64_t)entry;        // r12
+    sp[5] = 0;                      // rbx
+    sp[6] = 0;                      // rbp
+    sp[7] = (uint64_t)&ggo_context_trampoline;
+#elif defined(__aarch64__)
+    // 20个槽位：d8-d15, x19-x28, x29, x30
+    uint64_t* sp = (uint64_t*)(top - 0xa0);
+    for(int i = 0; i < 20; i++){
+        sp[i] = 0;
+    }
+    sp[8] = (uint64_t)entry;                        // x19
+    sp[19] = (uint64_t)&ggo_context_trampoline;     // x30
+#endif
+    m_sp = sp;
+}
+#endif
+
+const char *FiberContextName()
+{
+#if defined(GGO_FIBER_ASM_CONTEXT) && defined(GGO_ASM_CONTEXT_SUPPORTED)
+    return "asm";
+#else
+    return "ucontext";
+#endif
+}
+
+}
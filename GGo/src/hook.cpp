@@ -6,6 +6,9 @@
 #include"macro.h"
 #include"fdManager.h"
 #include<sys/ioctl.h>
+#include<sys/sendfile.h>
+#include<linux/io_uring.h>
+#include<string.h>
 #include<dlfcn.h>
 
 static GGo::Logger::ptr g_logger = GGO_LOG_NAME("system");
@@ -40,6 +43,7 @@ void hook_init()
     send_f = (send_fun)dlsym(RTLD_NEXT, "send");
     sendto_f = (sendto_fun)dlsym(RTLD_NEXT, "sendto");
     sendmsg_f = (sendmsg_fun)dlsym(RTLD_NEXT, "sendmsg");
+    sendfile_f = (sendfile_fun)dlsym(RTLD_NEXT, "sendfile");
     close_f = (close_fun)dlsym(RTLD_NEXT, "close");
     fcntl_f = (fcntl_fun)dlsym(RTLD_NEXT, "fcntl");
     ioctl_f = (ioctl_fun)dlsym(RTLD_NEXT, "ioctl");
@@ -81,8 +85,37 @@ struct timer_condition
     int cancelled = 0;
 };
 
-template<typename Func, typename... Args>
-static ssize_t do_io(int fd, Func fun, const char* fun_name, uint32_t event, int timeout_type, Args&&... args)
+/// @brief 没有对应io_uring操作的调用，只能等待就绪后重试
+static bool do_uring_io(GGo::IOScheduler*, int, std::nullptr_t, uint32_t, uint64_t, int64_t&)
+{
+    return false;
+}
+
+/// @brief io_uring后端：把返回EAGAIN的操作直接交给内核完成
+/// @param prep 填写SQE的函数
+/// @param[out] rt 操作的结果
+/// @return 是否已经交给io_uring处理
+template<typename Prep>
+static bool do_uring_io(GGo::IOScheduler* ioscheduler, int fd, Prep prep, uint32_t event, uint64_t timeout, int64_t& rt)
+{
+    if(ioscheduler->getBackend() != GGo::IOScheduler::IO_URING){
+        return false;
+    }
+    if(GGo::Fiber::getThis()->isSharedStack()){
+        // 共享栈协程切出后栈会被其他协程覆盖，内核不能直接写它栈上的缓冲区
+        return false;
+    }
+    io_uring_sqe sqe;
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.fd = fd;
+    prep(sqe);
+    rt = ioscheduler->submitIO(fd, (GGo::IOScheduler::Event)event, sqe, timeout);
+    // 内核也返回EAGAIN时退回到等待就绪的方式
+    return rt != -1 || errno != EAGAIN;
+}
+
+template<typename Func, typename Prep, typename... Args>
+static ssize_t do_io(int fd, Func fun, Prep prep, const char* fun_name, uint32_t event, int timeout_type, Args&&... args)
 {
     if(!GGo::t_hook_enable){
         return fun(fd, std::forward<Args>(args)...);
@@ -119,8 +152,15 @@ static ssize_t do_io(int fd, Func fun, const char* fun_name, uint32_t event, int
             // 如果是系统中断导致的错误,则再执行一次
             rt = fun(fd, std::forward<Args>(args)...);
         }
+        if(rt != -1 || errno != EAGAIN){
+            // 成功或出现EAGAIN以外的错误（例如句柄已被关闭），不能再重试
+            break;
+        }
         if(rt == -1 && errno == EAGAIN){
             GGo::IOScheduler* ioscheduler = GGo::IOScheduler::getThis();
+            if(do_uring_io(ioscheduler, fd, prep, event, timeout, rt)){
+                return rt;
+            }
             GGo::Timer::ptr timer;
             std::weak_ptr<timer_condition> w_cond(t_cond);
 
@@ -180,6 +220,7 @@ writev_fun writev_f = nullptr;
 send_fun send_f = nullptr;
 sendto_fun sendto_f = nullptr;
 sendmsg_fun sendmsg_f = nullptr;
+sendfile_fun sendfile_f = nullptr;
 close_fun close_f = nullptr;
 fcntl_fun fcntl_f = nullptr;
 ioctl_fun ioctl_f = nullptr;
@@ -322,7 +363,11 @@ int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen){
 }
 
 int accept(int s, struct sockaddr *addr, socklen_t *addrlen){
-    int fd = do_io(s, accept_f, "accept", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, addr, addrlen);
+    int fd = do_io(s, accept_f, [=](io_uring_sqe& sqe){
+        sqe.opcode = IORING_OP_ACCEPT;
+        sqe.addr = (uint64_t)addr;
+        sqe.addr2 = (uint64_t)addrlen;
+    }, "accept", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, addr, addrlen);
     if(fd >= 0){
         GGo::FdMgr::GetInstance()->get(fd, true);
     }
@@ -330,44 +375,88 @@ int accept(int s, struct sockaddr *addr, socklen_t *addrlen){
 }
 
 ssize_t read(int fd, void *buf, size_t count){
-    return do_io(fd, read_f, "read", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, buf, count);
+    return do_io(fd, read_f, [=](io_uring_sqe& sqe){
+        sqe.opcode = IORING_OP_READ;
+        sqe.addr = (uint64_t)buf;
+        sqe.len = count;
+        sqe.off = -1;
+    }, "read", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, buf, count);
 }
 
 ssize_t readv(int fd, const struct iovec *iov, int iovcnt){
-    return do_io(fd, readv_f, "readv", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, iov, iovcnt);
+    return do_io(fd, readv_f, [=](io_uring_sqe& sqe){
+        sqe.opcode = IORING_OP_READV;
+        sqe.addr = (uint64_t)iov;
+        sqe.len = iovcnt;
+        sqe.off = -1;
+    }, "readv", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, iov, iovcnt);
 }
 
 ssize_t recv(int sockfd, void *buf, size_t len, int flags){
-    return do_io(sockfd, recv_f, "recv", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, buf, len, flags);
+    return do_io(sockfd, recv_f, [=](io_uring_sqe& sqe){
+        sqe.opcode = IORING_OP_RECV;
+        sqe.addr = (uint64_t)buf;
+        sqe.len = len;
+        sqe.msg_flags = flags;
+    }, "recv", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, buf, len, flags);
 }
 
 ssize_t recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen){
-    return do_io(sockfd, recvfrom_f, "recvfrom", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, buf, len, flags, src_addr, addrlen);
+    return do_io(sockfd, recvfrom_f, nullptr, "recvfrom", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, buf, len, flags, src_addr, addrlen);
 }
 
 ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags){
-    return do_io(sockfd, recvmsg_f, "recvmsg", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, msg, flags);
+    return do_io(sockfd, recvmsg_f, [=](io_uring_sqe& sqe){
+        sqe.opcode = IORING_OP_RECVMSG;
+        sqe.addr = (uint64_t)msg;
+        sqe.len = 1;
+        sqe.msg_flags = flags;
+    }, "recvmsg", GGo::IOScheduler::Event::READ, SO_RCVTIMEO, msg, flags);
 }
 
 // write
 ssize_t write(int fd, const void *buf, size_t count){
-    return do_io(fd, write_f, "write", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, buf, count);
+    return do_io(fd, write_f, [=](io_uring_sqe& sqe){
+        sqe.opcode = IORING_OP_WRITE;
+        sqe.addr = (uint64_t)buf;
+        sqe.len = count;
+        sqe.off = -1;
+    }, "write", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, buf, count);
 }
 
 ssize_t writev(int fd, const struct iovec *iov, int iovcnt){
-    return do_io(fd, writev_f, "writev", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, iov, iovcnt);
+    return do_io(fd, writev_f, [=](io_uring_sqe& sqe){
+        sqe.opcode = IORING_OP_WRITEV;
+        sqe.addr = (uint64_t)iov;
+        sqe.len = iovcnt;
+        sqe.off = -1;
+    }, "writev", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, iov, iovcnt);
 }
 
 ssize_t send(int s, const void *msg, size_t len, int flags){
-    return do_io(s, send_f, "send", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, msg, len, flags);
+    return do_io(s, send_f, [=](io_uring_sqe& sqe){
+        sqe.opcode = IORING_OP_SEND;
+        sqe.addr = (uint64_t)msg;
+        sqe.len = len;
+        sqe.msg_flags = flags;
+    }, "send", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, msg, len, flags);
 }
 
 ssize_t sendto(int s, const void *msg, size_t len, int flags, const struct sockaddr *to, socklen_t tolen){
-    return do_io(s, sendto_f, "sendto", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, msg, len, flags, to, tolen);
+    return do_io(s, sendto_f, nullptr, "sendto", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, msg, len, flags, to, tolen);
 }
 
 ssize_t sendmsg(int s, const struct msghdr *msg, int flags){
-    return do_io(s, sendmsg_f, "sendmsg", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, msg, flags);
+    return do_io(s, sendmsg_f, [=](io_uring_sqe& sqe){
+        sqe.opcode = IORING_OP_SENDMSG;
+        sqe.addr = (uint64_t)msg;
+        sqe.len = 1;
+        sqe.msg_flags = flags;
+    }, "sendmsg", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, msg, flags);
+}
+
+ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count){
+    return do_io(out_fd, sendfile_f, nullptr, "sendfile", GGo::IOScheduler::Event::WRITE, SO_SNDTIMEO, in_fd, offset, count);
 }
 
 // io_control
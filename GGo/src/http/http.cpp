@@ -1,5 +1,6 @@
 #include "http.h"
 #include "util.h"
+#include <charconv>
 
 namespace GGo{
 namespace HTTP{
@@ -324,6 +325,78 @@ void HTTPRequest::initCookies()
     m_parserParamFlag |= 0x4;
 
 }
+HTTPRequestView::HTTPRequestView()
+    :m_method(HTTPMethod::GET)
+    ,m_version(0x11)
+{
+    // 大部分请求的头部不超过16个，避免解析中扩容
+    m_headers.reserve(16);
+}
+
+void HTTPRequestView::setBody(std::string&& body)
+{
+    m_bodyStorage = std::move(body);
+    m_body = m_bodyStorage;
+}
+
+std::string_view HTTPRequestView::getHeader(std::string_view key, std::string_view def) const
+{
+    std::string_view val;
+    return hasHeader(key, &val) ? val : def;
+}
+
+bool HTTPRequestView::hasHeader(std::string_view key, std::string_view* val) const
+{
+    for(auto& i : m_headers){
+        if(i.first.size() == key.size()
+                && strncasecmp(i.first.data(), key.data(), key.size()) == 0){
+            if(val){
+                *val = i.second;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t HTTPRequestView::getContentLength() const
+{
+    std::string_view val = getHeader("content-length");
+    uint64_t length = 0;
+    for(char c : val){
+        if(c < '0' || c > '9'){
+            return 0;
+        }
+        length = length * 10 + (c - '0');
+    }
+    return length;
+}
+
+bool HTTPRequestView::isAutoClose() const
+{
+    std::string_view connection = getHeader("connection");
+    if(connection.empty()){
+        return true;
+    }
+    return !(connection.size() == 10 && strncasecmp(connection.data(), "keep-alive", 10) == 0);
+}
+
+HTTPRequest::ptr HTTPRequestView::toRequest() const
+{
+    HTTPRequest::ptr request(new HTTPRequest);
+    request->setMethod(m_method);
+    request->setVersion(m_version);
+    request->setPath(std::string(m_path));
+    request->setQuery(std::string(m_query));
+    request->setFrgment(std::string(m_fragment));
+    for(auto& i : m_headers){
+        request->setHeader(std::string(i.first), std::string(i.second));
+    }
+    request->setBody(std::string(m_body));
+    request->init();
+    return request;
+}
+
 HTTPResponse::HTTPResponse(uint8_t version, bool auto_close)
     :m_status(HTTPStatus::OK)
     ,m_version(version)
@@ -372,40 +445,56 @@ void HTTPResponse::setCookie(const std::string &key, const std::string &val, tim
 
 std::ostream &HTTPResponse::dump(std::ostream &os) const
 {
-    os << "HTTP/"
-        << ((uint32_t)(m_version >> 4))
-        << "."
-        << ((uint32_t)(m_version & 0X0F))
-        << " "
-        << ((uint32_t)m_status)
-        << " "
-        << (m_reasons.empty() ? HTTPStatusToString(m_status) : m_reasons)
-        << "\r\n";
-    
-    for(auto header_item : m_headers){
+    std::string header;
+    serializeHeader(header);
+    return os << header << m_body;
+}
+
+/// @brief 追加十进制整数
+static void appendNumber(std::string& buffer, uint64_t value)
+{
+    char str[24];
+    auto rt = std::to_chars(str, str + sizeof(str), value);
+    buffer.append(str, rt.ptr - str);
+}
+
+void HTTPResponse::serializeHeader(std::string &buffer) const
+{
+    buffer.append("HTTP/");
+    appendNumber(buffer, m_version >> 4);
+    buffer.push_back('.');
+    appendNumber(buffer, m_version & 0x0F);
+    buffer.push_back(' ');
+    appendNumber(buffer, (uint32_t)m_status);
+    buffer.push_back(' ');
+    buffer.append(m_reasons.empty() ? HTTPStatusToString(m_status) : m_reasons);
+    buffer.append("\r\n");
+
+    for(auto& header_item : m_headers){
         if(!m_isWebsocket && strcasecmp(header_item.first.c_str(), "connection") == 0){
             continue;
         }
-        os << header_item.first << ": " << header_item.second << "\r\n";
+        buffer.append(header_item.first).append(": ").append(header_item.second).append("\r\n");
     }
 
-    for(auto cookie_item : m_cookies){
-        os << "Set-Cookie: " << cookie_item << "\r\n";
+    for(auto& cookie_item : m_cookies){
+        buffer.append("Set-Cookie: ").append(cookie_item).append("\r\n");
     }
 
     if(!m_isWebsocket){
-        os << "connection: " << (m_autoClose ? "close" : "keep-alive") << "\r\n";
+        buffer.append("connection: ").append(m_autoClose ? "close" : "keep-alive").append("\r\n");
     }
 
-    if(!m_body.empty()){
-        os << "content-length: " << m_body.size() << "\r\n\r\n";
-        os << m_body;
-    }else{
-        os << "\r\n";
+    uint64_t length = m_fileBody ? m_fileBody->length : m_body.size();
+    if((length || !m_isWebsocket) && m_headers.find("content-length") == m_headers.end()){
+        // 保持连接时客户端依靠长度区分相邻的响应
+        buffer.append("content-length: ");
+        appendNumber(buffer, length);
+        buffer.append("\r\n");
     }
-    
-    return os;
+    buffer.append("\r\n");
 }
+
 std::string HTTPResponse::toString() const
 {
     std::stringstream ss;
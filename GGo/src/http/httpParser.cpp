@@ -38,6 +38,10 @@ void on_request_method(void* data, const char* at, size_t len){
         parser->setError(1000);
         return;
     }
+    if(parser->getView()){
+        parser->getView()->setMethod(method);
+        return;
+    }
     parser->getData()->setMethod(method);
 }
 
@@ -47,16 +51,28 @@ void on_request_uri(void* data, const char* at, size_t len){
 
 void on_request_fragment(void* data, const char* at, size_t len){
     HTTPRequestParser* parser = static_cast<HTTPRequestParser*>(data);
+    if(parser->getView()){
+        parser->getView()->setFragment(std::string_view(at, len));
+        return;
+    }
     parser->getData()->setFrgment(std::string(at, len));
 }
 
 void on_request_path(void* data, const char* at, size_t len){
     HTTPRequestParser* parser = static_cast<HTTPRequestParser*>(data);
+    if(parser->getView()){
+        parser->getView()->setPath(std::string_view(at, len));
+        return;
+    }
     parser->getData()->setPath(std::string(at, len));
 }
 
 void on_request_query(void *data, const char *at, size_t length) {
     HTTPRequestParser* parser = static_cast<HTTPRequestParser*>(data);
+    if(parser->getView()){
+        parser->getView()->setQuery(std::string_view(at, length));
+        return;
+    }
     parser->getData()->setQuery(std::string(at, length));
 }
 
@@ -73,6 +89,10 @@ void on_request_version(void* data, const char* at, size_t len){
         parser->setError(1001);
         return;
     }
+    if(parser->getView()){
+        parser->getView()->setVersion(version);
+        return;
+    }
     parser->getData()->setVersion(version);
 }
 
@@ -87,14 +107,21 @@ void on_request_http_field(void* data, const char* field, size_t flen, const cha
         parser->setError(1002);
         return;
     }
+    if(parser->getView()){
+        parser->getView()->addHeader(std::string_view(field, flen), std::string_view(value, vlen));
+        return;
+    }
     parser->getData()->setHeader(std::string(field, flen), std::string(value, vlen));
 }
 
 
-HTTPRequestParser::HTTPRequestParser()
+HTTPRequestParser::HTTPRequestParser(bool view)
     :m_error(0)
+    ,m_isView(view)
 {
-    m_request.reset(new GGo::HTTP::HTTPRequest);
+    if(!view){
+        m_request.reset(new GGo::HTTP::HTTPRequest);
+    }
     http_parser_init(&m_parser);
 
     m_parser.request_method = on_request_method;
@@ -110,6 +137,12 @@ HTTPRequestParser::HTTPRequestParser()
 
 size_t HTTPRequestParser::excute(char *data, size_t len)
 {
+    if(m_isView){
+        m_view.reset(new GGo::HTTP::HTTPRequestView);
+        m_error = 0;
+        http_parser_init(&m_parser);
+        return http_parser_execute(&m_parser, data, len, 0);
+    }
     size_t offset = http_parser_execute(&m_parser, data, len, 0);
     memmove(data, data + offset, len - offset);
     return offset;
@@ -127,6 +160,9 @@ int HTTPRequestParser::hasError()
 
 uint64_t HTTPRequestParser::getContentLength()
 {
+    if(m_isView){
+        return m_view ? m_view->getContentLength() : 0;
+    }
     return m_request->getHeaderAs<uint64_t>("content-length", 0);
 }
 
@@ -10,72 +10,188 @@ HTTPSession::HTTPSession(Socket::ptr socket, bool isOwner)
 }
 HTTPRequest::ptr HTTPSession::recvRequest()
 {
-    HTTPRequestParser::ptr parser(new HTTPRequestParser);
-    uint64_t buffer_size = HTTPRequestParser::getHTTPRequestBufferSize();
+    HTTPRequestView::ptr view = recvRequestView();
+    return view ? view->toRequest() : nullptr;
+}
+
+HTTPRequestView::ptr HTTPSession::recvRequestView()
+{
+    return parseRequest(true);
+}
+
+HTTPRequest::ptr HTTPSession::recvBufferedRequest()
+{
+    HTTPRequestView::ptr view = recvBufferedRequestView();
+    return view ? view->toRequest() : nullptr;
+}
 
-    std::shared_ptr<char> buffer(new char[buffer_size], [](char* ptr){
-        delete[] ptr;
-    });
-    char* data = buffer.get();
-    int offset = 0;
+HTTPRequestView::ptr HTTPSession::recvBufferedRequestView()
+{
+    if(m_readPos == m_writePos){
+        return nullptr;
+    }
+    return parseRequest(false);
+}
+
+HTTPRequestView::ptr HTTPSession::parseRequest(bool block)
+{
+    if(m_readPos == m_writePos){
+        compact();
+    }
+    HTTPRequestParser parser(true);
+    char* data = m_buffer.get();
+    // 请求头的长度，解析出的字段都指向缓存，不能移动数据
+    size_t nparse = 0;
     do{
-        int len = read(data + offset, buffer_size - offset);
-        if(len <= 0) {
-            close();
-            return nullptr;
+        if(m_writePos > m_readPos){
+            nparse = parser.excute(data + m_readPos, m_writePos - m_readPos);
+            if(parser.hasError()) {
+                // 留给阻塞的接收处理，之前的请求的响应还要发送
+                if(!block){
+                    return nullptr;
+                }
+                close();
+                return nullptr;
+            }
+            if(parser.isFinished()) {
+                break;
+            }
         }
-        len += offset;
-        size_t nparse = parser->excute(data, len);
-        if(parser->hasError()) {
-            close();
+        if(!block){
             return nullptr;
         }
-        offset = len - nparse;
-        if(offset == (int)buffer_size) {
+        if(m_writePos == m_bufferSize){
+            if(m_readPos == 0){
+                // 请求头超过缓存大小
+                close();
+                return nullptr;
+            }
+            compact();
+            data = m_buffer.get();
+        }
+        int rt = read(data + m_writePos, m_bufferSize - m_writePos);
+        if(rt <= 0) {
             close();
             return nullptr;
         }
-        if(parser->isFinished()) {
-            break;
-        }
-
+        m_writePos += rt;
     }while(true);
-    
-    int64_t content_length = parser->getContentLength();
-    
-    if(content_length > 0){
-        std::string body;
-        body.resize(content_length);
 
-        int len = 0;
-        if(len >= offset){
-            memcpy(&body[0], data, offset);
-            len = offset;
+    HTTPRequestView::ptr view = parser.getView();
+    view->setBuffer(m_buffer);
+    size_t body_start = m_readPos + nparse;
+    uint64_t content_length = parser.getContentLength();
+    if(!block && content_length > m_writePos - body_start){
+        return nullptr;
+    }
+    m_readPos = body_start;
+    if(content_length > 0){
+        size_t offset = m_writePos - body_start;
+        if(content_length <= m_bufferSize - body_start){
+            // 消息体放得下时接着读到缓存里
+            if(offset < content_length){
+                if(readFixSize(data + m_writePos, content_length - offset) <= 0){
+                    close();
+                    return nullptr;
+                }
+                m_writePos = body_start + content_length;
+            }
+            view->setBody(std::string_view(data + body_start, content_length));
+            m_readPos = body_start + content_length;
         }else{
-            memcpy(&body[0], data, content_length);
-            len = content_length;
-        }
-        content_length -= offset;
-        if(content_length  > 0){
-            if(readFixSize(&body[len], content_length) <= 0){
+            std::string body;
+            body.resize(content_length);
+            memcpy(&body[0], data + body_start, offset);
+            if(readFixSize(&body[offset], content_length - offset) <= 0){
                 close();
                 return nullptr;
             }
+            view->setBody(std::move(body));
+            m_readPos = m_writePos;
         }
     }
+    return view;
+}
 
-    parser->getData()->init();
-    return parser->getData();
+void HTTPSession::compact()
+{
+    size_t left = m_writePos - m_readPos;
+    // 缓存大小配置变小时也要放得下未处理的数据
+    uint64_t buffer_size = std::max(HTTPRequestParser::getHTTPRequestBufferSize(), (uint64_t)left);
+    if(m_buffer && m_buffer.use_count() == 1 && m_bufferSize == buffer_size){
+        if(left){
+            memmove(m_buffer.get(), m_buffer.get() + m_readPos, left);
+        }
+    }else{
+        std::shared_ptr<char> buffer(new char[buffer_size], [](char* ptr){
+            delete[] ptr;
+        });
+        if(left){
+            memcpy(buffer.get(), m_buffer.get() + m_readPos, left);
+        }
+        m_buffer = buffer;
+        m_bufferSize = buffer_size;
+    }
+    m_readPos = 0;
+    m_writePos = left;
+}
 
+int64_t HTTPSession::sendResponse(HTTPResponse::ptr response)
+{
+    return sendResponses(&response, 1);
 }
-int HTTPSession::sendResponse(HTTPResponse::ptr response)
+
+int64_t HTTPSession::sendResponses(const std::vector<HTTPResponse::ptr>& responses)
 {
-    std::stringstream ss;
-    ss << response->toString();
-    std::string data = ss.str();
-    return writeFixSize(data.c_str(), data.size());
+    return sendResponses(responses.data(), responses.size());
 }
 
+int64_t HTTPSession::sendResponses(const HTTPResponse::ptr* responses, size_t count)
+{
+    m_headerBuffer.clear();
+    m_headerEnds.clear();
+    for(size_t i = 0; i < count; i++){
+        responses[i]->serializeHeader(m_headerBuffer);
+        m_headerEnds.push_back(m_headerBuffer.size());
+    }
+    // 头部全部写完后缓存不再扩容，才能取地址
+    m_iovs.clear();
+    int64_t total = m_headerBuffer.size();
+    size_t begin = 0;
+    for(size_t i = 0; i < count; i++){
+        m_iovs.push_back({&m_headerBuffer[begin], m_headerEnds[i] - begin});
+        begin = m_headerEnds[i];
+        HTTPFileBody::ptr file = responses[i]->getFileBody();
+        if(file){
+            // 先写出之前的数据，再由内核直接发送文件内容
+            int64_t rt = writevFixSize(&m_iovs[0], m_iovs.size());
+            if(rt <= 0){
+                return rt;
+            }
+            m_iovs.clear();
+            if(file->length){
+                rt = sendFileFixSize(file->fd, file->offset, file->length);
+                if(rt <= 0){
+                    return rt;
+                }
+                total += file->length;
+            }
+            continue;
+        }
+        const std::string& body = responses[i]->getBody();
+        if(!body.empty()){
+            m_iovs.push_back({(void*)body.data(), body.size()});
+            total += body.size();
+        }
+    }
+    if(!m_iovs.empty()){
+        int64_t rt = writevFixSize(&m_iovs[0], m_iovs.size());
+        if(rt <= 0){
+            return rt;
+        }
+    }
+    return total;
+}
 }
 
 }
\ No newline at end of file
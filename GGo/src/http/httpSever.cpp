@@ -1,5 +1,6 @@
 #include "http/httpSever.h"
 #include "logSystem.h"
+#include "config.h"
 #include "httpSever.h"
 #include "http/servlets/configServlet.h"
 #include "http/servlets/statusServlet.h"
@@ -8,6 +9,10 @@ namespace HTTP{
 
 static GGo::Logger::ptr g_logger = GGO_LOG_NAME("system");
 
+static GGo::ConfigVar<uint32_t>::ptr g_http_pipeline_batch =
+    GGo::Config::Lookup("http.pipeline_batch", (uint32_t)64,
+            "max pipelined responses flushed in one writev");
+
 HTTPSever::HTTPSever(bool keepalive, 
                     GGo::IOScheduler *worker, 
                     GGo::IOScheduler *io_worker, 
@@ -32,6 +37,7 @@ void HTTPSever::handleCilent(Socket::ptr cilent)
 {
     GGO_LOG_DEBUG(g_logger) << "handlerCilent: " << *cilent;
     HTTPSession::ptr session(new HTTPSession(cilent));
+    std::vector<HTTPResponse::ptr> responses;
     do{
         auto req = session->recvRequest();
         if(!req){
@@ -41,13 +47,27 @@ void HTTPSever::handleCilent(Socket::ptr cilent)
             break;
         }
 
-        HTTPResponse::ptr rsp(new HTTPResponse(req->getVersion(),
-                                                req->isAutoClose() || !m_isKeepAlive));
-        rsp->setHeader("Sever", getName());
-        m_dispatch->handle(req,rsp, session);
-        session->sendResponse(rsp);
+        // 同一次读入的后续请求（流水线）依次处理，响应一起发送
+        uint32_t batch = g_http_pipeline_batch->getValue();
+        bool close = false;
+        responses.clear();
+        while(req){
+            HTTPResponse::ptr rsp(new HTTPResponse(req->getVersion(),
+                                                    req->isAutoClose() || !m_isKeepAlive));
+            rsp->setHeader("Sever", getName());
+            m_dispatch->handle(req,rsp, session);
+            responses.push_back(rsp);
 
-        if(!m_isKeepAlive || req->isAutoClose()){
+            if(!m_isKeepAlive || req->isAutoClose()){
+                close = true;
+                break;
+            }
+            if(responses.size() >= batch){
+                break;
+            }
+            req = session->recvBufferedRequest();
+        }
+        if(session->sendResponses(responses) <= 0 || close){
             break;
         }
     }while(true);
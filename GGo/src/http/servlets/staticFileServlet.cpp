@@ -0,0 +1,325 @@
+#include "http/servlets/staticFileServlet.h"
+#include "logSystem.h"
+#include "util.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+namespace GGo{
+namespace HTTP{
+
+static GGo::Logger::ptr g_logger = GGO_LOG_NAME("system");
+
+/// @brief 按扩展名得到Content-Type
+static const char* getContentType(const std::string& path)
+{
+    static const std::unordered_map<std::string, const char*> s_types = {
+        {"html", "text/html; charset=utf-8"},
+        {"htm", "text/html; charset=utf-8"},
+        {"css", "text/css; charset=utf-8"},
+        {"js", "application/javascript; charset=utf-8"},
+        {"json", "application/json"},
+        {"txt", "text/plain; charset=utf-8"},
+        {"xml", "text/xml; charset=utf-8"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"svg", "image/svg+xml"},
+        {"ico", "image/x-icon"},
+        {"webp", "image/webp"},
+        {"pdf", "application/pdf"},
+        {"wasm", "application/wasm"},
+        {"woff", "font/woff"},
+        {"woff2", "font/woff2"},
+        {"mp4", "video/mp4"},
+    };
+    size_t pos = path.rfind('.');
+    if(pos != std::string::npos && path.find('/', pos) == std::string::npos){
+        std::string ext = path.substr(pos + 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        auto it = s_types.find(ext);
+        if(it != s_types.end()){
+            return it->second;
+        }
+    }
+    return "application/octet-stream";
+}
+
+/// @brief 格式化为HTTP日期
+static std::string toHTTPDate(time_t ts)
+{
+    struct tm tm;
+    gmtime_r(&ts, &tm);
+    char buf[64];
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+/// @brief 解析HTTP日期，失败返回-1
+static time_t fromHTTPDate(const std::string& str)
+{
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    const char* end = strptime(str.c_str(), "%a, %d %b %Y %H:%M:%S", &tm);
+    if(!end){
+        return -1;
+    }
+    return timegm(&tm);
+}
+
+/// @brief 解析十进制数字，全部是数字且不为空时返回true
+static bool parseNumber(const std::string& str, uint64_t& value)
+{
+    if(str.empty() || str.size() > 19 || str.find_first_not_of("0123456789") != std::string::npos){
+        return false;
+    }
+    value = std::stoull(str);
+    return true;
+}
+
+/// @brief 解析单个区间的Range头部
+/// @param[out] begin 区间起始位置
+/// @param[out] end 区间结束位置（包含）
+/// @return 1 有效区间，0 格式不支持按完整文件返回，-1 区间无法满足
+static int parseRange(const std::string& range, uint64_t size, uint64_t& begin, uint64_t& end)
+{
+    if(range.compare(0, 6, "bytes=") != 0 || range.find(',') != std::string::npos){
+        return 0;
+    }
+    size_t dash = range.find('-', 6);
+    if(dash == std::string::npos){
+        return 0;
+    }
+    std::string first = GGo::StringUtil::trim(range.substr(6, dash - 6));
+    std::string last = GGo::StringUtil::trim(range.substr(dash + 1));
+    uint64_t a = 0, b = 0;
+    if(first.empty()){
+        // 最后b个字节
+        if(!parseNumber(last, b)){
+            return 0;
+        }
+        if(b == 0 || size == 0){
+            return -1;
+        }
+        begin = size > b ? size - b : 0;
+        end = size - 1;
+        return 1;
+    }
+    if(!parseNumber(first, a)){
+        return 0;
+    }
+    if(last.empty()){
+        b = size - 1;
+    }else if(!parseNumber(last, b) || b < a){
+        return 0;
+    }
+    if(a >= size){
+        return -1;
+    }
+    begin = a;
+    end = std::min(b, size - 1);
+    return 1;
+}
+
+/// @brief If-None-Match中是否包含etag
+static bool matchETag(const std::string& header, const std::string& etag)
+{
+    if(GGo::StringUtil::trim(header) == "*"){
+        return true;
+    }
+    size_t pos = 0;
+    while(pos < header.size()){
+        size_t comma = header.find(',', pos);
+        std::string item = GGo::StringUtil::trim(header.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos));
+        // 弱比较，忽略W/前缀
+        if(item.compare(0, 2, "W/") == 0){
+            item = item.substr(2);
+        }
+        if(item == etag){
+            return true;
+        }
+        if(comma == std::string::npos){
+            break;
+        }
+        pos = comma + 1;
+    }
+    return false;
+}
+
+StaticFileServlet::File::~File()
+{
+    if(fd != -1){
+        close(fd);
+    }
+}
+
+StaticFileServlet::StaticFileServlet(const std::string& root, const std::string& prefix
+                                    , uint64_t cache_ms, size_t max_cached)
+    :servlet("StaticFileServlet")
+    ,m_root(root)
+    ,m_prefix(prefix)
+    ,m_cacheMs(cache_ms)
+    ,m_maxCached(max_cached)
+{
+    while(m_root.size() > 1 && m_root.back() == '/'){
+        m_root.pop_back();
+    }
+}
+
+std::string StaticFileServlet::toFilePath(const std::string& uri) const
+{
+    if(uri.compare(0, m_prefix.size(), m_prefix) != 0){
+        return "";
+    }
+    std::string path = GGo::StringUtil::urlDecode(uri.substr(m_prefix.size()), false);
+    if(path.find('\0') != std::string::npos){
+        return "";
+    }
+    // 不允许通过..跳出根目录
+    size_t pos = 0;
+    while(pos <= path.size()){
+        size_t slash = path.find('/', pos);
+        if(slash == std::string::npos){
+            slash = path.size();
+        }
+        if(path.compare(pos, slash - pos, "..") == 0){
+            return "";
+        }
+        pos = slash + 1;
+    }
+    if(path.empty() || path.back() == '/'){
+        path += "index.html";
+    }
+    if(path[0] != '/'){
+        path = "/" + path;
+    }
+    return m_root + path;
+}
+
+StaticFileServlet::File::ptr StaticFileServlet::getFile(const std::string& path)
+{
+    uint64_t now = GGo::getCurrentMS();
+    File::ptr file;
+    {
+        RWMutexType::readLock lock(m_mutex);
+        auto it = m_files.find(path);
+        if(it != m_files.end()){
+            file = it->second;
+        }
+    }
+    if(file && now - file->checked < m_cacheMs){
+        return file;
+    }
+
+    struct stat st;
+    if(stat(path.c_str(), &st) || !S_ISREG(st.st_mode)){
+        if(file){
+            RWMutexType::writeLock lock(m_mutex);
+            m_files.erase(path);
+        }
+        return nullptr;
+    }
+    if(file && file->st.st_ino == st.st_ino && file->st.st_size == st.st_size
+            && file->st.st_mtim.tv_sec == st.st_mtim.tv_sec
+            && file->st.st_mtim.tv_nsec == st.st_mtim.tv_nsec){
+        file->checked = now;
+        return file;
+    }
+
+    // 文件不存在于缓存或者已经变化，重新打开
+    File::ptr newFile = std::make_shared<File>();
+    newFile->fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(newFile->fd == -1 || fstat(newFile->fd, &newFile->st) || !S_ISREG(newFile->st.st_mode)){
+        GGO_LOG_WARN(g_logger) << "StaticFileServlet open file=" << path
+                               << " errno=" << errno << " errstr=" << strerror(errno);
+        return nullptr;
+    }
+    char etag[64];
+    snprintf(etag, sizeof(etag), "\"%lx-%lx\"", (unsigned long)newFile->st.st_size
+            , (unsigned long)(newFile->st.st_mtim.tv_sec * 1000000 + newFile->st.st_mtim.tv_nsec / 1000));
+    newFile->etag = etag;
+    newFile->lastModified = toHTTPDate(newFile->st.st_mtim.tv_sec);
+    newFile->checked = now;
+
+    RWMutexType::writeLock lock(m_mutex);
+    if(m_files.size() >= m_maxCached){
+        m_files.clear();
+    }
+    m_files[path] = newFile;
+    return newFile;
+}
+
+int32_t StaticFileServlet::handle(GGo::HTTP::HTTPRequest::ptr request
+                                , GGo::HTTP::HTTPResponse::ptr response
+                                , GGo::HTTP::HTTPSession::ptr session)
+{
+    HTTPMethod method = request->getMethod();
+    if(method != HTTPMethod::GET && method != HTTPMethod::HEAD){
+        response->setStatus(HTTPStatus::METHOD_NOT_ALLOWED);
+        response->setHeader("Allow", "GET, HEAD");
+        return 0;
+    }
+    std::string path = toFilePath(request->getPath());
+    File::ptr file = path.empty() ? nullptr : getFile(path);
+    if(!file){
+        response->setStatus(HTTPStatus::NOT_FOUND);
+        response->setHeader("Content-Type", "text/plain; charset=utf-8");
+        response->setBody("404 Not Found");
+        return 0;
+    }
+
+    uint64_t size = file->st.st_size;
+    response->setHeader("Last-Modified", file->lastModified);
+    response->setHeader("ETag", file->etag);
+    response->setHeader("Accept-Ranges", "bytes");
+
+    // 优先按ETag判断，没有If-None-Match时才看修改时间
+    std::string value;
+    bool not_modified = false;
+    if(request->hasHeader("If-None-Match", &value)){
+        not_modified = matchETag(value, file->etag);
+    }else if(request->hasHeader("If-Modified-Since", &value)){
+        time_t since = fromHTTPDate(value);
+        not_modified = since != -1 && file->st.st_mtim.tv_sec <= since;
+    }
+    if(not_modified){
+        response->setStatus(HTTPStatus::NOT_MODIFIED);
+        response->setHeader("content-length", std::to_string(size));
+        return 0;
+    }
+
+    response->setHeader("Content-Type", getContentType(path));
+    uint64_t begin = 0;
+    uint64_t end = size ? size - 1 : 0;
+    int range = 0;
+    if(request->hasHeader("Range", &value)){
+        // If-Range与当前文件不符时返回完整文件
+        std::string if_range;
+        if(!request->hasHeader("If-Range", &if_range)
+                || if_range == file->etag || if_range == file->lastModified){
+            range = parseRange(value, size, begin, end);
+        }
+    }
+    if(range < 0){
+        response->setStatus(HTTPStatus::RANGE_NOT_SATISFIABLE);
+        response->setHeader("Content-Range", "bytes */" + std::to_string(size));
+        return 0;
+    }
+    uint64_t length = size ? end - begin + 1 : 0;
+    if(range > 0){
+        response->setStatus(HTTPStatus::PARTIAL_CONTENT);
+        response->setHeader("Content-Range", "bytes " + std::to_string(begin) + "-"
+                            + std::to_string(end) + "/" + std::to_string(size));
+    }
+    if(method == HTTPMethod::HEAD){
+        response->setHeader("content-length", std::to_string(length));
+        return 0;
+    }
+    // 句柄由缓存项持有，发送完之前缓存项不会被释放
+    response->setFileBody(std::make_shared<HTTPFileBody>(file->fd, begin, length, file));
+    return 0;
+}
+
+}
+}
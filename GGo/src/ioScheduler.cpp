@@ -1,13 +1,58 @@
 #include"ioScheduler.h"
+#include"ioUring.h"
 #include "macro.h"
+#include "config.h"
 #include<unistd.h>
+#include<poll.h>
 #include<sys/epoll.h>
+#include<sys/eventfd.h>
 #include<fcntl.h>
 
 namespace GGo{
 
 static GGo::Logger::ptr g_logger = GGO_LOG_NAME("system");
 
+static ConfigVar<bool>::ptr g_per_thread_epoll =
+    Config::Lookup<bool>("io_scheduler.per_thread_epoll", false, "every io scheduler worker owns its epoll instance and fd table");
+
+static ConfigVar<bool>::ptr g_per_thread_timer =
+    Config::Lookup<bool>("io_scheduler.per_thread_timer", false, "every io scheduler worker owns its timers, requires a per-thread poller");
+
+static ConfigVar<std::string>::ptr g_io_backend =
+    Config::Lookup<std::string>("io_scheduler.backend", "epoll", "io scheduler backend: epoll or io_uring");
+
+static ConfigVar<uint32_t>::ptr g_uring_entries =
+    Config::Lookup<uint32_t>("io_scheduler.uring_entries", 256, "io_uring submission queue size of every worker");
+
+/// @brief 不需要处理的完成事件（取消请求、链接的超时）
+static const uint64_t URING_IGNORE = 0;
+/// @brief tickle用eventfd的就绪事件
+static const uint64_t URING_TICKLE = 1;
+
+/// @brief io_uring中一次未完成的请求
+struct IOScheduler::UringRequest{
+    /// @brief 请求类型
+    enum Type{
+        // 直接提交的IO，保存在发起协程的栈上
+        IO,
+        // addEvent注册的单次就绪监听，完成后释放
+        POLL,
+    };
+    Type type = IO;
+    // 所属的句柄上下文与事件
+    FdContext* fd_ctx = nullptr;
+    Event event = NONE;
+    // 内核返回的结果
+    int32_t result = 0;
+    // 是否被cancelEvent/cancelAll主动取消
+    bool cancelled = false;
+    // 等待结果的协程及其调度器
+    Fiber::ptr fiber;
+    Scheduler* scheduler = nullptr;
+    // 链接的超时时间
+    __kernel_timespec ts;
+};
+
 
 IOScheduler::FdContext::EventContext& IOScheduler::FdContext::getContext(Event event)
 {
@@ -29,15 +74,17 @@ void IOScheduler::FdContext::resetContext(EventContext &ctx)
     ctx.fiber.reset();
     return;
 }
-void IOScheduler::FdContext::tiggerEvent(IOScheduler::Event event)
+void IOScheduler::FdContext::tiggerEvent(IOScheduler::Event event, Scheduler* home, int thread)
 {
     GGO_ASSERT(events & event);
     events = (Event)(events & ~event);
     EventContext& ctx = getContext(event);
+    // 只有事件属于句柄所在的调度器时，才能固定到句柄所在的线程上
+    int target = ctx.scheduler == home ? thread : -1;
     if(ctx.cb){
-        ctx.scheduler->schedule(&ctx.cb);
+        ctx.scheduler->schedule(&ctx.cb, target);
     }else{
-        ctx.scheduler->schedule(&ctx.fiber);
+        ctx.scheduler->schedule(&ctx.fiber, target);
     }
     ctx.scheduler = nullptr;
     return;
@@ -66,25 +113,54 @@ inline IOScheduler::Event& operator&=(IOScheduler::Event &lhs, IOScheduler::Even
 // TODO:: ?????
 IOScheduler::IOScheduler(size_t thread_pool_size, bool use_caller, const std::string &name)
     : Scheduler(thread_pool_size, use_caller, name)
+    , m_perThread(g_per_thread_epoll->getValue())
 {
-    m_epollFd = epoll_create(5000);
-    GGO_ASSERT( m_epollFd > 0);
-
-    int rt = pipe(m_tickleFds);
-    GGO_ASSERT(!rt);
-
-    epoll_event event;
-    memset(&event, 0, sizeof(epoll_event));
-    event.events = EPOLLIN | EPOLLET;
-    event.data.fd = m_tickleFds[0];
-    
-    rt = fcntl(m_tickleFds[0], F_SETFL, O_NONBLOCK);
-    GGO_ASSERT(!rt);
-
-    rt = epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_tickleFds[0], &event);
-    GGO_ASSERT(!rt);
-
-    contextResize(32);
+    if(g_io_backend->getValue() == "io_uring"){
+        if(IOUring::IsSupported()){
+            // 一个环只能由一个线程等待完成事件，io_uring总是每线程一个
+            m_backend = IO_URING;
+            m_perThread = true;
+        }else{
+            GGO_LOG_WARN(g_logger) << name << " io_uring not supported, fall back to epoll";
+        }
+    }
+    size_t count = m_perThread ? getQueueCount() : 1;
+    m_pollers.resize(count);
+    for(size_t i = 0; i < count; i++){
+        Poller* poller = new Poller;
+        m_pollers[i].reset(poller);
+
+        poller->tickleFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        GGO_ASSERT(poller->tickleFd >= 0);
+
+        if(m_backend == IO_URING){
+            poller->uring.reset(new IOUring(g_uring_entries->getValue()));
+            GGO_ASSERT(poller->uring->isValid());
+            uringArmTickle(*poller);
+        }else{
+            poller->epfd = epoll_create(5000);
+            GGO_ASSERT(poller->epfd > 0);
+
+            // 边沿触发：每次write都会产生一次新的事件，因此不需要读空计数器
+            // epoll_wait的等待者是互斥唤醒的，一次write只会唤醒一个睡眠线程
+            epoll_event event;
+            memset(&event, 0, sizeof(epoll_event));
+            event.events = EPOLLIN | EPOLLET;
+            event.data.ptr = poller;
+
+            int rt = epoll_ctl(poller->epfd, EPOLL_CTL_ADD, poller->tickleFd, &event);
+            GGO_ASSERT(!rt);
+        }
+    }
+    if(g_per_thread_timer->getValue()){
+        if(m_perThread){
+            // 私有存储的消息需要精确唤醒拥有者线程，只有每线程poller能做到
+            m_perThreadTimer = true;
+            initTimerStores(getQueueCount());
+        }else{
+            GGO_LOG_WARN(g_logger) << name << " per-thread timers require a per-thread poller, use shared timers";
+        }
+    }
     //创建完毕直接启动
     start();
 
@@ -94,28 +170,61 @@ IOScheduler::~IOScheduler()
 {
     //关闭内部句柄
     stop();
-    close(m_epollFd);
-    close(m_tickleFds[0]);
-    close(m_tickleFds[1]);
-
-    for(size_t i = 0; i < m_fdContexts.size(); i++){
-        delete m_fdContexts[i];
-        m_fdContexts[i] = nullptr;
+    for(auto& poller : m_pollers){
+        if(poller->epfd >= 0){
+            close(poller->epfd);
+        }
+        close(poller->tickleFd);
+        poller->fdContexts.foreach([](int fd, std::atomic<FdContext*>& fd_ctx){
+            delete fd_ctx.load(std::memory_order_relaxed);
+        });
     }
 }
+size_t IOScheduler::localPollerIndex(int fd) const
+{
+    if(!m_perThread){
+        return 0;
+    }
+    int index = currentQueueIndex();
+    if(index != -1 && getQueueOwner(index) != m_rootThread){
+        return index;
+    }
+    // 调用线程的poller只在stop()时才被轮询，外部线程与调用线程的事件分给工作线程
+    size_t count = m_pollers.size();
+    if(m_rootThread != -1 && count > 1){
+        return 1 + fd % (count - 1);
+    }
+    return fd % count;
+}
+IOScheduler::FdContext* IOScheduler::getFdContext(size_t index, int fd, bool auto_create)
+{
+    std::atomic<FdContext*>* slot = m_pollers[index]->fdContexts.get(fd, auto_create);
+    if(GGO_UNLIKELY(!slot)){
+        if(auto_create){
+            GGO_LOG_ERROR(g_logger) << "getFdContext fd= " << fd << " out of range";
+        }
+        return nullptr;
+    }
+    FdContext* fd_ctx = slot->load(std::memory_order_acquire);
+    if(fd_ctx || !auto_create){
+        return fd_ctx;
+    }
+    // 并发创建时只保留第一个
+    FdContext* created = new FdContext;
+    created->fd = fd;
+    if(slot->compare_exchange_strong(fd_ctx, created, std::memory_order_acq_rel)){
+        return created;
+    }
+    delete created;
+    return fd_ctx;
+}
 int IOScheduler::addEvent(int fd, Event event, std::function<void()> cb)
 {
-    FdContext* fd_ctx = nullptr;
-    // 为句柄容器上锁
-    RWMutexType::readLock lock(m_mutex);
-    if((int)m_fdContexts.size() > fd){
-        fd_ctx = m_fdContexts[fd];
-        lock.unlock();
-    }else{
-        lock.unlock();
-        RWMutexType::writeLock lock2(m_mutex);
-        contextResize(fd * 2);
-        fd_ctx = m_fdContexts[fd];
+    size_t index = localPollerIndex(fd);
+    Poller& poller = *m_pollers[index];
+    FdContext* fd_ctx = getFdContext(index, fd, true);
+    if(GGO_UNLIKELY(!fd_ctx)){
+        return -1;
     }
     // 为句柄上下文上锁
     FdContext::mutexType::Lock lockf(fd_ctx->m_mutex);
@@ -126,17 +235,30 @@ int IOScheduler::addEvent(int fd, Event event, std::function<void()> cb)
                                 << "fd_ctx.events= " << (EPOLL_EVENTS)fd_ctx->events;
         GGO_ASSERT(!(fd_ctx->events & event));
     }
-    int op = fd_ctx->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
-    epoll_event epevent;
-    epevent.events = EPOLLET | fd_ctx->events | event;
-    epevent.data.ptr = fd_ctx;
-
-    int rt = epoll_ctl(m_epollFd, op, fd, &epevent);
-    if(rt){
-        GGO_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epollFd << ", "
-                                << op << ", " << fd << ", " <<(EPOLL_EVENTS)epevent.events << "): "
-                                << rt << "(" << errno << ") (" << strerror(errno) << ") fd_ctx_events= " << (EPOLL_EVENTS)fd_ctx->events; 
-        return -1;
+    if(m_backend == IO_URING){
+        // 每个事件一个单次POLL_ADD请求，完成后在idle中触发
+        UringRequest* request = new UringRequest;
+        request->type = UringRequest::POLL;
+        request->fd_ctx = fd_ctx;
+        request->event = event;
+        if(!uringArm(index, request, fd, event)){
+            delete request;
+            return -1;
+        }
+        fd_ctx->getContext(event).request = request;
+    }else{
+        int op = fd_ctx->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        epoll_event epevent;
+        epevent.events = EPOLLET | fd_ctx->events | event;
+        epevent.data.ptr = fd_ctx;
+
+        int rt = epoll_ctl(poller.epfd, op, fd, &epevent);
+        if(rt){
+            GGO_LOG_ERROR(g_logger) << "epoll_ctl(" << poller.epfd << ", "
+                                    << op << ", " << fd << ", " <<(EPOLL_EVENTS)epevent.events << "): "
+                                    << rt << "(" << errno << ") (" << strerror(errno) << ") fd_ctx_events= " << (EPOLL_EVENTS)fd_ctx->events; 
+            return -1;
+        }
     }
 
     m_pendingEventCount++;
@@ -156,124 +278,206 @@ int IOScheduler::addEvent(int fd, Event event, std::function<void()> cb)
 }
 bool IOScheduler::delEvent(int fd, Event event)
 {
-    RWMutex::readLock lock(m_mutex);
-    if((int)m_fdContexts.size() <= fd){
-        return false;
-    }
-    FdContext* fd_ctx = m_fdContexts[fd];
-    lock.unlock();
+    // 协程可能在不同线程上注册过同一个句柄，从本线程的poller开始查找
+    size_t local = localPollerIndex(fd);
+    for(size_t i = 0; i < m_pollers.size(); i++){
+        size_t index = (local + i) % m_pollers.size();
+        Poller& poller = *m_pollers[index];
+        FdContext* fd_ctx = getFdContext(index, fd, false);
+        if(!fd_ctx){
+            continue;
+        }
 
-    FdContext::mutexType::Lock lockfd(fd_ctx->m_mutex);
-    if(GGO_UNLIKELY(!(fd_ctx->events & ~event))){
-        //TODO::为什么如果不含除了evenrt以外的事件则直接退出，确保fd_ctx内部至少有一个事件
-        return false;
-    }
-    // 取消对event事件的监听
-    Event new_events = (Event)(fd_ctx->events & event);
-    int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
-    epoll_event epevent;
-    epevent.events = EPOLLET | new_events;
-    epevent.data.ptr = fd_ctx;
-
-    int rt = epoll_ctl(m_epollFd, op, fd, &epevent);
-    if(rt){
-        GGO_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epollFd << ", "
-                                << op << ", " << fd << ", " << (EPOLL_EVENTS)epevent.events << "): " << rt << " (" << errno << ") ("
-                                << strerror(errno) << ")";
-        return false;
+        FdContext::mutexType::Lock lockfd(fd_ctx->m_mutex);
+        if(!(fd_ctx->events & event)){
+            continue;
+        }
+        if(m_backend == IO_URING){
+            uringCancel(index, fd_ctx, event, false);
+            return true;
+        }
+        // 取消对event事件的监听
+        Event new_events = (Event)(fd_ctx->events & ~event);
+        int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
+        epoll_event epevent;
+        epevent.events = EPOLLET | new_events;
+        epevent.data.ptr = fd_ctx;
+
+        int rt = epoll_ctl(poller.epfd, op, fd, &epevent);
+        if(rt){
+            GGO_LOG_ERROR(g_logger) << "epoll_ctl(" << poller.epfd << ", "
+                                    << op << ", " << fd << ", " << (EPOLL_EVENTS)epevent.events << "): " << rt << " (" << errno << ") ("
+                                    << strerror(errno) << ")";
+            return false;
+        }
+        // 重置socket句柄上下文的对应事件上下文
+        m_pendingEventCount--;
+        fd_ctx->events = new_events;
+        FdContext::EventContext& event_ctx = fd_ctx->getContext(event);
+        event_ctx.scheduler = nullptr;
+        fd_ctx->resetContext(event_ctx);
+        return true;
     }
-    // 重置socket句柄上下文的对应事件上下文
-    m_pendingEventCount--;
-    fd_ctx->events = new_events;
-    FdContext::EventContext& event_ctx = fd_ctx->getContext(event);
-    fd_ctx->resetContext(event_ctx);
-    return true;
+    return false;
 
 }
 bool IOScheduler::cancelEvent(int fd, Event event)
 {
-    RWMutexType::readLock lock(m_mutex);
-    if((int)m_fdContexts.size() <= fd){
-        return false;
-    }
-    FdContext* fd_ctx = m_fdContexts[fd];
-    lock.unlock();
+    size_t local = localPollerIndex(fd);
+    for(size_t i = 0; i < m_pollers.size(); i++){
+        size_t index = (local + i) % m_pollers.size();
+        Poller& poller = *m_pollers[index];
+        FdContext* fd_ctx = getFdContext(index, fd, false);
+        if(!fd_ctx){
+            continue;
+        }
 
-    FdContext::mutexType::Lock lockfd(fd_ctx->m_mutex);
-    if(GGO_UNLIKELY(!(fd_ctx->events & ~event))){
-        return false;
-    }
+        FdContext::mutexType::Lock lockfd(fd_ctx->m_mutex);
+        if(!(fd_ctx->events & event)){
+            continue;
+        }
+        if(m_backend == IO_URING){
+            uringCancel(index, fd_ctx, event, true);
+            return true;
+        }
 
-    Event new_events = (Event)(fd_ctx->events & event);
-    int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
-    epoll_event epevent;
-    epevent.events = EPOLLET | new_events;
-    epevent.data.ptr = fd_ctx;
+        Event new_events = (Event)(fd_ctx->events & ~event);
+        int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
+        epoll_event epevent;
+        epevent.events = EPOLLET | new_events;
+        epevent.data.ptr = fd_ctx;
+
+        int rt = epoll_ctl(poller.epfd, op, fd, &epevent);
+        if(rt){
+            GGO_LOG_ERROR(g_logger) << "epoll_ctl(" << poller.epfd << ", "
+                                    << op << ", " << fd << ", " << (EPOLL_EVENTS)epevent.events << "): " << rt << " (" << errno << ") ("
+                                    << strerror(errno) << ")";
+            return false;
+        }
 
-    int rt = epoll_ctl(m_epollFd, op, fd, &epevent);
-    if(rt){
-        GGO_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epollFd << ", "
-                                << op << ", " << fd << ", " << (EPOLL_EVENTS)epevent.events << "): " << rt << " (" << errno << ") ("
-                                << strerror(errno) << ")";
-        return false;
+        fd_ctx->tiggerEvent(event, this, m_perThread ? getQueueOwner(index) : -1);
+        m_pendingEventCount--;
+        return true;
     }
-
-    fd_ctx->tiggerEvent(event);
-    m_pendingEventCount--;
     return false;
 
 
 }
 bool IOScheduler::cancelAll(int fd)
 {
-    RWMutexType::readLock lock(m_mutex);
-    if((int)m_fdContexts.size() <= fd){
-        return false;
-    }
-    FdContext* fd_ctx = m_fdContexts[fd];
-    lock.unlock();
-
-    FdContext::mutexType::Lock lockfd(fd_ctx->m_mutex);
-    if(!(fd_ctx->events)){
-        return false;
-    }
+    bool cancelled = false;
+    for(size_t index = 0; index < m_pollers.size(); index++){
+        Poller& poller = *m_pollers[index];
+        FdContext* fd_ctx = getFdContext(index, fd, false);
+        if(!fd_ctx){
+            continue;
+        }
 
-    int op = EPOLL_CTL_DEL;
-    epoll_event epevent;
-    epevent.events = 0x0;
-    epevent.data.ptr = fd_ctx;
+        FdContext::mutexType::Lock lockfd(fd_ctx->m_mutex);
+        if(!(fd_ctx->events)){
+            continue;
+        }
+        if(m_backend == IO_URING){
+            if(fd_ctx->events & Event::READ){
+                uringCancel(index, fd_ctx, Event::READ, true);
+            }
+            if(fd_ctx->events & Event::WRITE){
+                uringCancel(index, fd_ctx, Event::WRITE, true);
+            }
+            cancelled = true;
+            continue;
+        }
 
-    int rt = epoll_ctl(m_epollFd, op, fd, &epevent);
-    if(rt){
-        GGO_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epollFd << ", "
-                                << op << ", " << fd << ", " << (EPOLL_EVENTS)epevent.events << "): " << rt << " (" << errno << ") ("
-                                << strerror(errno) << ")";
-        return false;
-    }
+        int op = EPOLL_CTL_DEL;
+        epoll_event epevent;
+        epevent.events = 0x0;
+        epevent.data.ptr = fd_ctx;
+
+        int rt = epoll_ctl(poller.epfd, op, fd, &epevent);
+        if(rt){
+            GGO_LOG_ERROR(g_logger) << "epoll_ctl(" << poller.epfd << ", "
+                                    << op << ", " << fd << ", " << (EPOLL_EVENTS)epevent.events << "): " << rt << " (" << errno << ") ("
+                                    << strerror(errno) << ")";
+            continue;
+        }
 
-    if(fd_ctx->events & Event::READ){
-        fd_ctx->tiggerEvent(Event::READ);
-        m_pendingEventCount--;
-    }
-    if(fd_ctx->events & Event::WRITE){
-        fd_ctx->tiggerEvent(Event::WRITE);
-        m_pendingEventCount--;
+        int thread = m_perThread ? getQueueOwner(index) : -1;
+        if(fd_ctx->events & Event::READ){
+            fd_ctx->tiggerEvent(Event::READ, this, thread);
+            m_pendingEventCount--;
+        }
+        if(fd_ctx->events & Event::WRITE){
+            fd_ctx->tiggerEvent(Event::WRITE, this, thread);
+            m_pendingEventCount--;
+        }
+        GGO_ASSERT(fd_ctx->events == 0);
+        cancelled = true;
     }
-    GGO_ASSERT(fd_ctx->events == 0);
-    return true;
+    return cancelled;
 }
 IOScheduler *IOScheduler::getThis()
 {
     return dynamic_cast<IOScheduler*>(Scheduler::getThis());
 }
+std::vector<int> IOScheduler::getPollerThreads() const
+{
+    std::vector<int> threads;
+    for(size_t i = 0; i < getQueueCount(); i++){
+        int thread = getQueueOwner(i);
+        if(thread != -1 && thread != m_rootThread){
+            threads.push_back(thread);
+        }
+    }
+    return threads;
+}
+bool IOScheduler::wakeup(Poller &poller)
+{
+    if(!m_isStopping && poller.tickled.exchange(true)){
+        // 已经有一个唤醒在路上，被唤醒的线程如果发现还有剩余任务会继续唤醒下一个
+        return false;
+    }
+    uint64_t one = 1;
+    int rt = write(poller.tickleFd, &one, sizeof(one));
+    GGO_ASSERT(rt == sizeof(one));
+    return true;
+}
 void IOScheduler::tickle()
 {
-    if(!hasIdleThread()){
+    if(m_sleepingThreadCount == 0){
+        // 没有线程在epoll_wait中睡眠，醒着的线程睡眠前会再检查一次任务队列
+        return;
+    }
+    if(!m_perThread){
+        wakeup(*m_pollers[0]);
+        return;
+    }
+    // 每线程模式：轮转找到一个正在睡眠的线程，停止时唤醒全部
+    static thread_local size_t t_next_poller = 0;
+    size_t count = m_pollers.size();
+    size_t start = t_next_poller++;
+    for(size_t i = 0; i < count; i++){
+        Poller& poller = *m_pollers[(start + i) % count];
+        if(!poller.sleeping){
+            continue;
+        }
+        wakeup(poller);
+        if(!m_isStopping){
+            return;
+        }
+    }
+}
+
+void IOScheduler::tickleThread(int thread)
+{
+    int index = m_perThread ? queueIndexOf(thread) : -1;
+    if(index == -1){
+        tickle();
         return;
     }
-    // 如果有空闲线程，通知它们有新任务了
-    int rt = write(m_tickleFds[1], "T", 1);
-    GGO_ASSERT(rt == 1);
+    Poller& poller = *m_pollers[index];
+    if(poller.sleeping){
+        wakeup(poller);
+    }
 }
 
 void IOScheduler::idle()
@@ -284,13 +488,23 @@ void IOScheduler::idle()
         delete[] ptr;
     });
 
+    // 每线程模式下只等待自己的epoll实例，就绪事件固定回本线程执行
+    size_t index = m_perThread ? currentQueueIndex() : 0;
+    Poller& poller = *m_pollers[index];
+    int self_thread = m_perThread ? GGo::GetThreadID() : -1;
+
     while(true){
         //无限循环idling………
         uint64_t next_timeout = 0;
+        // 刚执行完一批任务，先刷新缓存时间再计算睡眠时长，否则定时器会被推迟
+        updateCoarseClock();
         if(GGO_UNLIKELY(canStopNow(next_timeout))){
             // 可以结束，退出待机协程
             // GGO_LOG_INFO(g_logger) << "name= " << IOScheduler::getName()
             //                         << " idle ended and exit idle fiber";
+            // 一次只会唤醒一个线程，退出前接力唤醒下一个仍在睡眠的线程
+            tickle();
+            clearCoarseClock();
             break;
         }
         int rt = 0;
@@ -304,7 +518,32 @@ void IOScheduler::idle()
                 next_timeout = MAX_TIMEOUT;
             }
 
-            rt = epoll_wait(m_epollFd, events,MAX_EVENTS,next_timeout);
+            // 先登记睡眠再检查任务队列，与tickle中先入队再检查睡眠线程的顺序配合，避免丢失唤醒
+            m_sleepingThreadCount++;
+            if(m_perThread){
+                poller.sleeping = true;
+            }
+            if(hasMisson()){
+                next_timeout = 0;
+            }
+            if(m_backend == IO_URING){
+                {
+                    // 本线程攒下的SQE在睡眠前一次提交
+                    Mutex::Lock lock(poller.uringMutex);
+                    poller.uring->flush();
+                }
+                rt = poller.uring->wait(next_timeout);
+                if(rt < 0){
+                    errno = -rt;
+                    rt = -1;
+                }
+            }else{
+                rt = epoll_wait(poller.epfd, events,MAX_EVENTS,next_timeout);
+            }
+            if(m_perThread){
+                poller.sleeping = false;
+            }
+            m_sleepingThreadCount--;
             if(rt < 0 && errno == EINTR){
                     // 调用被中断，再次尝试即可
             }else{
@@ -312,18 +551,28 @@ void IOScheduler::idle()
             }
 
         }while(true);
+        // 每次唤醒刷新一次缓存时间，本轮的定时器与任务都读取它
+        updateCoarseClock();
         //获取到事件
         std::vector<std::function<void()>>cbs;
         listExpriedCb(cbs);
         if(!cbs.empty()){
-            schedule(cbs.begin(),cbs.end());
+            // 私有存储的定时器回调留在拥有者线程上执行
+            schedule(cbs.begin(),cbs.end(), m_perThreadTimer ? self_thread : -1);
             cbs.clear();
         }
+        if(m_backend == IO_URING){
+            poller.uring->forEachCqe([&](const io_uring_cqe& cqe){
+                uringComplete(poller, cqe.user_data, cqe.res, cqe.flags, self_thread);
+            });
+            // 环的返回值是提交数量，不是epoll事件
+            rt = 0;
+        }
         for(int i = 0; i < rt; i++){
             epoll_event& event = events[i];
-            if(event.data.fd == m_tickleFds[0]){
-                uint8_t dummy[256];
-                while(read(m_tickleFds[0],dummy,sizeof(dummy)) > 0);
+            if(event.data.ptr == &poller){
+                // 被tickle唤醒，允许下一次tickle再发出唤醒
+                poller.tickled = false;
                 continue;
             }
 
@@ -347,20 +596,20 @@ void IOScheduler::idle()
             int left_events = fd_ctx->events & ~real_events;
             int op = left_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
             event.events = EPOLLET | left_events;
-            int rt2 = epoll_ctl(m_epollFd, op, fd_ctx->fd, &event);
+            int rt2 = epoll_ctl(poller.epfd, op, fd_ctx->fd, &event);
             if(rt2){
-                GGO_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epollFd << ", "
+                GGO_LOG_ERROR(g_logger) << "epoll_ctl(" << poller.epfd << ", "
                                         << op << ", " << fd_ctx->fd << ", " << (EPOLL_EVENTS)event.events << "): " << rt << " (" << errno << ") ("
                                         << strerror(errno) << ")";
                 continue;
             }
 
             if(real_events & Event::READ){
-                fd_ctx->tiggerEvent(Event::READ);
+                fd_ctx->tiggerEvent(Event::READ, this, self_thread);
                 m_pendingEventCount--;
             }
             if(real_events & Event::WRITE){
-                fd_ctx->tiggerEvent(Event::WRITE);
+                fd_ctx->tiggerEvent(Event::WRITE, this, self_thread);
                 m_pendingEventCount--;
             }
 
@@ -375,15 +624,206 @@ void IOScheduler::idle()
 
 }
 
-void IOScheduler::contextResize(size_t size)
+ssize_t IOScheduler::submitIO(int fd, Event event, const io_uring_sqe &sqe, uint64_t timeout)
 {
-    m_fdContexts.resize(size);
-    for(size_t i = 0; i < m_fdContexts.size(); i++){
-        if(!m_fdContexts[i]){
-            m_fdContexts[i] = new FdContext;
-            m_fdContexts[i]->fd = i;
+    GGO_ASSERT(m_backend == IO_URING);
+    size_t index = localPollerIndex(fd);
+    Poller& poller = *m_pollers[index];
+    FdContext* fd_ctx = getFdContext(index, fd, true);
+    if(GGO_UNLIKELY(!fd_ctx)){
+        errno = EAGAIN;
+        return -1;
+    }
+
+    // 请求保存在协程栈上，完成事件返回前协程不会恢复
+    UringRequest request;
+    request.type = UringRequest::IO;
+    request.fd_ctx = fd_ctx;
+    request.event = event;
+    request.fiber = Fiber::getThis();
+    request.scheduler = Scheduler::getThis();
+    {
+        FdContext::mutexType::Lock lockfd(fd_ctx->m_mutex);
+        if(GGO_UNLIKELY(fd_ctx->events & event)){
+            GGO_LOG_ERROR(g_logger) << "submitIO assert fd= " << fd
+                                    << "event= " << (EPOLL_EVENTS)event
+                                    << "fd_ctx.events= " << (EPOLL_EVENTS)fd_ctx->events;
+            GGO_ASSERT(!(fd_ctx->events & event));
+        }
+        bool has_timeout = timeout != ~0ull;
+        Mutex::Lock lock(poller.uringMutex);
+        io_uring_sqe* op = getSqes(poller, has_timeout ? 2 : 1);
+        if(GGO_UNLIKELY(!op)){
+            errno = EAGAIN;
+            return -1;
         }
+        *op = sqe;
+        op->user_data = (uint64_t)&request;
+        if(has_timeout){
+            // 超时后内核取消前一个请求，它以-ECANCELED完成
+            op->flags |= IOSQE_IO_LINK;
+            request.ts.tv_sec = timeout / 1000;
+            request.ts.tv_nsec = (timeout % 1000) * 1000000;
+            io_uring_sqe* link = poller.uring->getSqe();
+            link->opcode = IORING_OP_LINK_TIMEOUT;
+            link->fd = -1;
+            link->addr = (uint64_t)&request.ts;
+            link->len = 1;
+            link->user_data = URING_IGNORE;
+        }
+        if(!isOwner(index)){
+            // 拥有者线程在睡眠前统一提交，其他线程只能立即提交
+            poller.uring->submit();
+        }
+        fd_ctx->events = (Event)(fd_ctx->events | event);
+        fd_ctx->getContext(event).request = &request;
+        m_pendingEventCount++;
+    }
+
+    Fiber::yieldToHold();
+
+    if(request.result == -ECANCELED){
+        errno = request.cancelled ? ECANCELED : ETIMEDOUT;
+        return -1;
+    }
+    if(request.result < 0){
+        errno = -request.result;
+        return -1;
     }
+    return request.result;
+}
+
+io_uring_sqe *IOScheduler::getSqes(Poller &poller, uint32_t count)
+{
+    IOUring& uring = *poller.uring;
+    while(uring.space() < count){
+        int rt = uring.submit();
+        if(rt < 0 && rt != -EINTR){
+            GGO_LOG_ERROR(g_logger) << "io_uring_enter submit errno=" << -rt
+                                    << " errstr=" << strerror(-rt);
+            return nullptr;
+        }
+    }
+    return uring.getSqe();
+}
+
+bool IOScheduler::uringArm(size_t index, UringRequest *request, int fd, Event event)
+{
+    Poller& poller = *m_pollers[index];
+    Mutex::Lock lock(poller.uringMutex);
+    io_uring_sqe* sqe = getSqes(poller, 1);
+    if(GGO_UNLIKELY(!sqe)){
+        return false;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = event == Event::READ ? POLLIN : POLLOUT;
+    sqe->user_data = (uint64_t)request;
+    if(!isOwner(index)){
+        poller.uring->submit();
+    }
+    return true;
+}
+
+void IOScheduler::uringCancel(size_t index, FdContext *fd_ctx, Event event, bool trigger)
+{
+    Poller& poller = *m_pollers[index];
+    FdContext::EventContext& event_ctx = fd_ctx->getContext(event);
+    UringRequest* request = event_ctx.request;
+    GGO_ASSERT(request);
+    {
+        // 取消请求本身的完成事件不需要处理，被取消的请求随后以-ECANCELED完成
+        Mutex::Lock lock(poller.uringMutex);
+        io_uring_sqe* sqe = getSqes(poller, 1);
+        if(GGO_LIKELY(sqe)){
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = (uint64_t)request;
+            sqe->user_data = URING_IGNORE;
+            poller.uring->submit();
+        }
+    }
+    if(request->type == UringRequest::IO){
+        // 内核可能还在写协程的缓冲区，等完成事件返回后再恢复协程
+        request->cancelled = true;
+        return;
+    }
+    // 监听请求与协程无关，直接触发或移除，完成事件到达时只释放请求
+    event_ctx.request = nullptr;
+    if(trigger){
+        fd_ctx->tiggerEvent(event, this, getQueueOwner(index));
+    }else{
+        fd_ctx->events = (Event)(fd_ctx->events & ~event);
+        event_ctx.scheduler = nullptr;
+        fd_ctx->resetContext(event_ctx);
+    }
+}
+
+void IOScheduler::uringComplete(Poller &poller, uint64_t user_data, int32_t res, uint32_t flags, int thread)
+{
+    if(user_data == URING_IGNORE){
+        return;
+    }
+    if(user_data == URING_TICKLE){
+        // 被tickle唤醒，允许下一次tickle再发出唤醒
+        poller.tickled = false;
+        if(res < 0){
+            // 注册失败时重新注册只会立刻再次失败，事件循环会空转，此后只靠等待超时醒来
+            GGO_LOG_ERROR(g_logger) << "io_uring tickle poll failed, res=" << res
+                                    << " errstr=" << strerror(-res);
+        }else if(!(flags & IORING_CQE_F_MORE)){
+            // 多次监听被内核终止（例如CQ溢出），重新注册
+            uringArmTickle(poller);
+        }
+        return;
+    }
+
+    UringRequest* request = (UringRequest*)user_data;
+    FdContext* fd_ctx = request->fd_ctx;
+    Event event = request->event;
+    if(request->type == UringRequest::IO){
+        {
+            FdContext::mutexType::Lock lock(fd_ctx->m_mutex);
+            FdContext::EventContext& event_ctx = fd_ctx->getContext(event);
+            if(event_ctx.request == request){
+                event_ctx.request = nullptr;
+                fd_ctx->events = (Event)(fd_ctx->events & ~event);
+            }
+        }
+        request->result = res;
+        Fiber::ptr fiber;
+        fiber.swap(request->fiber);
+        Scheduler* scheduler = request->scheduler;
+        m_pendingEventCount--;
+        // 协程恢复后request随栈失效，之后不能再访问
+        scheduler->schedule(fiber, scheduler == this ? thread : -1);
+        return;
+    }
+
+    {
+        FdContext::mutexType::Lock lock(fd_ctx->m_mutex);
+        FdContext::EventContext& event_ctx = fd_ctx->getContext(event);
+        if(event_ctx.request == request){
+            // 出错或挂断也触发事件，由协程重试时得到具体错误
+            event_ctx.request = nullptr;
+            fd_ctx->tiggerEvent(event, this, thread);
+        }
+    }
+    m_pendingEventCount--;
+    delete request;
+}
+
+void IOScheduler::uringArmTickle(Poller &poller)
+{
+    Mutex::Lock lock(poller.uringMutex);
+    io_uring_sqe* sqe = getSqes(poller, 1);
+    GGO_ASSERT(sqe);
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = poller.tickleFd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = URING_TICKLE;
+    poller.uring->submit();
 }
 
 
@@ -396,6 +836,22 @@ void IOScheduler::onTimerInsertedAtFront()
 {
     tickle();
 }
+int IOScheduler::getTimerStore() const
+{
+    if(!m_perThreadTimer){
+        return -1;
+    }
+    int index = currentQueueIndex();
+    if(index == -1 || getQueueOwner(index) == m_rootThread){
+        // 调用线程只在stop()时才进入调度，它的定时器交给共享存储
+        return -1;
+    }
+    return index;
+}
+void IOScheduler::onTimerMessage(size_t index)
+{
+    tickleThread(getQueueOwner(index));
+}
 bool IOScheduler::canStopNow(uint64_t &timeout)
 {
     timeout = getNextTimer();
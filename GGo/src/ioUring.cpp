@@ -0,0 +1,178 @@
+#include"ioUring.h"
+#include"logSystem.h"
+#include<sys/mman.h>
+#include<sys/syscall.h>
+#include<sys/eventfd.h>
+#include<poll.h>
+#include<unistd.h>
+#include<string.h>
+#include<errno.h>
+
+namespace GGo{
+
+static GGo::Logger::ptr g_logger = GGO_LOG_NAME("system");
+
+IOUring::IOUring(uint32_t entries)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = syscall(__NR_io_uring_setup, entries, &params);
+    if(fd < 0){
+        GGO_LOG_WARN(g_logger) << "io_uring_setup(" << entries << ") errno=" << errno
+                               << " errstr=" << strerror(errno);
+        return;
+    }
+    if(!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP)){
+        // 等待超时依赖EXT_ARG，CQ溢出不丢事件依赖NODROP（5.11+）
+        GGO_LOG_WARN(g_logger) << "io_uring features=" << params.features << " not supported";
+        ::close(fd);
+        return;
+    }
+
+    // SQ与CQ环共用一次mmap（IORING_FEAT_SINGLE_MMAP，5.4+）
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    m_ringSize = sq_size > cq_size ? sq_size : cq_size;
+    m_ringPtr = mmap(nullptr, m_ringSize, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if(m_ringPtr == MAP_FAILED){
+        GGO_LOG_WARN(g_logger) << "io_uring mmap ring errno=" << errno;
+        m_ringPtr = nullptr;
+        ::close(fd);
+        return;
+    }
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if(sqes == MAP_FAILED){
+        GGO_LOG_WARN(g_logger) << "io_uring mmap sqes errno=" << errno;
+        munmap(m_ringPtr, m_ringSize);
+        m_ringPtr = nullptr;
+        ::close(fd);
+        return;
+    }
+    m_sqes = (io_uring_sqe*)sqes;
+
+    char* ring = (char*)m_ringPtr;
+    m_sqHead = (uint32_t*)(ring + params.sq_off.head);
+    m_sqTail = (uint32_t*)(ring + params.sq_off.tail);
+    m_sqArray = (uint32_t*)(ring + params.sq_off.array);
+    m_sqMask = *(uint32_t*)(ring + params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_sqeTail = *m_sqTail;
+
+    m_cqHead = (uint32_t*)(ring + params.cq_off.head);
+    m_cqTail = (uint32_t*)(ring + params.cq_off.tail);
+    m_cqes = (io_uring_cqe*)(ring + params.cq_off.cqes);
+    m_cqMask = *(uint32_t*)(ring + params.cq_off.ring_mask);
+
+    // SQE下标与数组下标一一对应，之后无需再写array
+    for(uint32_t i = 0; i < m_sqEntries; i++){
+        m_sqArray[i] = i;
+    }
+    m_fd = fd;
+}
+
+IOUring::~IOUring()
+{
+    if(m_sqes){
+        munmap(m_sqes, m_sqesSize);
+    }
+    if(m_ringPtr){
+        munmap(m_ringPtr, m_ringSize);
+    }
+    if(m_fd >= 0){
+        ::close(m_fd);
+    }
+}
+
+io_uring_sqe *IOUring::getSqe()
+{
+    uint32_t head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    if(m_sqeTail - head >= m_sqEntries){
+        return nullptr;
+    }
+    io_uring_sqe* sqe = &m_sqes[m_sqeTail & m_sqMask];
+    m_sqeTail++;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+uint32_t IOUring::space() const
+{
+    return m_sqEntries - (m_sqeTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE));
+}
+
+void IOUring::flush()
+{
+    __atomic_store_n(m_sqTail, m_sqeTail, __ATOMIC_RELEASE);
+}
+
+int IOUring::submit()
+{
+    flush();
+    if(space() == m_sqEntries){
+        return 0;
+    }
+    return enter(m_sqEntries, 0, 0, nullptr, 0);
+}
+
+int IOUring::wait(uint64_t timeout_ms)
+{
+    __kernel_timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+    io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = (uint64_t)&ts;
+    // to_submit取容量即可，内核只会提交已发布的SQE
+    return enter(m_sqEntries, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+int IOUring::enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags, void *arg, size_t argsz)
+{
+    int rt = syscall(__NR_io_uring_enter, m_fd, to_submit, min_complete, flags, arg, argsz);
+    return rt < 0 ? -errno : rt;
+}
+
+bool IOUring::IsSupported()
+{
+    static bool s_supported = Probe();
+    return s_supported;
+}
+
+bool IOUring::Probe()
+{
+    IOUring uring(2);
+    if(!uring.isValid()){
+        return false;
+    }
+    // 唤醒用的多次监听POLL_ADD需要5.13+，更早的内核返回-EINVAL且不带F_MORE，
+    // 重新注册会让事件循环空转，只能使用epoll
+    int fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(fd < 0){
+        return false;
+    }
+    io_uring_sqe* sqe = uring.getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    int rt = uring.submit();
+    if(rt == 1){
+        rt = uring.wait(1000);
+    }
+    bool multishot = false;
+    int32_t res = rt < 0 ? rt : 0;
+    uring.forEachCqe([&](const io_uring_cqe& cqe){
+        res = cqe.res;
+        multishot = cqe.res > 0 && (cqe.flags & IORING_CQE_F_MORE);
+    });
+    ::close(fd);
+    if(!multishot){
+        GGO_LOG_WARN(g_logger) << "io_uring multishot poll not supported, res=" << res;
+    }
+    return multishot;
+}
+
+}
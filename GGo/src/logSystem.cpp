@@ -1,6 +1,14 @@
 #include"logSystem.h"
 #include"yaml-cpp/yaml.h"
 #include"config.h"
+#include"bytearray.h"
+#include<algorithm>
+#include<fcntl.h>
+#include<limits.h>
+#include<string.h>
+#include<sys/uio.h>
+#include<sys/stat.h>
+#include<sys/mman.h>
 namespace GGo {
 
 /// @brief 将日志级别转成文本输出
@@ -57,6 +65,41 @@ static LogLevel FromStringToLogLevel(const std::string &str){
 
 
 
+// 已登记的调用点链表，只增不减
+static std::atomic<LogSite*> s_log_sites = {nullptr};
+// 日志器配置的版本，每次改变加一
+static std::atomic<uint64_t> s_log_site_version = {0};
+// 已分配的调用点编号
+static std::atomic<uint32_t> s_log_site_count = {0};
+
+void LogSite::InvalidateAll()
+{
+	s_log_site_version++;
+	for(LogSite* site = s_log_sites.load(std::memory_order_acquire); site; site = site->m_next){
+		site->m_state.store(0);
+	}
+}
+
+bool LogSite::update(const std::shared_ptr<Logger> &logger, LogLevel level)
+{
+	if(!m_registered.exchange(true)){
+		m_next = s_log_sites.load(std::memory_order_relaxed);
+		while(!s_log_sites.compare_exchange_weak(m_next, this, std::memory_order_release, std::memory_order_relaxed));
+		m_id.store(++s_log_site_count, std::memory_order_relaxed);
+	}
+	uint64_t version = s_log_site_version.load();
+	int effective = logger->getEffectiveLevel();
+	uintptr_t key = (uintptr_t)logger.get();
+	if((key & LEVEL_MASK) == 0){
+		m_state.store(key | effective);
+		if(s_log_site_version.load() != version){
+			// 计算期间配置改变了，刚写入的值可能已经过期
+			m_state.store(0);
+		}
+	}
+	return (int)level >= effective;
+}
+
 LogEvent::LogEvent(Logger::ptr logger, LogLevel level, const char *file, int32_t line, uint32_t elapse, uint32_t thread_id, uint32_t fiber_id, uint64_t time, const std::string &thread_name)
 	:m_file(file)
 	,m_line(line)
@@ -69,6 +112,143 @@ LogEvent::LogEvent(Logger::ptr logger, LogLevel level, const char *file, int32_t
 	,m_level(level){
 }
 
+LogEvent::ptr LogEvent::Acquire(Logger::ptr logger, LogLevel level, const char *file, int32_t line, uint32_t elapse, uint32_t thread_id, uint32_t fiber_id, uint64_t time, const std::string &thread_name, uint32_t site_id)
+{
+	static thread_local LogEvent::ptr t_event;
+	if(t_event && t_event.use_count() == 1){
+		t_event->reset(logger, level, file, line, elapse, thread_id, fiber_id, time, thread_name, site_id);
+		return t_event;
+	}
+	// 缓存的事件还在使用中（拼接日志内容时又写了日志），分配新的
+	LogEvent::ptr event(new LogEvent(logger, level, file, line, elapse, thread_id, fiber_id, time, thread_name));
+	event->m_siteId = site_id;
+	if(!t_event){
+		t_event = event;
+	}
+	return event;
+}
+
+void LogEvent::reset(Logger::ptr logger, LogLevel level, const char *file, int32_t line, uint32_t elapse, uint32_t thread_id, uint32_t fiber_id, uint64_t time, const std::string &thread_name, uint32_t site_id)
+{
+	m_file = file;
+	m_line = line;
+	m_elapse = elapse;
+	m_threadID = thread_id;
+	m_fiberID = fiber_id;
+	m_time = time;
+	m_threadName = thread_name;
+	m_logger = logger;
+	m_level = level;
+	m_siteId = site_id;
+	m_ss.reset();
+	m_fmt = nullptr;
+	m_args.clear();
+	m_argData.clear();
+	m_rendered = false;
+}
+
+void LogEvent::addInt(int64_t val)
+{
+	Arg arg;
+	arg.type = Arg::INT;
+	arg.i = val;
+	m_args.push_back(arg);
+}
+
+void LogEvent::addUint(uint64_t val)
+{
+	Arg arg;
+	arg.type = Arg::UINT;
+	arg.u = val;
+	m_args.push_back(arg);
+}
+
+void LogEvent::addDouble(double val)
+{
+	Arg arg;
+	arg.type = Arg::DOUBLE;
+	arg.d = val;
+	m_args.push_back(arg);
+}
+
+void LogEvent::addString(const char *str, size_t len)
+{
+	Arg arg;
+	arg.type = Arg::STRING;
+	arg.offset = m_argData.size();
+	arg.length = len;
+	m_argData.append(str, len);
+	m_args.push_back(arg);
+}
+
+void LogEvent::render() const
+{
+	m_rendered = true;
+	auto write_arg = [this](const Arg& arg){
+		switch(arg.type){
+			case Arg::INT:
+				m_ss << arg.i;
+				break;
+			case Arg::UINT:
+				m_ss << arg.u;
+				break;
+			case Arg::DOUBLE:
+				m_ss << arg.d;
+				break;
+			case Arg::STRING:
+				m_ss.write(m_argData.data() + arg.offset, arg.length);
+				break;
+		}
+	};
+	size_t next = 0;
+	const char* p = m_fmt;
+	while(*p){
+		if(p[0] == '{' && p[1] == '}'){
+			if(next < m_args.size()){
+				write_arg(m_args[next++]);
+			}else{
+				m_ss.write(p, 2);
+			}
+			p += 2;
+			continue;
+		}
+		const char* end = p + 1;
+		while(*end && !(end[0] == '{' && end[1] == '}')){
+			end++;
+		}
+		m_ss.write(p, end - p);
+		p = end;
+	}
+	for(; next < m_args.size(); next++){
+		m_ss << ' ';
+		write_arg(m_args[next]);
+	}
+}
+
+void LogStream::reset()
+{
+	m_buf.m_str.clear();
+	clear();
+	flags(std::ios_base::skipws | std::ios_base::dec);
+	precision(6);
+	width(0);
+	fill(' ');
+}
+
+LogStream::StringBuf::int_type LogStream::StringBuf::overflow(int_type ch)
+{
+	if(ch != traits_type::eof()){
+		m_str.push_back((char)ch);
+	}
+	return ch;
+}
+
+std::streamsize LogStream::StringBuf::xsputn(const char *s, std::streamsize n)
+{
+	m_str.append(s, n);
+	return n;
+}
+
 
 
 LogEventWrap::LogEventWrap(LogEvent::ptr event)
@@ -80,7 +260,7 @@ LogEventWrap::~LogEventWrap()
 	m_event->getLogger()->log(m_event->getLevel(),m_event);
 }
 
-std::stringstream &LogEventWrap::getSS()
+std::ostream &LogEventWrap::getSS()
 {
     return m_event->getSS();
 }
@@ -94,27 +274,47 @@ void LogEvent::format(const char *fmt, ...)
 }
 void LogEvent::format(const char *fmt, va_list al)
 {
-	char* buf = nullptr;
-	int len = vasprintf(&buf,fmt,al);
+	// 大多数内容放得进栈上的缓冲区，放不下时再分配
+	char buf[1024];
+	va_list copy;
+	va_copy(copy, al);
+	int len = vsnprintf(buf, sizeof(buf), fmt, copy);
+	va_end(copy);
+	if(len < 0){
+		return;
+	}
+	if((size_t)len < sizeof(buf)){
+		m_ss.write(buf, len);
+		return;
+	}
+	char* large = nullptr;
+	len = vasprintf(&large,fmt,al);
 	if(len != -1){
-		m_ss << std::string(buf,len);
-		free(buf);
+		m_ss.write(large, len);
+		free(large);
 	}
 }
 
+// 格式器实例编号，不会复用
+static std::atomic<uint64_t> s_formatter_id = {0};
+
 LogFormatter::LogFormatter(const std::string &pattern)
 	:m_pattern(pattern)
+	,m_id(++s_formatter_id)
 {
 	init();
 }
 
 std::string LogFormatter::format(std::shared_ptr<Logger> logger, LogLevel level, LogEvent::ptr event)
 {
-    std::stringstream ss;
-	for(auto& i : m_items){
-		i->format(ss,logger,level,event);
+	char buf[1024];
+	size_t len = format(buf, sizeof(buf), logger, level, *event);
+	if(len <= sizeof(buf)){
+		return std::string(buf, len);
 	}
-	return ss.str();
+	std::string str(len, '\0');
+	format(&str[0], len, logger, level, *event);
+	return str;
 }
 
 std::ostream &LogFormatter::format(std::ostream &ofs, std::shared_ptr<Logger> logger, LogLevel level, LogEvent::ptr event)
@@ -125,6 +325,141 @@ std::ostream &LogFormatter::format(std::ostream &ofs, std::shared_ptr<Logger> lo
 	return ofs;
 }
 
+/// @brief 向定长缓冲区追加内容，放不下的部分只累计长度
+class FixedWriter{
+public:
+	FixedWriter(char* buf, size_t size)
+		:m_buf(buf)
+		,m_size(size){
+	}
+
+	void append(const char* str, size_t len){
+		if(m_pos < m_size){
+			memcpy(m_buf + m_pos, str, std::min(len, m_size - m_pos));
+		}
+		m_pos += len;
+	}
+
+	void append(const std::string& str){
+		append(str.data(), str.size());
+	}
+
+	void append(const char* str){
+		append(str, strlen(str));
+	}
+
+	void append(char ch){
+		if(m_pos < m_size){
+			m_buf[m_pos] = ch;
+		}
+		m_pos++;
+	}
+
+	void appendUint(uint64_t val){
+		char tmp[20];
+		int i = sizeof(tmp);
+		do{
+			tmp[--i] = '0' + val % 10;
+			val /= 10;
+		}while(val);
+		append(tmp + i, sizeof(tmp) - i);
+	}
+
+	void appendInt(int64_t val){
+		if(val < 0){
+			append('-');
+			appendUint(-(uint64_t)val);
+		}else{
+			appendUint(val);
+		}
+	}
+
+	size_t length() const { return m_pos; }
+
+private:
+	char* m_buf;
+	size_t m_size;
+	size_t m_pos = 0;
+};
+
+/// @brief 线程缓存的时间字符串，同一秒内的日志不再调用localtime_r和strftime
+struct DateCache{
+	// 格式器实例编号，0表示无效
+	uint64_t formatter = 0;
+	// 片段下标
+	size_t segment = 0;
+	// 缓存对应的秒
+	uint64_t second = 0;
+	// 时间字符串
+	char str[64];
+	size_t len = 0;
+};
+
+size_t LogFormatter::format(char *buf, size_t size, std::shared_ptr<Logger> logger, LogLevel level, const LogEvent &event)
+{
+	static thread_local DateCache t_dates[4];
+	FixedWriter writer(buf, size);
+	for(size_t i = 0; i < m_segments.size(); i++){
+		const Segment& segment = m_segments[i];
+		switch(segment.type){
+			case 0:
+				writer.append(segment.text);
+				break;
+			case 'm':
+				writer.append(event.getContent());
+				break;
+			case 'p':
+				writer.append(LogLevelTOString(level));
+				break;
+			case 'r':
+				writer.appendUint(event.getElapse());
+				break;
+			case 'c':
+				writer.append(event.getLogger()->getNanme());
+				break;
+			case 't':
+				writer.appendUint(event.getThreadID());
+				break;
+			case 'n':
+				writer.append('\n');
+				break;
+			case 'd':
+			{
+				DateCache& cache = t_dates[(m_id * 31 + i) & 3];
+				if(cache.formatter != m_id || cache.segment != i || cache.second != event.getTime()){
+					struct tm tm;
+					time_t time = event.getTime();
+					localtime_r(&time,&tm);
+					cache.len = strftime(cache.str, sizeof(cache.str), segment.text.c_str(), &tm);
+					cache.formatter = m_id;
+					cache.segment = i;
+					cache.second = event.getTime();
+				}
+				writer.append(cache.str, cache.len);
+				break;
+			}
+			case 'f':
+				writer.append(event.getFile());
+				break;
+			case 'L':
+				writer.appendInt(event.getLine());
+				break;
+			case 'T':
+				writer.append('\t');
+				break;
+			case 'F':
+				writer.appendUint(event.getFiberID());
+				break;
+			case 'N':
+				writer.append(event.getThreadName());
+				break;
+			default:
+				break;
+		}
+	}
+	return writer.length();
+}
+
 class MessageFormatItem : public LogFormatter::FormatItem{
 public:
 	MessageFormatItem(const std::string& str =""){}
@@ -338,13 +673,20 @@ void LogFormatter::init()
     for(auto& i : vec) {
         if(std::get<2>(i) == 0) {
             m_items.push_back(FormatItem::ptr(new StringFormatItem(std::get<0>(i))));
+            m_segments.push_back({0, std::get<0>(i)});
         } else {
             auto it = s_format_items.find(std::get<0>(i));
             if(it == s_format_items.end()) {
                 m_items.push_back(FormatItem::ptr(new StringFormatItem("<<error_format %" + std::get<0>(i) + ">>")));
+                m_segments.push_back({0, "<<error_format %" + std::get<0>(i) + ">>"});
                 m_error = true;
             } else {
                 m_items.push_back(it->second(std::get<1>(i)));
+                std::string text = std::get<1>(i);
+                if(std::get<0>(i) == "d" && text.empty()){
+                    text = "%Y-%m-%d %H:%M:%S";
+                }
+                m_segments.push_back({std::get<0>(i)[0], text});
             }
         }
 
@@ -373,6 +715,7 @@ LogFormatter::ptr LogAppender::getFormatter()
 Logger::Logger(const std::string &name)
 	:m_name(name)
 	,m_level(LogLevel::DEBUG)
+	,m_appenders(new std::list<LogAppender::ptr>())
 {
 	m_formatter.reset(new LogFormatter("%d{%Y-%m-%d %H:%M:%S}%T%t%T%N%T%F%T[%p]%T[%c]%T%f:%L%T%m%n"));
 }
@@ -381,9 +724,14 @@ void Logger::log(LogLevel level, LogEvent::ptr event)
 {
 	if(level >= m_level){
 		auto self = shared_from_this();
-		mutexType::Lock lock(m_mutex);
-		if(!m_appenders.empty()){
-			for(auto& appender:m_appenders){
+		std::shared_ptr<const std::list<LogAppender::ptr>> appenders;
+		{
+			// 只在锁内取得当前的目标集合，格式化与输出不占用日志器的锁
+			mutexType::Lock lock(m_mutex);
+			appenders = m_appenders;
+		}
+		if(!appenders->empty()){
+			for(auto& appender:*appenders){
 				appender->log(self, level, event);
 			}
 		}else if(m_root){
@@ -393,6 +741,29 @@ void Logger::log(LogLevel level, LogEvent::ptr event)
 	}
 	
 }
+void Logger::setLevel(LogLevel val)
+{
+	m_level = val;
+	LogSite::InvalidateAll();
+}
+
+int Logger::getEffectiveLevel()
+{
+	Logger::ptr root;
+	{
+		mutexType::Lock lock(m_mutex);
+		if(!m_appenders->empty()){
+			return (int)m_level;
+		}
+		root = m_root;
+	}
+	if(!root){
+		return (int)LogLevel::FATAL + 1;
+	}
+	// 没有目标时交给root日志器输出，两边的级别都要满足
+	return std::max((int)m_level, root->getEffectiveLevel());
+}
+
 void Logger::debug(LogEvent::ptr event)
 {
 	log(LogLevel::DEBUG,event);
@@ -416,33 +787,46 @@ void Logger::fatal(LogEvent::ptr event)
 
 void Logger::addAppender(LogAppender::ptr appender)
 {
-	mutexType::Lock lock(m_mutex);
-	if(!appender->m_hasFormatter){
-		appender->m_formatter = m_formatter;
+	{
+		mutexType::Lock lock(m_mutex);
+		if(!appender->m_hasFormatter){
+			appender->m_formatter = m_formatter;
+		}
+		auto appenders = std::make_shared<std::list<LogAppender::ptr>>(*m_appenders);
+		appenders->push_back(appender);
+		m_appenders = appenders;
 	}
-	m_appenders.push_back(appender);
+	LogSite::InvalidateAll();
 }
 void Logger::delAppender(LogAppender::ptr appender)
 {
-	mutexType::Lock lock(m_mutex);
-	for(auto it = m_appenders.begin()
-		;it != m_appenders.end();it++){
-			if(*it == appender){
-				m_appenders.erase(it);
-				break;
+	{
+		mutexType::Lock lock(m_mutex);
+		auto appenders = std::make_shared<std::list<LogAppender::ptr>>(*m_appenders);
+		for(auto it = appenders->begin()
+			;it != appenders->end();it++){
+				if(*it == appender){
+					appenders->erase(it);
+					break;
+				}
 			}
-		}
+		m_appenders = appenders;
+	}
+	LogSite::InvalidateAll();
 }
 void Logger::clearAppenders()
 {
-	mutexType::Lock lock(m_mutex);
-	m_appenders.clear();
+	{
+		mutexType::Lock lock(m_mutex);
+		m_appenders = std::make_shared<std::list<LogAppender::ptr>>();
+	}
+	LogSite::InvalidateAll();
 }
 void Logger::setFormatter(LogFormatter::ptr val)
 {
 	mutexType::Lock lock(m_mutex);
 	m_formatter = val;
-	for(auto& appender:m_appenders){
+	for(auto& appender:*m_appenders){
 		if(!appender->m_hasFormatter){
 			appender->setFormatter(val);
 		}
@@ -476,7 +860,7 @@ std::string Logger::toYamlString()
 	{
 		node["formatter"] = m_formatter->getPattern();
 	}
-	for(auto& i :m_appenders){
+	for(auto& i :*m_appenders){
 		node["appenders"].push_back(YAML::Load(i->toYamlString()));
 	}
 	std::stringstream ss;
@@ -486,7 +870,11 @@ std::string Logger::toYamlString()
 
 void Logger::setRootLogger(Logger::ptr logger)
 {
-	m_root = logger;
+	{
+		mutexType::Lock lock(m_mutex);
+		m_root = logger;
+	}
+	LogSite::InvalidateAll();
 }
 
 LoggerManager::LoggerManager()
@@ -526,6 +914,22 @@ std::string LoggerManager::toYamlString()
 	return ss.str();
 }
 
+/// @brief 把日志格式化到线程缓存的缓冲区，放不下时退回到线程缓存的字符串
+/// @param len 返回日志长度
+/// @return 日志数据，在本线程下次调用前有效
+static const char* FormatLine(LogFormatter::ptr formatter, Logger::ptr logger, LogLevel level, LogEvent::ptr event, size_t& len)
+{
+	static thread_local char t_buf[4096];
+	static thread_local std::string t_large;
+	len = formatter->format(t_buf, sizeof(t_buf), logger, level, *event);
+	if(len <= sizeof(t_buf)){
+		return t_buf;
+	}
+	t_large.resize(len);
+	formatter->format(&t_large[0], len, logger, level, *event);
+	return t_large.data();
+}
+
 FileLogAppender::FileLogAppender(const std::string &filename)
 	:m_filename(filename)
 {
@@ -540,8 +944,10 @@ void FileLogAppender::log(Logger::ptr logger, LogLevel level, LogEvent::ptr even
 			reopen();
 			m_lastTime = now;
 		}
+		size_t len = 0;
+		const char* data = FormatLine(getFormatter(), logger, level, event, len);
 		mutexType::Lock lock(m_mutex);
-		if(!m_formatter->format(m_filestream,logger,level,event)){
+		if(!m_filestream.write(data, len).flush()){
 			std::cout<<"error"<<std::endl;
 		}
 	}
@@ -574,19 +980,169 @@ bool FileLogAppender::reopen()
 	return FSUtil::openForWrite(m_filestream, m_filename, std::ios::app);
 }
 
-void StdoutLogAppender::log(Logger::ptr logger, LogLevel level, LogEvent::ptr event)
+// 所有实例当前占用内存的缓冲区数量
+static std::atomic<size_t> s_live_buffers = {0};
+
+struct AsyncFileLogAppender::Buffer{
+	explicit Buffer(size_t size)
+		:data(new char[size]){
+		s_live_buffers++;
+	}
+	~Buffer(){
+		release();
+	}
+	// 释放数据区，实例析构后线程缓存中只留下不占内存的空壳
+	void release(){
+		if(data){
+			data.reset();
+			s_live_buffers--;
+		}
+	}
+	// 数据区，容量为appender的m_bufferSize
+	std::unique_ptr<char[]> data;
+	// 写入位置（只增不减），只由所属线程修改
+	std::atomic<uint64_t> tail = {0};
+	// 读取位置（只增不减），只由后台线程修改
+	std::atomic<uint64_t> head = {0};
+	// 所属线程已经退出，不会再写入
+	std::atomic<bool> exited = {false};
+	// 所属实例已经析构，线程缓存中的这一项可以丢弃
+	std::atomic<bool> dead = {false};
+};
+
+struct AsyncFileLogAppender::ThreadBuffers{
+	~ThreadBuffers(){
+		for(auto& buffer : buffers){
+			if(buffer){
+				buffer->exited.store(true, std::memory_order_release);
+			}
+		}
+		destroyed = true;
+	}
+	// 按实例槽位下标，交替写多个实例时也不用查表
+	std::vector<std::shared_ptr<Buffer>> buffers;
+	// 析构之后本线程不能再使用buffers（平凡析构，析构后仍可读取）
+	static thread_local bool destroyed;
+};
+
+thread_local bool AsyncFileLogAppender::ThreadBuffers::destroyed = false;
+
+/// @brief 实例槽位，实例析构后回收复用，线程缓存的大小只取决于同时存在的实例数量
+struct AppenderSlots{
+	Mutex mutex;
+	std::vector<uint64_t> free;
+	uint64_t next = 0;
+};
+
+// 不析构，静态对象析构阶段销毁的实例仍然可以归还槽位
+static AppenderSlots& getAppenderSlots()
 {
-	if(level >= m_level){
-		mutexType::Lock lock(m_mutex);
-		m_formatter->format(std::cout,logger,level,event);
+	static AppenderSlots* s_slots = new AppenderSlots;
+	return *s_slots;
+}
+
+static uint64_t acquireSlot()
+{
+	AppenderSlots& slots = getAppenderSlots();
+	Mutex::Lock lock(slots.mutex);
+	if(slots.free.empty()){
+		return slots.next++;
 	}
+	uint64_t slot = slots.free.back();
+	slots.free.pop_back();
+	return slot;
 }
 
-std::string StdoutLogAppender::toYamlString()
+static void releaseSlot(uint64_t slot)
+{
+	AppenderSlots& slots = getAppenderSlots();
+	Mutex::Lock lock(slots.mutex);
+	slots.free.push_back(slot);
+}
+
+AsyncFileLogAppender::AsyncFileLogAppender(const std::string &filename, size_t buffer_size
+										, uint64_t flush_interval, Policy policy)
+	:m_filename(filename)
+	,m_bufferSize(buffer_size < 4096 ? 4096 : buffer_size)
+	,m_flushInterval(flush_interval == 0 ? 1 : flush_interval)
+	,m_policy(policy)
+	,m_id(acquireSlot())
+{
+	reopen();
+	m_lastTime = GGo::now(COARSE) / 1000;
+	m_thread.reset(new Thread(std::bind(&AsyncFileLogAppender::run, this), "async_log"));
+}
+
+AsyncFileLogAppender::~AsyncFileLogAppender()
+{
+	m_stopping = true;
+	m_wakeup.notify();
+	m_thread->join();
+	if(m_fd >= 0){
+		::close(m_fd);
+	}
+	// 其他线程的缓存里还引用着缓冲区，先释放数据区并标记，再把槽位交给新实例
+	for(auto& buffer : m_buffers){
+		buffer->release();
+		buffer->dead.store(true, std::memory_order_release);
+	}
+	releaseSlot(m_id);
+}
+
+void AsyncFileLogAppender::log(Logger::ptr logger, LogLevel level, LogEvent::ptr event)
+{
+	if(level < m_level){
+		return;
+	}
+	size_t len = 0;
+	const char* data = FormatLine(getFormatter(), logger, level, event, len);
+	if(len > m_bufferSize){
+		m_dropped++;
+		return;
+	}
+	Buffer* buffer = getBuffer();
+	uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+	uint64_t head = buffer->head.load(std::memory_order_acquire);
+	while(m_bufferSize - (tail - head) < len){
+		if(m_policy == DROP){
+			m_dropped++;
+			wakeup();
+			return;
+		}
+		// 阻塞当前线程直到后台线程写完一轮，超时后重新检查，避免错过通知
+		m_waiters++;
+		wakeup();
+		m_written.waitFor(10);
+		m_waiters--;
+		head = buffer->head.load(std::memory_order_acquire);
+	}
+
+	size_t pos = tail % m_bufferSize;
+	size_t first = std::min(len, m_bufferSize - pos);
+	memcpy(buffer->data.get() + pos, data, first);
+	memcpy(buffer->data.get(), data + first, len - first);
+	buffer->tail.store(tail + len, std::memory_order_release);
+
+	size_t half = m_bufferSize / 2;
+	if(tail - head < half && tail + len - head >= half){
+		// 用量刚超过一半，提前唤醒后台线程，而不是等到写满
+		wakeup();
+	}
+	if(level >= LogLevel::FATAL){
+		// 进程可能马上退出，FATAL日志同步落盘
+		flush();
+	}
+}
+
+std::string AsyncFileLogAppender::toYamlString()
 {
 	mutexType::Lock lock(m_mutex);
 	YAML::Node node;
-	node["type"] = "StdoutLogAppender";
+	node["type"] = "AsyncFileLogAppender";
+	node["file"] = m_filename;
+	node["buffer_size"] = m_bufferSize;
+	node["flush_interval"] = m_flushInterval;
+	node["policy"] = PolicyToString(m_policy);
 	if(m_level != LogLevel::UNKNOWN){
 		node["level"] = LogLevelTOString(m_level);
 	}
@@ -598,61 +1154,973 @@ std::string StdoutLogAppender::toYamlString()
 	return ss.str();
 }
 
-//配置系统整合日志系统 ，定义 LogAppender 和 logger 的定义结构体，并作模板偏特化
-
-struct LogAppenderDefine{
-	/// @brief 1 file / 2 stdout
-	int type = 0;
-	LogLevel level = LogLevel::UNKNOWN;
-	std::string formatter;
-	std::string file;
-
-	bool operator==(const LogAppenderDefine& other) const{
-		return 	type == other.type &&
-				level == other.level &&
-				formatter == other.formatter &&
-				file == other.file;
-				
+void AsyncFileLogAppender::flush()
+{
+	uint64_t request = ++m_flushRequest;
+	m_waiters++;
+	m_wakeup.notify();
+	while(m_flushDone < request){
+		m_written.waitFor(10);
 	}
+	m_waiters--;
+}
 
-};
+AsyncFileLogAppender::Policy AsyncFileLogAppender::PolicyFromString(const std::string &str)
+{
+	if(str == "block" || str == "BLOCK"){
+		return BLOCK;
+	}
+	return DROP;
+}
 
-struct LogDefine{
-	std::string name;
-	LogLevel level = LogLevel::UNKNOWN;
-	std::string formatter;
-	std::vector<LogAppenderDefine> appenders;
+const char *AsyncFileLogAppender::PolicyToString(Policy policy)
+{
+	return policy == BLOCK ? "block" : "drop";
+}
 
-	bool operator==(const LogDefine& other) const{
-		return 	name == other.name &&
-				level == other.level &&
-				formatter == other.formatter &&
-				appenders == other.appenders;
+AsyncFileLogAppender::Buffer *AsyncFileLogAppender::getBuffer()
+{
+	static thread_local ThreadBuffers t_buffers;
+	if(ThreadBuffers::destroyed){
+		// 线程正在退出，不再创建线程缓存，按线程ID查表
+		Mutex::Lock lock(m_buffersMutex);
+		auto& buffer = m_lateBuffers[GGo::GetThreadID()];
+		if(!buffer){
+			buffer.reset(new Buffer(m_bufferSize));
+		}
+		return buffer.get();
 	}
-	//为了能使用std::map，需要提供大小比较的方法
-	bool operator<(const LogDefine& other) const{
-		return name < other.name;
+	std::vector<std::shared_ptr<Buffer>>& buffers = t_buffers.buffers;
+	if(m_id < buffers.size() && buffers[m_id]
+			&& !buffers[m_id]->dead.load(std::memory_order_acquire)){
+		return buffers[m_id].get();
 	}
-	bool isValid() const {
-		return !name.empty();
+	// 丢弃已析构实例留下的缓存项，其中也包括复用本槽位的旧实例
+	for(auto& i : buffers){
+		if(i && i->dead.load(std::memory_order_acquire)){
+			i.reset();
+		}
 	}
-};
+	std::shared_ptr<Buffer> buffer(new Buffer(m_bufferSize));
+	{
+		Mutex::Lock lock(m_buffersMutex);
+		m_buffers.push_back(buffer);
+	}
+	if(buffers.size() <= m_id){
+		buffers.resize(m_id + 1);
+	}
+	buffers[m_id] = buffer;
+	return buffer.get();
+}
 
+size_t AsyncFileLogAppender::getBufferCount()
+{
+	Mutex::Lock lock(m_buffersMutex);
+	return m_buffers.size() + m_lateBuffers.size();
+}
 
-/// @brief 模板类型偏特化 实现 YAML 字符串和LogDefine 自定义类的相互转换
-template<>
-class LexicalCast<std::string, LogDefine>{
-public:
-	LogDefine operator()(const std::string& ymlstr){
-		YAML::Node node = YAML::Load(ymlstr);
-		LogDefine ret;
-		if(!node["name"].IsDefined()){
-			std::cout << "log config error: name is a null, " << node << std::endl;
-			throw std::logic_error("log config is null");
+size_t AsyncFileLogAppender::GetLiveBufferCount()
+{
+	return s_live_buffers;
+}
+
+void AsyncFileLogAppender::wakeup()
+{
+	if(!m_notified.exchange(true)){
+		m_wakeup.notify();
+	}
+}
+
+void AsyncFileLogAppender::run()
+{
+	while(true){
+		m_wakeup.waitFor(m_flushInterval);
+		m_notified = false;
+		// 先读取停止标志与刷新请求，之后的一轮写出一定包含它们之前写入的日志
+		bool stopping = m_stopping;
+		uint64_t request = m_flushRequest;
+		writeOut();
+		m_flushDone = request;
+		for(int i = m_waiters; i > 0; i--){
+			m_written.notify();
 		}
-		if(!node["level"].IsDefined()){
-			std::cout << "log config error: level is a null, " << node << std::endl;
-			throw std::logic_error("log config is null");
+		if(stopping){
+			break;
+		}
+	}
+}
+
+/// @brief 写完iovs中的所有数据，处理部分写入与IOV_MAX的限制
+static bool WriteAll(int fd, std::vector<iovec>& iovs)
+{
+	size_t index = 0;
+	while(index < iovs.size()){
+		int count = std::min<size_t>(iovs.size() - index, IOV_MAX);
+		ssize_t rt = ::writev(fd, &iovs[index], count);
+		if(rt < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			return false;
+		}
+		// 跳过已经写完的部分
+		while(index < iovs.size() && rt >= (ssize_t)iovs[index].iov_len){
+			rt -= iovs[index].iov_len;
+			index++;
+		}
+		if(rt > 0){
+			iovs[index].iov_base = (char*)iovs[index].iov_base + rt;
+			iovs[index].iov_len -= rt;
+		}
+	}
+	return true;
+}
+
+void AsyncFileLogAppender::writeOut()
+{
+	uint64_t now = GGo::now(COARSE) / 1000;
+	if(m_fd < 0 || now >= m_lastTime + 3){
+		// 与FileLogAppender一样定期重新打开，文件被外部移走后重新创建
+		reopen();
+		m_lastTime = now;
+	}
+
+	std::vector<std::shared_ptr<Buffer>> buffers;
+	{
+		Mutex::Lock lock(m_buffersMutex);
+		buffers = m_buffers;
+		for(auto& i : m_lateBuffers){
+			buffers.push_back(i.second);
+		}
+	}
+	std::vector<iovec> iovs;
+	std::vector<uint64_t> tails(buffers.size());
+	// 线程退出前写入的内容在这一轮全部写出，写完后移除
+	std::vector<bool> exited(buffers.size());
+	for(size_t i = 0; i < buffers.size(); i++){
+		Buffer* buffer = buffers[i].get();
+		// 先读退出标志再读写入位置，退出标志为真时读到的就是最终位置
+		exited[i] = buffer->exited.load(std::memory_order_acquire);
+		uint64_t head = buffer->head.load(std::memory_order_relaxed);
+		uint64_t tail = buffer->tail.load(std::memory_order_acquire);
+		tails[i] = tail;
+		if(head == tail){
+			continue;
+		}
+		// 环形区最多分成两段
+		size_t pos = head % m_bufferSize;
+		size_t len = tail - head;
+		size_t first = std::min(len, m_bufferSize - pos);
+		iovs.push_back({buffer->data.get() + pos, first});
+		if(len > first){
+			iovs.push_back({buffer->data.get(), len - first});
+		}
+	}
+	std::string dropped;
+	uint64_t dropped_count = m_dropped;
+	if(dropped_count != m_droppedReported){
+		dropped = "AsyncFileLogAppender dropped " + std::to_string(dropped_count - m_droppedReported)
+				+ " log events\n";
+		m_droppedReported = dropped_count;
+		iovs.push_back({&dropped[0], dropped.size()});
+	}
+
+	if(!iovs.empty() && (m_fd < 0 || !WriteAll(m_fd, iovs))){
+		std::cout << "AsyncFileLogAppender write " << m_filename << " error: " << strerror(errno) << std::endl;
+	}
+	// 写失败时也要释放空间，否则BLOCK策略下写日志的线程会一直等待
+	bool remove = false;
+	for(size_t i = 0; i < buffers.size(); i++){
+		buffers[i]->head.store(tails[i], std::memory_order_release);
+		remove = remove || exited[i];
+	}
+	if(remove){
+		Mutex::Lock lock(m_buffersMutex);
+		m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(), [](const std::shared_ptr<Buffer>& buffer){
+			return buffer->exited.load(std::memory_order_acquire)
+				&& buffer->head.load(std::memory_order_relaxed) == buffer->tail.load(std::memory_order_acquire);
+		}), m_buffers.end());
+	}
+}
+
+bool AsyncFileLogAppender::reopen()
+{
+	if(m_fd >= 0){
+		::close(m_fd);
+	}
+	m_fd = ::open(m_filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if(m_fd < 0){
+		//打开失败，一般是目录不存在
+		FSUtil::mkDir(FSUtil::dirName(m_filename));
+		m_fd = ::open(m_filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	}
+	return m_fd >= 0;
+}
+
+struct MmapFileLogAppender::Segment{
+	~Segment(){
+		if(data){
+			if(sync){
+				msync(data, used, MS_SYNC);
+			}
+			munmap(data, size);
+		}
+		// 去掉预分配的空白部分
+		if(ftruncate(fd, used) != 0){
+			std::cout << "MmapFileLogAppender truncate segment " << index << " error: " << strerror(errno) << std::endl;
+		}
+		::close(fd);
+	}
+	// 分段序号
+	uint32_t index = 0;
+	// 文件句柄
+	int fd = -1;
+	// 映射的内存
+	char* data = nullptr;
+	// 映射的大小
+	size_t size = 0;
+	// 已经预留的长度，在appender的m_mutex内修改
+	size_t used = 0;
+	// 已经同步的长度，只由后台线程使用
+	size_t synced = 0;
+	// 关闭时是否同步
+	bool sync = false;
+};
+
+MmapFileLogAppender::MmapFileLogAppender(const std::string &filename, size_t segment_size
+										, uint32_t segment_count, uint64_t sync_interval)
+	:m_filename(filename)
+	,m_segmentSize(segment_size < 4096 ? 4096 : segment_size)
+	,m_segmentCount(segment_count < 2 ? 2 : segment_count)
+	,m_syncInterval(sync_interval)
+{
+	// 从最近修改过的分段接着写，它已经写满时换下一个
+	uint32_t index = 0;
+	struct timespec latest = {0, 0};
+	for(uint32_t i = 0; i < m_segmentCount; i++){
+		struct stat st;
+		if(::stat(getSegmentName(i).c_str(), &st) == 0
+			&& (st.st_mtim.tv_sec > latest.tv_sec
+				|| (st.st_mtim.tv_sec == latest.tv_sec && st.st_mtim.tv_nsec > latest.tv_nsec))){
+			latest = st.st_mtim;
+			index = i;
+		}
+	}
+	m_current = openSegment(index, true);
+	if(!m_current){
+		m_current = openSegment((index + 1) % m_segmentCount, false);
+	}
+	m_thread.reset(new Thread(std::bind(&MmapFileLogAppender::run, this), "mmap_log"));
+}
+
+MmapFileLogAppender::~MmapFileLogAppender()
+{
+	m_stopping = true;
+	m_wakeup.notify();
+	m_thread->join();
+}
+
+void MmapFileLogAppender::log(Logger::ptr logger, LogLevel level, LogEvent::ptr event)
+{
+	if(level < m_level){
+		return;
+	}
+	size_t len = 0;
+	const char* data = FormatLine(getFormatter(), logger, level, event, len);
+	if(len > m_segmentSize){
+		m_dropped++;
+		return;
+	}
+	std::shared_ptr<Segment> segment;
+	size_t offset = 0;
+	while(true){
+		{
+			mutexType::Lock lock(m_mutex);
+			if(m_current && m_current->used + len > m_current->size && m_next){
+				rotateLocked();
+			}
+			if(m_current && m_current->used + len <= m_current->size){
+				segment = m_current;
+				offset = segment->used;
+				segment->used += len;
+				break;
+			}
+		}
+		// 后台线程还没准备好下一个分段，由当前线程准备
+		if(!prepare()){
+			// 创建分段失败（一般是磁盘满了），丢弃而不是阻塞
+			m_dropped++;
+			return;
+		}
+	}
+	memcpy(segment->data + offset, data, len);
+}
+
+std::string MmapFileLogAppender::toYamlString()
+{
+	mutexType::Lock lock(m_mutex);
+	YAML::Node node;
+	node["type"] = "MmapFileLogAppender";
+	node["file"] = m_filename;
+	node["segment_size"] = m_segmentSize;
+	node["segment_count"] = m_segmentCount;
+	node["sync_interval"] = m_syncInterval;
+	if(m_level != LogLevel::UNKNOWN){
+		node["level"] = LogLevelTOString(m_level);
+	}
+	if(m_hasFormatter && m_formatter){
+		node["formatter"] = m_formatter->getPattern();
+	}
+	std::stringstream ss;
+	ss << node;
+	return ss.str();
+}
+
+void MmapFileLogAppender::flush()
+{
+	sync(true);
+}
+
+std::string MmapFileLogAppender::getSegmentName(uint32_t index) const
+{
+	return m_filename + "." + std::to_string(index);
+}
+
+uint32_t MmapFileLogAppender::getCurrentIndex()
+{
+	mutexType::Lock lock(m_mutex);
+	return m_current ? m_current->index : 0;
+}
+
+std::shared_ptr<MmapFileLogAppender::Segment> MmapFileLogAppender::openSegment(uint32_t index, bool resume)
+{
+	std::string name = getSegmentName(index);
+	int fd = ::open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if(fd < 0){
+		//打开失败，一般是目录不存在
+		FSUtil::mkDir(FSUtil::dirName(m_filename));
+		fd = ::open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	}
+	if(fd < 0){
+		std::cout << "MmapFileLogAppender open " << name << " error: " << strerror(errno) << std::endl;
+		return nullptr;
+	}
+	std::shared_ptr<Segment> segment(new Segment);
+	segment->index = index;
+	segment->fd = fd;
+	segment->sync = m_syncInterval > 0;
+	struct stat st;
+	if(resume && ::fstat(fd, &st) == 0){
+		segment->used = st.st_size;
+		if((size_t)st.st_size > m_segmentSize){
+			// 分段大小改小了，不再接着写
+			return nullptr;
+		}
+	}else if(ftruncate(fd, 0) != 0){
+		return nullptr;
+	}
+	// 预先分配磁盘空间，写映射内存时就不会因为磁盘满收到SIGBUS
+	int rt = posix_fallocate(fd, 0, m_segmentSize);
+	if(rt != 0){
+		std::cout << "MmapFileLogAppender allocate " << name << " error: " << strerror(rt) << std::endl;
+		return nullptr;
+	}
+	void* data = mmap(nullptr, m_segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+	if(data == MAP_FAILED){
+		std::cout << "MmapFileLogAppender mmap " << name << " error: " << strerror(errno) << std::endl;
+		return nullptr;
+	}
+	segment->data = (char*)data;
+	segment->size = m_segmentSize;
+	if(resume && segment->used == m_segmentSize){
+		// 进程崩溃时分段没有截断，末尾是预分配的0
+		while(segment->used > 0 && segment->data[segment->used - 1] == 0){
+			segment->used--;
+		}
+		if(segment->used == m_segmentSize){
+			return nullptr;
+		}
+	}
+	segment->synced = segment->used;
+	return segment;
+}
+
+bool MmapFileLogAppender::prepare()
+{
+	Mutex::Lock prepare_lock(m_prepareMutex);
+	uint32_t index = 0;
+	std::shared_ptr<Segment> old;
+	{
+		mutexType::Lock lock(m_mutex);
+		if(m_next){
+			return true;
+		}
+		index = m_current ? (m_current->index + 1) % m_segmentCount : 0;
+		for(auto it = m_retired.begin(); it != m_retired.end(); ++it){
+			if((*it)->index == index){
+				old = std::move(*it);
+				m_retired.erase(it);
+				break;
+			}
+		}
+	}
+	if(old){
+		// 写得太快，要复用的分段还没关闭，等还在写它的线程写完后先关闭
+		while(old.use_count() > 1){
+			sched_yield();
+		}
+		old.reset();
+	}
+	std::shared_ptr<Segment> segment = openSegment(index, false);
+	if(!segment){
+		return false;
+	}
+	mutexType::Lock lock(m_mutex);
+	if(!m_current){
+		m_current = segment;
+	}else{
+		m_next = segment;
+	}
+	return true;
+}
+
+void MmapFileLogAppender::rotateLocked()
+{
+	m_retired.push_back(m_current);
+	m_current = std::move(m_next);
+	m_wakeup.notify();
+}
+
+void MmapFileLogAppender::run()
+{
+	uint64_t last_sync = GGo::now(COARSE);
+	uint64_t last_check = last_sync;
+	while(!m_stopping){
+		m_wakeup.waitFor(m_syncInterval > 0 && m_syncInterval < 100 ? m_syncInterval : 100);
+		prepare();
+
+		// 关闭已经没有线程在写的旧分段
+		std::vector<std::shared_ptr<Segment>> closing;
+		{
+			mutexType::Lock lock(m_mutex);
+			for(auto it = m_retired.begin(); it != m_retired.end();){
+				if(it->use_count() == 1){
+					closing.push_back(std::move(*it));
+					it = m_retired.erase(it);
+				}else{
+					++it;
+				}
+			}
+		}
+		closing.clear();
+
+		uint64_t now = GGo::now(COARSE);
+		if(m_syncInterval > 0 && now >= last_sync + m_syncInterval){
+			sync(false);
+			last_sync = now;
+		}
+		if(now >= last_check + 3000){
+			// 与FileLogAppender一样定期检查，文件被外部移走后换到新的分段
+			checkMoved();
+			last_check = now;
+		}
+	}
+	// 还在写的线程持有的分段在它们写完后关闭
+	std::shared_ptr<Segment> current;
+	std::shared_ptr<Segment> next;
+	std::vector<std::shared_ptr<Segment>> retired;
+	{
+		mutexType::Lock lock(m_mutex);
+		current.swap(m_current);
+		next.swap(m_next);
+		retired.swap(m_retired);
+	}
+}
+
+void MmapFileLogAppender::checkMoved()
+{
+	std::shared_ptr<Segment> current;
+	{
+		mutexType::Lock lock(m_mutex);
+		current = m_current;
+	}
+	if(!current){
+		return;
+	}
+	struct stat path_st;
+	struct stat fd_st;
+	if(::stat(getSegmentName(current->index).c_str(), &path_st) == 0 && ::fstat(current->fd, &fd_st) == 0
+		&& path_st.st_dev == fd_st.st_dev && path_st.st_ino == fd_st.st_ino){
+		return;
+	}
+	prepare();
+	mutexType::Lock lock(m_mutex);
+	if(m_current == current && m_next){
+		rotateLocked();
+	}
+}
+
+void MmapFileLogAppender::sync(bool all)
+{
+	std::shared_ptr<Segment> segment;
+	size_t used = 0;
+	{
+		mutexType::Lock lock(m_mutex);
+		segment = m_current;
+		used = segment ? segment->used : 0;
+	}
+	if(!segment){
+		return;
+	}
+	static const size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t begin = all ? 0 : segment->synced / page_size * page_size;
+	if(used > begin){
+		msync(segment->data + begin, used - begin, MS_SYNC);
+	}
+	if(!all){
+		segment->synced = used;
+	}
+}
+
+constexpr char BinaryLogAppender::MAGIC[];
+
+/// @brief 与ByteArray::writeStringVarint相同的编码，不需要先构造std::string
+static void WriteString(ByteArray& ba, const char* str, size_t len)
+{
+	ba.writeUint64(len);
+	ba.write(str, len);
+}
+
+BinaryLogAppender::BinaryLogAppender(const std::string &filename, size_t buffer_size, uint64_t flush_interval)
+	:m_filename(filename)
+	,m_bufferSize(buffer_size)
+	,m_flushInterval(flush_interval == 0 ? 1 : flush_interval)
+	,m_buffer(new ByteArray())
+{
+	{
+		Mutex::Lock lock(m_writeMutex);
+		reopenLocked();
+		m_lastTime = m_flushTime = GGo::now(COARSE) / 1000;
+	}
+	if(m_bufferSize > 0){
+		m_thread.reset(new Thread(std::bind(&BinaryLogAppender::run, this), "binary_log"));
+	}
+}
+
+BinaryLogAppender::~BinaryLogAppender()
+{
+	if(m_thread){
+		m_stopping = true;
+		m_wakeup.notify();
+		m_thread->join();
+	}
+	Mutex::Lock lock(m_writeMutex);
+	writeOut();
+	if(m_fd >= 0){
+		::close(m_fd);
+	}
+}
+
+void BinaryLogAppender::log(Logger::ptr logger, LogLevel level, LogEvent::ptr event)
+{
+	if(level < m_level){
+		return;
+	}
+	Mutex::Lock lock(m_writeMutex);
+	uint64_t now = event->getTime();
+	if(m_fd < 0 || now >= m_lastTime + 3){
+		reopenLocked();
+		m_lastTime = now;
+	}
+	ByteArray& ba = *m_buffer;
+
+	// 定义记录：调用点第一次出现，或同一个调用点换了格式串
+	uint32_t site_id = event->getSiteId();
+	const char* fmt = event->getFormat() ? event->getFormat() : "";
+	if(site_id != 0){
+		if(site_id >= m_sites.size()){
+			m_sites.resize(site_id + 1, nullptr);
+		}
+		if(m_sites[site_id] != fmt){
+			ba.writeUint32(SITE);
+			ba.writeUint32(site_id);
+			WriteString(ba, event->getFile(), strlen(event->getFile()));
+			ba.writeInt32(event->getLine());
+			WriteString(ba, fmt, strlen(fmt));
+			m_sites[site_id] = fmt;
+		}
+	}
+	auto thread_it = m_threads.find(event->getThreadID());
+	if(thread_it == m_threads.end() || thread_it->second != event->getThreadName()){
+		ba.writeUint32(THREAD);
+		ba.writeUint32(event->getThreadID());
+		ba.writeStringVarint(event->getThreadName());
+		m_threads[event->getThreadID()] = event->getThreadName();
+	}
+	auto logger_it = m_loggers.find(logger->getNanme());
+	if(logger_it == m_loggers.end()){
+		logger_it = m_loggers.emplace(logger->getNanme(), m_loggers.size() + 1).first;
+		ba.writeUint32(LOGGER);
+		ba.writeUint32(logger_it->second);
+		ba.writeStringVarint(logger->getNanme());
+	}
+
+	ba.writeUint32(EVENT);
+	ba.writeUint32(site_id);
+	if(site_id == 0){
+		WriteString(ba, event->getFile(), strlen(event->getFile()));
+		ba.writeInt32(event->getLine());
+		WriteString(ba, fmt, strlen(fmt));
+	}
+	ba.writeFixeduint8((uint8_t)level);
+	ba.writeUint32(logger_it->second);
+	ba.writeUint64(event->getTime());
+	ba.writeUint32(event->getElapse());
+	ba.writeUint32(event->getThreadID());
+	ba.writeUint32(event->getFiberID());
+	if(event->getFormat()){
+		const std::vector<LogEvent::Arg>& args = event->getArgs();
+		ba.writeUint32(args.size());
+		for(auto& arg : args){
+			ba.writeFixeduint8(arg.type);
+			switch(arg.type){
+				case LogEvent::Arg::INT:
+					ba.writeInt64(arg.i);
+					break;
+				case LogEvent::Arg::UINT:
+					ba.writeUint64(arg.u);
+					break;
+				case LogEvent::Arg::DOUBLE:
+					ba.writeDouble(arg.d);
+					break;
+				case LogEvent::Arg::STRING:{
+					std::string_view str = event->getArgString(arg);
+					WriteString(ba, str.data(), str.size());
+					break;
+				}
+			}
+		}
+	}else{
+		// 流式写入的内容作为一个字符串参数
+		const std::string& content = event->getContent();
+		ba.writeUint32(1);
+		ba.writeFixeduint8(LogEvent::Arg::STRING);
+		WriteString(ba, content.data(), content.size());
+	}
+
+	if(ba.getSize() >= m_bufferSize || now != m_flushTime || level >= LogLevel::ERROR){
+		writeOut();
+		m_flushTime = now;
+	}
+}
+
+std::string BinaryLogAppender::toYamlString()
+{
+	mutexType::Lock lock(m_mutex);
+	YAML::Node node;
+	node["type"] = "BinaryLogAppender";
+	node["file"] = m_filename;
+	node["buffer_size"] = m_bufferSize;
+	node["flush_interval"] = m_flushInterval;
+	if(m_level != LogLevel::UNKNOWN){
+		node["level"] = LogLevelTOString(m_level);
+	}
+	std::stringstream ss;
+	ss << node;
+	return ss.str();
+}
+
+void BinaryLogAppender::flush()
+{
+	Mutex::Lock lock(m_writeMutex);
+	writeOut();
+}
+
+bool BinaryLogAppender::reopen()
+{
+	Mutex::Lock lock(m_writeMutex);
+	return reopenLocked();
+}
+
+void BinaryLogAppender::run()
+{
+	while(!m_stopping){
+		m_wakeup.waitFor(m_flushInterval);
+		// 日志稀疏时log()中不会再触发写出，由这里保证缓冲的时间有上限
+		Mutex::Lock lock(m_writeMutex);
+		writeOut();
+	}
+}
+
+void BinaryLogAppender::writeOut()
+{
+	size_t size = m_buffer->getSize();
+	if(size == 0){
+		return;
+	}
+	m_iovs.clear();
+	m_buffer->setPosition(0);
+	m_buffer->getReadBuffers(m_iovs, size);
+	if(m_fd < 0 || !WriteAll(m_fd, m_iovs)){
+		std::cout << "BinaryLogAppender write " << m_filename << " error: " << strerror(errno) << std::endl;
+	}
+	m_buffer->clear();
+}
+
+bool BinaryLogAppender::reopenLocked()
+{
+	if(m_fd >= 0){
+		struct stat path_st;
+		struct stat fd_st;
+		if(::stat(m_filename.c_str(), &path_st) == 0 && ::fstat(m_fd, &fd_st) == 0
+			&& path_st.st_dev == fd_st.st_dev && path_st.st_ino == fd_st.st_ino){
+			// 还是同一个文件，继续追加，已写过的定义仍然有效
+			return true;
+		}
+		// 缓冲的记录引用的是旧文件中的定义，写回旧文件
+		writeOut();
+		::close(m_fd);
+	}
+	m_fd = ::open(m_filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if(m_fd < 0){
+		//打开失败，一般是目录不存在
+		FSUtil::mkDir(FSUtil::dirName(m_filename));
+		m_fd = ::open(m_filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	}
+	// 新文件（或进程重启后追加的文件）需要重新写所有定义，后面的定义覆盖前面同编号的定义
+	m_sites.clear();
+	m_threads.clear();
+	m_loggers.clear();
+	if(m_fd < 0){
+		return false;
+	}
+	if(::lseek(m_fd, 0, SEEK_END) == 0){
+		m_buffer->write(MAGIC, MAGIC_SIZE);
+		writeOut();
+	}
+	return true;
+}
+
+BinaryLogReader::BinaryLogReader()
+	:m_data(new ByteArray()){
+}
+
+BinaryLogReader::~BinaryLogReader()
+{
+}
+
+bool BinaryLogReader::open(const std::string &filename)
+{
+	m_data->clear();
+	m_sites.clear();
+	m_threads.clear();
+	m_loggers.clear();
+	m_error = false;
+	if(!m_data->readFromFile(filename)){
+		return false;
+	}
+	m_data->setPosition(0);
+	char magic[BinaryLogAppender::MAGIC_SIZE];
+	if(m_data->getReadableSize() < sizeof(magic)){
+		return false;
+	}
+	m_data->read(magic, sizeof(magic));
+	return memcmp(magic, BinaryLogAppender::MAGIC, sizeof(magic)) == 0;
+}
+
+LogEvent::ptr BinaryLogReader::next()
+{
+	try{
+		while(!m_error && m_data->getReadableSize() > 0){
+			uint32_t type = m_data->readUint32();
+			switch(type){
+				case BinaryLogAppender::SITE:{
+					uint32_t id = m_data->readUint32();
+					Site& site = m_sites[id];
+					site.file = m_data->readStringVarint();
+					site.line = m_data->readInt32();
+					site.fmt = m_data->readStringVarint();
+					break;
+				}
+				case BinaryLogAppender::THREAD:{
+					uint32_t id = m_data->readUint32();
+					m_threads[id] = m_data->readStringVarint();
+					break;
+				}
+				case BinaryLogAppender::LOGGER:{
+					uint32_t id = m_data->readUint32();
+					m_loggers[id].reset(new Logger(m_data->readStringVarint()));
+					break;
+				}
+				case BinaryLogAppender::EVENT:
+					return readEvent();
+				default:
+					m_error = true;
+					break;
+			}
+		}
+	}catch(std::exception& e){
+		// 进程退出时最后一条记录可能没写完整
+		m_error = true;
+	}
+	return nullptr;
+}
+
+LogEvent::ptr BinaryLogReader::readEvent()
+{
+	const Site* site = &m_inline;
+	uint32_t site_id = m_data->readUint32();
+	if(site_id == 0){
+		m_inline.file = m_data->readStringVarint();
+		m_inline.line = m_data->readInt32();
+		m_inline.fmt = m_data->readStringVarint();
+	}else{
+		auto it = m_sites.find(site_id);
+		if(it == m_sites.end()){
+			m_error = true;
+			return nullptr;
+		}
+		site = &it->second;
+	}
+	LogLevel level = (LogLevel)m_data->readFixeduint8();
+	auto logger_it = m_loggers.find(m_data->readUint32());
+	if(logger_it == m_loggers.end()){
+		m_error = true;
+		return nullptr;
+	}
+	uint64_t time = m_data->readUint64();
+	uint32_t elapse = m_data->readUint32();
+	uint32_t thread_id = m_data->readUint32();
+	uint32_t fiber_id = m_data->readUint32();
+	LogEvent::ptr event(new LogEvent(logger_it->second, level, site->file.c_str(), site->line
+					, elapse, thread_id, fiber_id, time, m_threads[thread_id]));
+	if(!site->fmt.empty()){
+		event->setFormat(site->fmt.c_str());
+	}
+	uint32_t count = m_data->readUint32();
+	for(uint32_t i = 0; i < count; i++){
+		switch(m_data->readFixeduint8()){
+			case LogEvent::Arg::INT:
+				event->addInt(m_data->readInt64());
+				break;
+			case LogEvent::Arg::UINT:
+				event->addUint(m_data->readUint64());
+				break;
+			case LogEvent::Arg::DOUBLE:
+				event->addDouble(m_data->readDouble());
+				break;
+			case LogEvent::Arg::STRING:{
+				std::string str = m_data->readStringVarint();
+				if(site->fmt.empty()){
+					event->getSS() << str;
+				}else{
+					event->addString(str.data(), str.size());
+				}
+				break;
+			}
+			default:
+				m_error = true;
+				return nullptr;
+		}
+	}
+	return event;
+}
+
+void StdoutLogAppender::log(Logger::ptr logger, LogLevel level, LogEvent::ptr event)
+{
+	if(level >= m_level){
+		size_t len = 0;
+		const char* data = FormatLine(getFormatter(), logger, level, event, len);
+		mutexType::Lock lock(m_mutex);
+		std::cout.write(data, len).flush();
+	}
+}
+
+std::string StdoutLogAppender::toYamlString()
+{
+	mutexType::Lock lock(m_mutex);
+	YAML::Node node;
+	node["type"] = "StdoutLogAppender";
+	if(m_level != LogLevel::UNKNOWN){
+		node["level"] = LogLevelTOString(m_level);
+	}
+	if(m_hasFormatter && m_formatter){
+		node["formatter"] = m_formatter->getPattern();
+	}
+	std::stringstream ss;
+	ss << node;
+	return ss.str();
+}
+
+//配置系统整合日志系统 ，定义 LogAppender 和 logger 的定义结构体，并作模板偏特化
+
+struct LogAppenderDefine{
+	/// @brief 1 file / 2 stdout / 3 async file / 4 binary file / 5 mmap file
+	int type = 0;
+	LogLevel level = LogLevel::UNKNOWN;
+	std::string formatter;
+	std::string file;
+	// 以下只用于异步文件输出，buffer_size也用于二进制文件输出
+	size_t buffer_size = 256 * 1024;
+	uint64_t flush_interval = 1000;
+	std::string policy = "drop";
+	// 以下只用于内存映射分段文件输出
+	size_t segment_size = 64 * 1024 * 1024;
+	uint32_t segment_count = 8;
+	uint64_t sync_interval = 0;
+
+	bool operator==(const LogAppenderDefine& other) const{
+		return 	type == other.type &&
+				level == other.level &&
+				formatter == other.formatter &&
+				file == other.file &&
+				buffer_size == other.buffer_size &&
+				flush_interval == other.flush_interval &&
+				policy == other.policy &&
+				segment_size == other.segment_size &&
+				segment_count == other.segment_count &&
+				sync_interval == other.sync_interval;
+				
+	}
+
+};
+
+struct LogDefine{
+	std::string name;
+	LogLevel level = LogLevel::UNKNOWN;
+	std::string formatter;
+	std::vector<LogAppenderDefine> appenders;
+
+	bool operator==(const LogDefine& other) const{
+		return 	name == other.name &&
+				level == other.level &&
+				formatter == other.formatter &&
+				appenders == other.appenders;
+	}
+	//为了能使用std::map，需要提供大小比较的方法
+	bool operator<(const LogDefine& other) const{
+		return name < other.name;
+	}
+	bool isValid() const {
+		return !name.empty();
+	}
+};
+
+
+/// @brief 模板类型偏特化 实现 YAML 字符串和LogDefine 自定义类的相互转换
+template<>
+class LexicalCast<std::string, LogDefine>{
+public:
+	LogDefine operator()(const std::string& ymlstr){
+		YAML::Node node = YAML::Load(ymlstr);
+		LogDefine ret;
+		if(!node["name"].IsDefined()){
+			std::cout << "log config error: name is a null, " << node << std::endl;
+			throw std::logic_error("log config is null");
+		}
+		if(!node["level"].IsDefined()){
+			std::cout << "log config error: level is a null, " << node << std::endl;
+			throw std::logic_error("log config is null");
 		}
 		ret.name = node["name"].as<std::string>();
 		ret.level = FromStringToLogLevel(node["level"].as<std::string>());
@@ -681,6 +2149,70 @@ public:
 					if(appender_node["formatter"].IsDefined()){
 						appender_define.formatter = appender_node["formatter"].as<std::string>();
 					}
+				}else if(type == "AsyncFileLogAppender"){
+					appender_define.type = 3;
+					if(appender_node["level"].IsDefined()){
+						appender_define.level = FromStringToLogLevel(appender_node["level"].as<std::string>());
+					}
+					if(!appender_node["file"].IsDefined()){
+						std::cout << "log config error: asyncfileappender file is null"
+								<< appender_node << std::endl;
+						continue;
+					}
+					appender_define.file = appender_node["file"].as<std::string>();
+					if(appender_node["formatter"].IsDefined()){
+						appender_define.formatter = appender_node["formatter"].as<std::string>();
+					}
+					if(appender_node["buffer_size"].IsDefined()){
+						appender_define.buffer_size = appender_node["buffer_size"].as<size_t>();
+					}
+					if(appender_node["flush_interval"].IsDefined()){
+						appender_define.flush_interval = appender_node["flush_interval"].as<uint64_t>();
+					}
+					if(appender_node["policy"].IsDefined()){
+						appender_define.policy = appender_node["policy"].as<std::string>();
+					}
+				}else if(type == "MmapFileLogAppender"){
+					appender_define.type = 5;
+					if(appender_node["level"].IsDefined()){
+						appender_define.level = FromStringToLogLevel(appender_node["level"].as<std::string>());
+					}
+					if(!appender_node["file"].IsDefined()){
+						std::cout << "log config error: mmapfileappender file is null"
+								<< appender_node << std::endl;
+						continue;
+					}
+					appender_define.file = appender_node["file"].as<std::string>();
+					if(appender_node["formatter"].IsDefined()){
+						appender_define.formatter = appender_node["formatter"].as<std::string>();
+					}
+					if(appender_node["segment_size"].IsDefined()){
+						appender_define.segment_size = appender_node["segment_size"].as<size_t>();
+					}
+					if(appender_node["segment_count"].IsDefined()){
+						appender_define.segment_count = appender_node["segment_count"].as<uint32_t>();
+					}
+					if(appender_node["sync_interval"].IsDefined()){
+						appender_define.sync_interval = appender_node["sync_interval"].as<uint64_t>();
+					}
+				}else if(type == "BinaryLogAppender"){
+					appender_define.type = 4;
+					appender_define.buffer_size = 0;
+					if(appender_node["level"].IsDefined()){
+						appender_define.level = FromStringToLogLevel(appender_node["level"].as<std::string>());
+					}
+					if(!appender_node["file"].IsDefined()){
+						std::cout << "log config error: binaryappender file is null"
+								<< appender_node << std::endl;
+						continue;
+					}
+					appender_define.file = appender_node["file"].as<std::string>();
+					if(appender_node["buffer_size"].IsDefined()){
+						appender_define.buffer_size = appender_node["buffer_size"].as<size_t>();
+					}
+					if(appender_node["flush_interval"].IsDefined()){
+						appender_define.flush_interval = appender_node["flush_interval"].as<uint64_t>();
+					}
 				}else if(type == "StdoutLogAppender"){
 					appender_define.type = 2;
 					if (appender_node["level"].IsDefined())
@@ -722,6 +2254,23 @@ public:
 				appender_node["file"] = appender.file;
 			}else if(appender.type == 2){
 				appender_node["type"] = "StdoutLogAppender";
+			}else if(appender.type == 3){
+				appender_node["type"] = "AsyncFileLogAppender";
+				appender_node["file"] = appender.file;
+				appender_node["buffer_size"] = appender.buffer_size;
+				appender_node["flush_interval"] = appender.flush_interval;
+				appender_node["policy"] = appender.policy;
+			}else if(appender.type == 4){
+				appender_node["type"] = "BinaryLogAppender";
+				appender_node["file"] = appender.file;
+				appender_node["buffer_size"] = appender.buffer_size;
+				appender_node["flush_interval"] = appender.flush_interval;
+			}else if(appender.type == 5){
+				appender_node["type"] = "MmapFileLogAppender";
+				appender_node["file"] = appender.file;
+				appender_node["segment_size"] = appender.segment_size;
+				appender_node["segment_count"] = appender.segment_count;
+				appender_node["sync_interval"] = appender.sync_interval;
 			}
 			if(appender.level != LogLevel::UNKNOWN){
 				appender_node["level"] = LogLevelTOString(appender.level);
@@ -777,6 +2326,14 @@ struct LogIniter
 						ap.reset(new FileLogAppender(appender.file));
 					}else if(appender.type == 2){
 						ap.reset(new StdoutLogAppender());
+					}else if(appender.type == 3){
+						ap.reset(new AsyncFileLogAppender(appender.file, appender.buffer_size, appender.flush_interval
+										, AsyncFileLogAppender::PolicyFromString(appender.policy)));
+					}else if(appender.type == 4){
+						ap.reset(new BinaryLogAppender(appender.file, appender.buffer_size, appender.flush_interval));
+					}else if(appender.type == 5){
+						ap.reset(new MmapFileLogAppender(appender.file, appender.segment_size
+										, appender.segment_count, appender.sync_interval));
 					}else{
 						//类型错误，添加该appender
 						continue;
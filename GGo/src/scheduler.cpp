@@ -1,6 +1,7 @@
 #include"scheduler.h"
 #include"logSystem.h"
 #include"macro.h"
+#include"config.h"
 #include "hook.h"
 
 namespace GGo{
@@ -11,6 +12,11 @@ static GGo::Logger::ptr g_logger = GGO_LOG_NAME("system");
 static thread_local Scheduler* t_scheduler = nullptr;
 /// @brief 当前线程调度协程
 static thread_local Fiber* t_scheduler_fiber = nullptr;
+/// @brief 当前线程在所属调度器中的队列下标
+static thread_local int t_queue_index = -1;
+
+static ConfigVar<uint32_t>::ptr g_inject_queue_size =
+    Config::Lookup<uint32_t>("scheduler.inject_queue_size", 1024, "scheduler per-thread lock-free inject queue size, 0 to disable");
 
 Scheduler::Scheduler(size_t thread_pool_size, bool use_caller, const std::string &name)
                     :m_name(name)
@@ -31,10 +37,22 @@ Scheduler::Scheduler(size_t thread_pool_size, bool use_caller, const std::string
         t_scheduler_fiber = m_rootFiber.get();
         m_rootThread = GGo::GetThreadID();
         m_threadIDs.push_back(m_rootThread);
+        t_queue_index = 0;
     }else{
         m_rootThread = -1;
     }
     m_threadCount = thread_pool_size;
+
+    // 队列在构造时一次性创建，之后不再增删，读取无需加锁
+    size_t queue_count = m_threadCount + (use_caller ? 1 : 0);
+    m_useInject = g_inject_queue_size->getValue() != 0;
+    m_queues.resize(queue_count);
+    for(size_t i = 0; i < queue_count; i++){
+        m_queues[i].reset(new WorkQueue(g_inject_queue_size->getValue()));
+    }
+    if(use_caller){
+        m_queues[0]->owner = m_rootThread;
+    }
 }
 
 Scheduler::~Scheduler()
@@ -60,12 +78,18 @@ void Scheduler::start()
         return;
     }
     m_isStopping = false;
-    GGO_ASSERT(m_missons.empty());
 
     m_threads.resize(m_threadCount);
+    size_t offset = m_queues.size() - m_threadCount;
     for(size_t i = 0; i < m_threadCount; i++){
-        m_threads[i].reset(new Thread(std::bind(&Scheduler::run, this),
+        int index = offset + i;
+        m_threads[i].reset(new Thread([this, index](){
+                                t_queue_index = index;
+                                m_queues[index]->owner = GGo::GetThreadID();
+                                run();
+                            },
                             m_name + "_" + std::to_string(i + 1)));
+        m_queues[index]->owner = m_threads[i]->getID();
         m_threadIDs.push_back(m_threads[i]->getID()); 
     }
 }
@@ -134,28 +158,8 @@ void Scheduler::run()
         bool tickle_me = false;
         bool is_active = false;
         // 在任务队列中取任务
-        {
-            mutexType::Lock lock(m_mutex);
-
-            auto it = m_missons.begin();
-            while(it != m_missons.end()){
-                if(it->thread != -1 && it->thread != GGo::GetThreadID()){
-                    it++;
-                    tickle_me = true;
-                    continue;   
-                }
-                GGO_ASSERT(it->fiber || it->cb);
-                if(it->fiber && it->fiber->getState() == Fiber::State::EXEC){
-                    it++;
-                    continue;
-                }
-                mission = *it;
-                m_missons.erase(it);
-                m_activeThreadCount++;
-                is_active = true;
-                break;
-            }
-            tickle_me |= it != m_missons.end();
+        if(popMisson(mission, tickle_me)){
+            is_active = true;
         }
 
         if(tickle_me){
@@ -166,21 +170,26 @@ void Scheduler::run()
                             && mission.fiber->getState() != Fiber::State::EXCEPT){
             // 执行前任务不可以是结束状态和出错状态
             mission.fiber->swapIn();
-            m_activeThreadCount--;
             if(mission.fiber->getState() == Fiber::State::READY){
                 // 执行完是ready状态，可以继续进入调度队列
                 schedule(mission.fiber);
+            }else if(mission.fiber->getState() == Fiber::State::TERM
+                    || mission.fiber->getState() == Fiber::State::EXCEPT){
+                // 已结束且没有其他引用的协程放回本线程缓存，供后续回调任务复用
+                Fiber::Recycle(mission.fiber);
             }
+            m_activeThreadCount--;
             mission.reset();
+            // 任务可能执行了很久，刷新缓存时间，后续任务的定时器与日志不会用到过期的时间
+            refreshCoarseClock();
         }else if(mission.cb){
             if(cb_fiber){
-                cb_fiber->reset(mission.cb);
+                cb_fiber->reset(std::move(mission.cb));
             }else{
-                cb_fiber.reset(new Fiber(mission.cb));
+                cb_fiber = Fiber::Create(std::move(mission.cb), Fiber::SharedStackByDefault());
             }
             mission.reset();
             cb_fiber->swapIn();
-            m_activeThreadCount--;
             if(cb_fiber->getState() == Fiber::State::READY){
                 // 执行完是ready状态，可以继续进入调度队列
                 schedule(cb_fiber);
@@ -192,6 +201,8 @@ void Scheduler::run()
             }else{
                 cb_fiber.reset();
             }
+            m_activeThreadCount--;
+            refreshCoarseClock();
         }else{
             if(is_active){
                 --m_activeThreadCount;
@@ -215,9 +226,9 @@ void Scheduler::run()
 }
 bool Scheduler::canStopNow()
 {
-    mutexType::Lock lock(m_mutex);
+    // 先检查活跃线程再检查队列，与popMisson中先登记活跃再出队的顺序配合
     return m_autoStop && m_isStopping
-            && m_missons.empty() && m_activeThreadCount == 0;
+            && m_activeThreadCount == 0 && allQueuesEmpty();
 }
 void Scheduler::idle()
 {
@@ -231,4 +242,171 @@ void Scheduler::setThis()
 {
     t_scheduler = this;
 }
+int Scheduler::queueIndexOf(int thread) const
+{
+    for(size_t i = 0; i < m_queues.size(); i++){
+        if(m_queues[i]->owner == thread){
+            return i;
+        }
+    }
+    return -1;
+}
+int Scheduler::currentQueueIndex() const
+{
+    if(t_scheduler != this){
+        return -1;
+    }
+    return t_queue_index;
+}
+bool Scheduler::pushMisson(Misson &misson)
+{
+    if(misson.fiber && misson.fiber->getStackThread() != -1){
+        // 共享栈协程只能回到绑定的线程上执行
+        misson.thread = misson.fiber->getStackThread();
+    }
+    int index = -1;
+    if(misson.thread != -1){
+        index = queueIndexOf(misson.thread);
+        if(GGO_UNLIKELY(index == -1)){
+            // 指定的线程不属于本调度器（或尚未启动），退化为任意线程执行
+            GGO_LOG_WARN(g_logger) << m_name << " schedule to unknown thread="
+                                   << misson.thread << ", run on any thread";
+            misson.thread = -1;
+        }
+    }
+    if(index == -1){
+        index = currentQueueIndex();
+    }
+    if(index == -1){
+        // 外部线程提交普通任务：轮转选择队列，走无锁注入队列，不加锁也不申请内存
+        static thread_local size_t t_next_queue = 0;
+        index = t_next_queue++ % m_queues.size();
+        WorkQueue& queue = *m_queues[index];
+        bool was_empty = queue.inject.empty();
+        if(GGO_LIKELY(m_useInject) && GGO_LIKELY(queue.inject.push(misson))){
+            return was_empty;
+        }
+        // 注入队列已满或者关闭，退回加锁路径
+    }
+
+    WorkQueue& queue = *m_queues[index];
+    bool need_tickle = false;
+    {
+        mutexType::Lock lock(queue.mutex);
+        need_tickle = queue.pinned.empty() && queue.missons.empty();
+        if(misson.thread != -1){
+            queue.pinned.push_back(std::move(misson));
+        }else{
+            queue.missons.push_back(std::move(misson));
+        }
+    }
+    return need_tickle;
+}
+bool Scheduler::popMisson(Misson &misson, bool &tickle_me)
+{
+    int self = currentQueueIndex();
+    GGO_ASSERT(self != -1);
+    WorkQueue& queue = *m_queues[self];
+    // 先登记为活跃线程再出队，保证canStopNow看不到"任务已出队但线程未活跃"的中间状态
+    m_activeThreadCount++;
+    {
+        mutexType::Lock lock(queue.mutex);
+        // 先取只能由本线程执行的任务，再取普通任务
+        for(auto* dq : {&queue.pinned, &queue.missons}){
+            size_t n = dq->size();
+            for(size_t i = 0; i < n; i++){
+                Misson& front = dq->front();
+                GGO_ASSERT(front.fiber || front.cb);
+                if(front.fiber && front.fiber->getState() == Fiber::State::EXEC){
+                    // 协程还在其他线程上运行（尚未完成切出），放到队尾稍后再试
+                    Misson busy = std::move(front);
+                    dq->pop_front();
+                    dq->push_back(std::move(busy));
+                    tickle_me = true;
+                    continue;
+                }
+                misson = std::move(front);
+                dq->pop_front();
+                tickle_me |= !queue.pinned.empty() || !queue.missons.empty()
+                            || !queue.inject.empty();
+                return true;
+            }
+        }
+    }
+    if(popInject(queue, misson, tickle_me)
+            || stealMisson(self, misson, tickle_me)){
+        return true;
+    }
+    m_activeThreadCount--;
+    return false;
+}
+bool Scheduler::popInject(WorkQueue &queue, Misson &misson, bool &tickle_me)
+{
+    while(queue.inject.pop(misson)){
+        GGO_ASSERT(misson.fiber || misson.cb);
+        if(misson.fiber && misson.fiber->getState() == Fiber::State::EXEC){
+            mutexType::Lock lock(queue.mutex);
+            queue.missons.push_back(std::move(misson));
+            misson.reset();
+            tickle_me = true;
+            continue;
+        }
+        tickle_me |= !queue.inject.empty();
+        return true;
+    }
+    return false;
+}
+bool Scheduler::stealMisson(size_t self, Misson &misson, bool &tickle_me)
+{
+    size_t count = m_queues.size();
+    for(size_t i = 1; i < count; i++){
+        WorkQueue& victim = *m_queues[(self + i) % count];
+        {
+            mutexType::Lock lock(victim.mutex);
+            if(!victim.missons.empty()){
+                Misson& back = victim.missons.back();
+                if(back.fiber && back.fiber->getState() == Fiber::State::EXEC){
+                    tickle_me = true;
+                }else{
+                    misson = std::move(back);
+                    victim.missons.pop_back();
+                    tickle_me |= !victim.missons.empty();
+                    return true;
+                }
+            }
+        }
+        if(popInject(victim, misson, tickle_me)){
+            return true;
+        }
+    }
+    return false;
+}
+bool Scheduler::hasMisson()
+{
+    int self = currentQueueIndex();
+    for(size_t i = 0; i < m_queues.size(); i++){
+        WorkQueue& queue = *m_queues[i];
+        if(!queue.inject.empty()){
+            return true;
+        }
+        mutexType::Lock lock(queue.mutex);
+        if(!queue.missons.empty() || ((int)i == self && !queue.pinned.empty())){
+            return true;
+        }
+    }
+    return false;
+}
+bool Scheduler::allQueuesEmpty()
+{
+    for(auto& queue : m_queues){
+        if(!queue->inject.empty()){
+            return false;
+        }
+        mutexType::Lock lock(queue->mutex);
+        if(!queue->pinned.empty() || !queue->missons.empty()){
+            return false;
+        }
+    }
+    return true;
+}
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "ioScheduler.h"
 #include "util.h"
 #include "hook.h"
+#include <sys/sendfile.h>
 
 namespace GGo{
 
@@ -111,6 +112,19 @@ bool Socket::setOption(int level, int option, const void *result, socklen_t len)
     return true;
 }
 
+bool Socket::enableReusePort()
+{
+    if(!isValid()){
+        newSock();
+        if(!isValid()){
+            GGO_LOG_ERROR(g_logger) << "Socket::newSock() error";
+            return false;
+        }
+    }
+    int val = 1;
+    return setOption(SOL_SOCKET, SO_REUSEPORT, val);
+}
+
 bool Socket::bind(const Address::ptr addr)
 {
     if(!isValid()){
@@ -249,6 +263,14 @@ int Socket::send(const iovec *buffers, size_t len, int flags)
     return -1;
 }
 
+int Socket::sendFile(int fd, off_t *offset, size_t len)
+{
+    if(isConnected()){
+        return ::sendfile(m_socket, fd, offset, len);
+    }
+    return -1;
+}
+
 int Socket::sendTo(const void *buffer, size_t len, const Address::ptr dst, int flags)
 {
     if(isConnected()){
@@ -1,5 +1,6 @@
 #include "streams/socketStream.h"
 #include "socketStream.h"
+#include <limits.h>
 
 namespace GGo{
 SocketStream::SocketStream(Socket::ptr socket, bool isOwner)
@@ -60,6 +61,49 @@ int SocketStream::write(ByteArray::ptr ba, size_t len)
     return rt;
 }
 
+int64_t SocketStream::writevFixSize(iovec* iovs, size_t count)
+{
+    if(!isConnected()){
+        return -1;
+    }
+    int64_t total = 0;
+    while(count){
+        int64_t rt = m_socket->send(iovs, std::min(count, (size_t)IOV_MAX));
+        if(rt <= 0){
+            return rt;
+        }
+        total += rt;
+        // 跳过已经写完的数据块，调整写了一部分的数据块
+        while(count && rt >= (int64_t)iovs->iov_len){
+            rt -= iovs->iov_len;
+            iovs++;
+            count--;
+        }
+        if(count){
+            iovs->iov_base = (char*)iovs->iov_base + rt;
+            iovs->iov_len -= rt;
+        }
+    }
+    return total;
+}
+
+int64_t SocketStream::sendFileFixSize(int fd, off_t offset, size_t len)
+{
+    if(!isConnected()){
+        return -1;
+    }
+    size_t left = len;
+    while(left){
+        // 返回值是int，每次最多发送1G
+        int rt = m_socket->sendFile(fd, &offset, std::min(left, (size_t)1 << 30));
+        if(rt <= 0){
+            return rt;
+        }
+        left -= rt;
+    }
+    return len;
+}
+
 void SocketStream::close()
 {
     if(m_socket){
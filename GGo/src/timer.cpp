@@ -1,65 +1,94 @@
 #include"timer.h"
+#include"timerQueue.h"
+#include"config.h"
 #include"util.h"
+#include"macro.h"
 
 namespace GGo{
+
+static ConfigVar<bool>::ptr g_timer_wheel =
+    Config::Lookup<bool>("timer.wheel", false, "store timers in a hierarchical timing wheel instead of a sorted set");
+
+/// @brief 一份定时器存储
+struct TimerManager::Store{
+    // 定时器容器，由配置 timer.wheel 选择有序集合或时间轮
+    std::unique_ptr<TimerQueue> queue;
+    // 上次执行时间
+    uint64_t previouseTime = 0;
+    // 定时器数量，供其他线程无锁判断是否还有定时器
+    std::atomic<size_t> count = {0};
+    // 其他线程发来的消息
+    Mutex inboxMutex;
+    std::vector<Message> inbox;
+    std::atomic<bool> hasMessage = {false};
+
+    Store(){
+        previouseTime = GGo::now(GGo::COARSE);
+        if(g_timer_wheel->getValue()){
+            queue.reset(new TimingWheel(previouseTime));
+        }else{
+            queue.reset(new TimerSet);
+        }
+    }
+};
+
+/// @brief 发给定时器所在存储的操作
+struct TimerManager::Message{
+    enum Type{
+        CANCEL,
+        REFRESH,
+        RESET,
+        // 从原存储中取出，交给target
+        MIGRATE,
+        // 加入迁移过来的定时器
+        ADOPT,
+    };
+    Type type;
+    Timer::ptr timer;
+    // RESET的参数
+    uint64_t ms = 0;
+    bool from_now = false;
+    // MIGRATE的目标存储
+    int target = -1;
+};
+
 bool Timer::cancel()
 {
-    TimerManager::RWMutexType::writeLock lock(m_manager->m_mutex);
-    if(m_cb == nullptr){
-        return false;
-    }
-    m_cb = nullptr;
-    auto it = m_manager->m_timers.find(shared_from_this());
-    if (it == m_manager->m_timers.end())
-    {
-        return false;
-    }
-    m_manager->m_timers.erase(it);
-    return true;
+    TimerManager::Message msg;
+    msg.type = TimerManager::Message::CANCEL;
+    msg.timer = shared_from_this();
+    return m_manager->apply(msg);
 }
 
 bool Timer::refresh()
 {
-    TimerManager::RWMutexType::writeLock lock(m_manager->m_mutex);
-    if(!m_cb){
-        return false;
-    }
-    auto it = m_manager->m_timers.find(shared_from_this());
-    if(it == m_manager->m_timers.end()){
-        return false;
-    }
-    //如果没有回调函数或者管理器内没有找到这个计时器，则直接跳出，返回失败
-    m_manager->m_timers.erase(it);
-    m_next = GGo::getCurrentMS() + m_ms;
-    m_manager->m_timers.insert(shared_from_this());
-    return true;
+    TimerManager::Message msg;
+    msg.type = TimerManager::Message::REFRESH;
+    msg.timer = shared_from_this();
+    return m_manager->apply(msg);
 }
 
 bool Timer::reset(uint64_t ms, bool from_now)
 {
-    if(m_ms == ms && !from_now){
+    TimerManager::Message msg;
+    msg.type = TimerManager::Message::RESET;
+    msg.timer = shared_from_this();
+    msg.ms = ms;
+    msg.from_now = from_now;
+    return m_manager->apply(msg);
+}
+
+bool Timer::migrate()
+{
+    int target = m_manager->getTimerStore();
+    if(m_store == target){
         return true;
     }
-    TimerManager::RWMutexType::writeLock lock(m_manager->m_mutex);
-    if(m_cb == nullptr){
-        return false;
-    }
-    auto it = m_manager->m_timers.find(shared_from_this());
-    if(it == m_manager->m_timers.end()){
-        return false;
-    }
-    m_manager->m_timers.erase(it);
-    //TODO::这段没看懂，from_now的作用与锁的传递
-    uint64_t start = 0;
-    if(from_now){
-        start = GGo::getCurrentMS();
-    }else{
-        start = m_next - m_ms;
-    }
-    m_ms = ms;
-    m_next = start + m_ms;
-    m_manager->addTimer(shared_from_this(),lock);
-    return true;
+    TimerManager::Message msg;
+    msg.type = TimerManager::Message::MIGRATE;
+    msg.timer = shared_from_this();
+    msg.target = target;
+    return m_manager->apply(msg);
 }
 
 Timer::Timer(uint64_t ms, std::function<void()> cb, bool reloop, TimerManager *manager)
@@ -68,7 +97,8 @@ Timer::Timer(uint64_t ms, std::function<void()> cb, bool reloop, TimerManager *m
             ,m_cb(cb)
             ,m_manager(manager)
 {
-    m_next = GGo::getCurrentMS() + m_ms;
+    // 到期时间以精确时间为起点，缓存时间落后时定时器不会提前触发
+    m_next = GGo::now() + m_ms;
 }
 
 Timer::Timer(uint64_t next)
@@ -78,7 +108,7 @@ Timer::Timer(uint64_t next)
 
 TimerManager::TimerManager()
 {
-    m_previouseTime = GGo::getCurrentMS();
+    m_shared.reset(new Store);
 }
 
 TimerManager::~TimerManager()
@@ -88,8 +118,7 @@ TimerManager::~TimerManager()
 Timer::ptr TimerManager::addTimer(uint64_t ms, std::function<void()> cb, bool reloop)
 {   
     Timer::ptr timer(new Timer(ms, cb, reloop, this));
-    RWMutexType::writeLock lock(m_mutex);
-    addTimer(timer, lock);
+    insert(timer, getTimerStore());
     return timer;
 }
 
@@ -108,84 +137,275 @@ Timer::ptr TimerManager::addConditionTimer(uint64_t ms, std::function<void()> cb
 
 uint64_t TimerManager::getNextTimer()
 {
-    RWMutexType::readLock lock(m_mutex);
+    uint64_t next = ~0ull;
+    int index = getTimerStore();
+    if(index != -1){
+        Store& store = *m_stores[index];
+        drain(store, index);
+        next = store.queue->nextExpire();
+    }
     m_tickled = false;
-    if(m_timers.empty()){
+    if(m_shared->count != 0){
+        // 时间轮计算下一个到期时间时会更新内部状态，需要写锁
+        RWMutexType::writeLock lock(m_mutex);
+        uint64_t shared_next = m_shared->queue->nextExpire();
+        if(shared_next < next){
+            next = shared_next;
+        }
+    }
+    if(next == ~0ull){
         return ~0ull;
     }
 
-    const Timer::ptr next = *m_timers.begin();
-    uint64_t now_ms = GGo::getCurrentMS();
-    if(now_ms >= next->m_next){
+    uint64_t now_ms = GGo::now(GGo::COARSE);
+    if(now_ms >= next){
         return 0;
     }else{
-        return next->m_next - now_ms;
+        return next - now_ms;
     }
 }
 
 void TimerManager::listExpriedCb(std::vector<std::function<void()>> &cbs)
 {
-    uint64_t now_ms = GGo::getCurrentMS();
-    std::vector<Timer::ptr> expried;
-    //TODO:: 这次检查有必要吗
-    {
-        RWMutexType::readLock lock(m_mutex);
-        if(m_timers.empty()){
-            return;
+    uint64_t now_ms = GGo::now(GGo::COARSE);
+    int index = getTimerStore();
+    if(index != -1){
+        // 本线程的存储只有自己访问，不需要加锁
+        Store& store = *m_stores[index];
+        drain(store, index);
+        if(store.count != 0){
+            expire(store, now_ms, cbs);
         }
     }
+    if(m_shared->count == 0){
+        return;
+    }
     RWMutexType::writeLock lock(m_mutex);
-    if(m_timers.empty()){
+    if(m_shared->count == 0){
         return;
     }
-    bool isRollover = detectClockRollover(now_ms);
-    if(!isRollover && ((*m_timers.begin())->m_next > now_ms)){
+    expire(*m_shared, now_ms, cbs);
+}
+
+bool TimerManager::hasTimer()
+{
+    if(m_shared->count != 0){
+        return true;
+    }
+    for(auto& store : m_stores){
+        if(store->count != 0 || store->hasMessage){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TimerManager::detectClockRollover(Store& store, uint64_t now_ms)
+{
+    bool isRollover = false;
+
+    if(now_ms < store.previouseTime && now_ms < (store.previouseTime - 60 * 60 * 1000)){
+        isRollover = true;
+    }
+    store.previouseTime = now_ms;
+    return isRollover;
+}
+
+bool TimerManager::apply(Message &msg)
+{
+    while(true){
+        int index = msg.timer->m_store.load(std::memory_order_acquire);
+        if(index == -1){
+            RWMutexType::writeLock lock(m_mutex);
+            if(msg.timer->m_store != -1){
+                // 加锁前被迁移走了
+                continue;
+            }
+            return handle(*m_shared, -1, msg, &lock);
+        }
+        if(index == getTimerStore()){
+            return handle(*m_stores[index], index, msg, nullptr);
+        }
+        // 定时器在其他线程的存储中，只能发消息给拥有者
+        bool rt = true;
+        if(msg.type == Message::CANCEL){
+            rt = !msg.timer->m_cancelled.exchange(true);
+            if(!rt){
+                return false;
+            }
+        }
+        post(index, msg);
+        return rt;
+    }
+}
+
+bool TimerManager::handle(Store &store, int index, Message &msg, RWMutexType::writeLock* lock)
+{
+    Timer::ptr& timer = msg.timer;
+    if(timer->m_store != index){
+        // 消息发出后定时器已经迁移走，转发给它现在的存储
+        return apply(msg);
+    }
+    if(msg.type == Message::ADOPT){
+        if(timer->m_cancelled){
+            timer->m_cb = nullptr;
+            return false;
+        }
+        store.queue->insert(timer);
+        store.count = store.queue->size();
+        return true;
+    }
+    if(msg.type == Message::CANCEL){
+        timer->m_cancelled = true;
+        if(!timer->m_cb){
+            return false;
+        }
+        timer->m_cb = nullptr;
+        bool rt = store.queue->erase(timer);
+        store.count = store.queue->size();
+        return rt;
+    }
+    if(!timer->m_cb || timer->m_cancelled){
+        return false;
+    }
+    if(msg.type == Message::RESET && timer->m_ms == msg.ms && !msg.from_now){
+        return true;
+    }
+    //如果没有回调函数或者管理器内没有找到这个计时器，则直接跳出，返回失败
+    if(!store.queue->erase(timer)){
+        return false;
+    }
+    store.count = store.queue->size();
+
+    switch(msg.type){
+        case Message::REFRESH:
+            timer->m_next = GGo::now() + timer->m_ms;
+            store.queue->insert(timer);
+            store.count = store.queue->size();
+            return true;
+        case Message::RESET:
+        {
+            uint64_t start = 0;
+            if(msg.from_now){
+                start = GGo::now();
+            }else{
+                start = timer->m_next - timer->m_ms;
+            }
+            timer->m_ms = msg.ms;
+            timer->m_next = start + timer->m_ms;
+            if(index == -1){
+                addTimer(timer, *lock);
+            }else{
+                store.queue->insert(timer);
+                store.count = store.queue->size();
+            }
+            return true;
+        }
+        case Message::MIGRATE:
+            if(msg.target == -1 || msg.target == getTimerStore()){
+                // 目标是共享存储或本线程的存储，可以直接加入
+                timer->m_store = msg.target;
+                if(lock){
+                    lock->unlock();
+                }
+                insert(timer, msg.target);
+            }else{
+                // 先修改所在存储再发送，之后发给这个定时器的消息都会排在ADOPT之后
+                timer->m_store = msg.target;
+                Message adopt;
+                adopt.type = Message::ADOPT;
+                adopt.timer = timer;
+                post(msg.target, adopt);
+            }
+            return true;
+        default:
+            GGO_ASSERT2(false, "invalid timer message");
+    }
+    return false;
+}
+
+void TimerManager::post(size_t index, Message &msg)
+{
+    Store& store = *m_stores[index];
+    {
+        Mutex::Lock lock(store.inboxMutex);
+        store.inbox.push_back(msg);
+        store.hasMessage = true;
+    }
+    onTimerMessage(index);
+}
+
+void TimerManager::drain(Store &store, int index)
+{
+    if(!store.hasMessage.load(std::memory_order_acquire)){
         return;
     }
+    std::vector<Message> inbox;
+    {
+        Mutex::Lock lock(store.inboxMutex);
+        inbox.swap(store.inbox);
+        store.hasMessage = false;
+    }
+    for(auto& msg : inbox){
+        handle(store, index, msg, nullptr);
+    }
+}
 
-    Timer::ptr now_timer(new Timer(now_ms));
-    auto it = isRollover ? m_timers.end() : m_timers.lower_bound(now_timer);
-    while(it != m_timers.end() && (*it)->m_next == now_ms){
-        it++;
+void TimerManager::expire(Store &store, uint64_t now_ms, std::vector<std::function<void()>> &cbs)
+{
+    std::vector<Timer::ptr> expried;
+    bool isRollover = detectClockRollover(store, now_ms);
+    if(isRollover){
+        store.queue->popAll(expried);
+    }else{
+        store.queue->popExpired(now_ms, expried);
     }
-    expried.insert(expried.begin(), m_timers.begin(), it);
-    m_timers.erase(m_timers.begin(), it);
-    cbs.reserve(expried.size());
+    cbs.reserve(cbs.size() + expried.size());
     for(auto& timer : expried){
+        if(timer->m_cancelled){
+            // 其他线程已经取消，取消消息还没有处理
+            timer->m_cb = nullptr;
+            continue;
+        }
         cbs.push_back(timer->m_cb);
         if(timer->m_reloop){
             timer->m_next = now_ms + timer->m_ms;
-            m_timers.insert(timer);
+            store.queue->insert(timer);
         }else{
             timer->m_cb = nullptr;
         }
     }
-
+    store.count = store.queue->size();
 }
 
-bool TimerManager::hasTimer()
+void TimerManager::insert(Timer::ptr timer, int index)
 {
-    RWMutexType::readLock lock(m_mutex);
-    return !m_timers.empty();
+    timer->m_store = index;
+    if(index != -1){
+        Store& store = *m_stores[index];
+        store.queue->insert(timer);
+        store.count = store.queue->size();
+        return;
+    }
+    RWMutexType::writeLock lock(m_mutex);
+    addTimer(timer, lock);
 }
 
-bool TimerManager::detectClockRollover(uint64_t now_ms)
+void TimerManager::initTimerStores(size_t count)
 {
-    bool isRollover = false;
-
-    if(now_ms < m_previouseTime && now_ms < (m_previouseTime - 60 * 60 * 1000)){
-        isRollover = true;
+    GGO_ASSERT(m_stores.empty());
+    m_stores.resize(count);
+    for(auto& store : m_stores){
+        store.reset(new Store);
     }
-    m_previouseTime = now_ms;
-    return isRollover;
 }
 
 void TimerManager::addTimer(Timer::ptr timer, RWMutexType::writeLock &lock)
 {
-    auto it = m_timers.insert(timer).first;
-    bool at_front = (it == m_timers.begin()) && !m_tickled;
-    if(at_front){
-        m_tickled = true;
+    bool at_front = m_shared->queue->insert(timer);
+    m_shared->count = m_shared->queue->size();
+    if(at_front && m_tickled.exchange(true)){
+        at_front = false;
     }
     lock.unlock();
     if(at_front){
@@ -208,7 +428,7 @@ bool Timer::Comparator::operator()(const Timer::ptr &lhs, const Timer::ptr &rhs)
     if(lhs->m_next < rhs->m_next){
         return true;
     }
-    if(rhs->m_next > rhs->m_next){
+    if(lhs->m_next > rhs->m_next){
         return false;
     }
     return lhs.get() < rhs.get();
@@ -0,0 +1,268 @@
+#include"timerQueue.h"
+
+namespace GGo{
+
+bool TimerSet::insert(const Timer::ptr &timer)
+{
+    auto it = m_timers.insert(timer).first;
+    return it == m_timers.begin();
+}
+
+bool TimerSet::erase(const Timer::ptr &timer)
+{
+    auto it = m_timers.find(timer);
+    if(it == m_timers.end()){
+        return false;
+    }
+    m_timers.erase(it);
+    return true;
+}
+
+uint64_t TimerSet::nextExpire()
+{
+    if(m_timers.empty()){
+        return ~0ull;
+    }
+    return (*m_timers.begin())->m_next;
+}
+
+void TimerSet::popExpired(uint64_t now_ms, std::vector<Timer::ptr> &expired)
+{
+    if(m_timers.empty() || (*m_timers.begin())->m_next > now_ms){
+        return;
+    }
+    Timer::ptr now_timer(new Timer(now_ms));
+    auto it = m_timers.lower_bound(now_timer);
+    while(it != m_timers.end() && (*it)->m_next == now_ms){
+        it++;
+    }
+    expired.insert(expired.end(), m_timers.begin(), it);
+    m_timers.erase(m_timers.begin(), it);
+}
+
+void TimerSet::popAll(std::vector<Timer::ptr> &expired)
+{
+    expired.insert(expired.end(), m_timers.begin(), m_timers.end());
+    m_timers.clear();
+}
+
+TimingWheel::TimingWheel(uint64_t now_ms)
+    :m_current(now_ms)
+{
+    for(int level = 0; level < LEVELS; level++){
+        m_slots[level].resize(slots(level), nullptr);
+        m_bitmaps[level].resize((slots(level) + 63) / 64, 0);
+    }
+}
+
+TimingWheel::~TimingWheel()
+{
+    // 释放定时器对自身的引用
+    std::vector<Timer::ptr> timers;
+    popAll(timers);
+}
+
+bool TimingWheel::insert(const Timer::ptr &timer)
+{
+    timer->m_wheelHold = timer;
+    place(timer.get());
+    m_size++;
+    if(timer->m_next < m_earliest){
+        m_earliest = timer->m_next;
+        return true;
+    }
+    return false;
+}
+
+bool TimingWheel::erase(const Timer::ptr &timer)
+{
+    if(timer->m_wheelLevel < 0){
+        return false;
+    }
+    unlink(timer.get());
+    m_size--;
+    timer->m_wheelHold.reset();
+    return true;
+}
+
+uint64_t TimingWheel::nextExpire()
+{
+    if(m_size == 0){
+        m_earliest = ~0ull;
+        return m_earliest;
+    }
+    uint64_t earliest = ~0ull;
+    int distance = findSlot(0, m_current & (slots(0) - 1));
+    if(distance >= 0){
+        earliest = m_current + distance;
+    }
+    for(int level = 1; level < LEVELS; level++){
+        // 当前槽只有在正好处于本层边界时才会马上下放，否则要再转一整圈
+        uint64_t block = m_current >> shift(level);
+        bool aligned = (m_current & ((1ull << shift(level)) - 1)) == 0;
+        if(!aligned){
+            block++;
+        }
+        distance = findSlot(level, block & (slots(level) - 1));
+        if(distance < 0){
+            continue;
+        }
+        // 上层槽内定时器的到期时间不早于该槽开始下放的时间
+        uint64_t start = (block + distance) << shift(level);
+        if(start < earliest){
+            earliest = start;
+        }
+    }
+    m_earliest = earliest;
+    return earliest;
+}
+
+void TimingWheel::popExpired(uint64_t now_ms, std::vector<Timer::ptr> &expired)
+{
+    const uint64_t root_mask = slots(0) - 1;
+    while(m_current <= now_ms){
+        if(m_size == 0){
+            m_current = now_ms + 1;
+            break;
+        }
+        uint32_t index = m_current & root_mask;
+        if(index == 0){
+            for(int level = 1; level < LEVELS; level++){
+                cascade(level);
+                if(((m_current >> shift(level)) & (slots(level) - 1)) != 0){
+                    break;
+                }
+            }
+        }
+        Timer* timer = m_slots[0][index];
+        m_slots[0][index] = nullptr;
+        m_bitmaps[0][index >> 6] &= ~(1ull << (index & 63));
+        while(timer){
+            Timer* next = timer->m_wheelNext;
+            timer->m_wheelLevel = -1;
+            timer->m_wheelPrev = timer->m_wheelNext = nullptr;
+            expired.push_back(std::move(timer->m_wheelHold));
+            m_size--;
+            timer = next;
+        }
+        m_current++;
+
+        // 第0层为空时，下一个可能有定时器的时间是下次下放的时间
+        bool root_empty = true;
+        for(auto word : m_bitmaps[0]){
+            if(word){
+                root_empty = false;
+                break;
+            }
+        }
+        if(root_empty && (m_current & root_mask) != 0){
+            uint64_t next = (m_current | root_mask) + 1;
+            m_current = next < now_ms + 1 ? next : now_ms + 1;
+        }
+    }
+    if(m_earliest <= now_ms){
+        // 最早的定时器已经取出，重新计算，否则新定时器无法判断是否在最前面
+        nextExpire();
+    }
+}
+
+void TimingWheel::popAll(std::vector<Timer::ptr> &expired)
+{
+    for(int level = 0; level < LEVELS; level++){
+        for(uint32_t slot = 0; slot < slots(level); slot++){
+            Timer* timer = m_slots[level][slot];
+            m_slots[level][slot] = nullptr;
+            while(timer){
+                Timer* next = timer->m_wheelNext;
+                timer->m_wheelLevel = -1;
+                timer->m_wheelPrev = timer->m_wheelNext = nullptr;
+                expired.push_back(std::move(timer->m_wheelHold));
+                timer = next;
+            }
+        }
+        for(auto& word : m_bitmaps[level]){
+            word = 0;
+        }
+    }
+    m_size = 0;
+    m_earliest = ~0ull;
+}
+
+void TimingWheel::place(Timer *timer)
+{
+    uint64_t expire = timer->m_next < m_current ? m_current : timer->m_next;
+    uint64_t delta = expire - m_current;
+    int level = 0;
+    while(level < LEVELS - 1 && delta >= (1ull << shift(level + 1))){
+        level++;
+    }
+    if(level == LEVELS - 1 && delta >= (1ull << (shift(level) + LEVEL_BITS))){
+        // 超出时间轮范围，先放在最高层最远的槽，下放时重新计算
+        expire = m_current + (1ull << (shift(level) + LEVEL_BITS)) - 1;
+    }
+    uint32_t slot = (expire >> shift(level)) & (slots(level) - 1);
+
+    Timer*& head = m_slots[level][slot];
+    timer->m_wheelLevel = level;
+    timer->m_wheelSlot = slot;
+    timer->m_wheelPrev = nullptr;
+    timer->m_wheelNext = head;
+    if(head){
+        head->m_wheelPrev = timer;
+    }
+    head = timer;
+    m_bitmaps[level][slot >> 6] |= 1ull << (slot & 63);
+}
+
+void TimingWheel::unlink(Timer *timer)
+{
+    int level = timer->m_wheelLevel;
+    uint32_t slot = timer->m_wheelSlot;
+    if(timer->m_wheelPrev){
+        timer->m_wheelPrev->m_wheelNext = timer->m_wheelNext;
+    }else{
+        m_slots[level][slot] = timer->m_wheelNext;
+    }
+    if(timer->m_wheelNext){
+        timer->m_wheelNext->m_wheelPrev = timer->m_wheelPrev;
+    }
+    if(!m_slots[level][slot]){
+        m_bitmaps[level][slot >> 6] &= ~(1ull << (slot & 63));
+    }
+    timer->m_wheelLevel = -1;
+    timer->m_wheelPrev = timer->m_wheelNext = nullptr;
+}
+
+void TimingWheel::cascade(int level)
+{
+    uint32_t slot = (m_current >> shift(level)) & (slots(level) - 1);
+    Timer* timer = m_slots[level][slot];
+    if(!timer){
+        return;
+    }
+    // 先摘下整个槽，重新放置的定时器可能回到同一个槽
+    m_slots[level][slot] = nullptr;
+    m_bitmaps[level][slot >> 6] &= ~(1ull << (slot & 63));
+    while(timer){
+        Timer* next = timer->m_wheelNext;
+        place(timer);
+        timer = next;
+    }
+}
+
+int TimingWheel::findSlot(int level, uint32_t slot) const
+{
+    uint32_t count = slots(level);
+    const std::vector<uint64_t>& bitmap = m_bitmaps[level];
+    for(uint32_t i = 0; i < count; ){
+        uint32_t pos = (slot + i) & (count - 1);
+        uint64_t word = bitmap[pos >> 6] >> (pos & 63);
+        if(word){
+            return i + __builtin_ctzll(word);
+        }
+        i += 64 - (pos & 63);
+    }
+    return -1;
+}
+
+}
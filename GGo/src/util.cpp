@@ -1,6 +1,7 @@
 #include "util.h"
 #include <execinfo.h>
 #include <sys/time.h>
+#include <time.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <string.h>
@@ -11,12 +12,22 @@
 
 #include "logSystem.h"
 #include "fiber.h"
+#include "macro.h"
 
 namespace GGo{
     
+// 缓存的线程ID，每条日志都会取线程ID，避免每次都陷入内核
+static thread_local pid_t t_thread_id = 0;
+
 pid_t GetThreadID()
 {
-    return syscall(SYS_gettid);
+    if(GGO_UNLIKELY(t_thread_id == 0)){
+        // fork出的子进程里调用fork的线程ID会变，需要重新获取
+        static int s_atfork = pthread_atfork(nullptr, nullptr, [](){ t_thread_id = 0; });
+        (void)s_atfork;
+        t_thread_id = syscall(SYS_gettid);
+    }
+    return t_thread_id;
 }
 
 uint32_t GetFiberID()
@@ -104,7 +115,43 @@ uint64_t getCurrentUS()
 {
     struct timeval tv;
     gettimeofday(&tv, nullptr);
-    return tv.tv_sec * 1000 * 1000ul + tv.tv_usec / 1000;
+    return tv.tv_sec * 1000 * 1000ul + tv.tv_usec;
+}
+
+// 事件循环缓存的时间(ms)，0表示本线程没有事件循环在刷新
+static thread_local uint64_t t_coarse_ms = 0;
+
+uint64_t now(ClockType type)
+{
+    struct timespec ts;
+    if(type == COARSE){
+        if(t_coarse_ms){
+            return t_coarse_ms;
+        }
+        // 直接读内核tick时更新的时间，不读硬件计数器，精度为一个tick
+        clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    }else{
+        clock_gettime(CLOCK_REALTIME, &ts);
+    }
+    return ts.tv_sec * 1000ul + ts.tv_nsec / 1000000;
+}
+
+uint64_t updateCoarseClock()
+{
+    t_coarse_ms = now(PRECISE);
+    return t_coarse_ms;
+}
+
+void refreshCoarseClock()
+{
+    if(t_coarse_ms){
+        t_coarse_ms = now(PRECISE);
+    }
+}
+
+void clearCoarseClock()
+{
+    t_coarse_ms = 0;
 }
 
 /**
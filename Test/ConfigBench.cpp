@@ -0,0 +1,103 @@
+#include<iostream>
+#include<iomanip>
+#include<chrono>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+/// @brief 原来的读取方式：读锁内拷贝整个值
+template<class T>
+class LegacyConfigVar{
+public:
+    LegacyConfigVar(const T& val)
+        :m_val(val){}
+    const T getValue() {
+        GGo::RWMutex::readLock lock(m_mutex);
+        return m_val;
+    }
+private:
+    T m_val;
+    GGo::RWMutex m_mutex;
+};
+
+/// @brief threads个线程各自调用read共ops次，返回每次读取的纳秒数
+template<class F>
+static double run(int threads, uint64_t ops, F read){
+    uint64_t per_thread = ops / threads;
+    std::atomic<bool> go{false};
+    std::atomic<uint64_t> sink{0};
+    std::vector<GGo::Thread::ptr> workers;
+    for(int i = 0; i < threads; i++){
+        workers.emplace_back(new GGo::Thread([&](){
+            uint64_t sum = 0;
+            while(!go){}
+            for(uint64_t j = 0; j < per_thread; j++){
+                sum += read();
+            }
+            sink += sum;
+        }, "config_" + std::to_string(i)));
+    }
+    auto begin = std::chrono::steady_clock::now();
+    go = true;
+    for(auto& t : workers){
+        t->join();
+    }
+    std::chrono::duration<double, std::nano> used = std::chrono::steady_clock::now() - begin;
+    return used.count() / per_thread;
+}
+
+/// @brief 比较一种类型的三种读取方式
+template<class T, class Size>
+static void bench(const std::string& name, const T& value, Size size, uint64_t ops){
+    LegacyConfigVar<T> legacy(value);
+    auto var = GGo::Config::Lookup<T>("bench." + name, value, "config bench");
+    for(int threads : {1, 4}){
+        double legacy_ns = run(threads, ops, [&](){ return size(legacy.getValue()); });
+        double value_ns = run(threads, ops, [&](){ return size(var->getValue()); });
+        double snapshot_ns = run(threads, ops, [&](){ return size(*var->getSnapshot()); });
+        cout << std::setw(20) << name
+             << std::setw(10) << threads
+             << std::setw(16) << std::fixed << std::setprecision(1) << legacy_ns
+             << std::setw(16) << value_ns
+             << std::setw(16) << snapshot_ns
+             << std::setw(12) << std::setprecision(2) << legacy_ns / snapshot_ns << endl;
+    }
+}
+
+int main(int argc, char** argv){
+    uint64_t ops = argc > 1 ? std::stoull(argv[1]) : 2000000;
+
+    // 发布新值后读到的是新快照，旧快照保持不变
+    auto check = GGo::Config::Lookup<std::vector<int>>("bench.check", std::vector<int>{1, 2}, "config bench");
+    auto old = check->getSnapshot();
+    bool notified = false;
+    check->addListener([&](const std::vector<int>& oldv, const std::vector<int>& newv){
+        // 回调在发布之后执行
+        GGO_ASSERT(check->getSnapshot()->size() == newv.size());
+        notified = true;
+    });
+    check->setValue({1, 2, 3});
+    GGO_ASSERT(notified);
+    GGO_ASSERT(old->size() == 2 && check->getSnapshot()->size() == 3);
+    // 取到的快照不指向线程缓存，同一线程再次读取后不变
+    const auto& held = check->getSnapshot();
+    check->setValue({1, 2, 3, 4});
+    GGO_ASSERT(check->getSnapshot()->size() == 4 && held->size() == 3);
+
+    std::vector<int> vec(64, 7);
+    std::map<std::string, int> map;
+    for(int i = 0; i < 16; i++){
+        map["key_" + std::to_string(i)] = i;
+    }
+    cout << "config read, " << ops << " reads per run" << endl;
+    cout << std::setw(20) << "type"
+         << std::setw(10) << "threads"
+         << std::setw(16) << "legacy ns"
+         << std::setw(16) << "getValue ns"
+         << std::setw(16) << "snapshot ns"
+         << std::setw(12) << "speedup" << endl;
+    bench("int", 42, [](int v){ return (uint64_t)v; }, ops);
+    bench("vector_64", vec, [](const std::vector<int>& v){ return (uint64_t)v.size(); }, ops);
+    bench("map_16", map, [](const std::map<std::string, int>& v){ return (uint64_t)v.size(); }, ops);
+    return 0;
+}
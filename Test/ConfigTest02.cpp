@@ -0,0 +1,117 @@
+#include<iostream>
+#include<fstream>
+#include<unistd.h>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+static const char* FILENAME = "/tmp/ggo_config_test02.yml";
+
+static auto g_port = GGo::Config::Lookup("watch.port", (int)8080, "watch port");
+static auto g_name = GGo::Config::Lookup("watch.name", std::string("ggo"), "watch name");
+static auto g_hosts = GGo::Config::Lookup("watch.hosts", std::vector<std::string>(), "watch hosts");
+static auto g_limits = GGo::Config::Lookup("watch.limits", std::map<std::string, int>(), "watch limits");
+
+static std::atomic<int> s_port_changes{0};
+static std::atomic<int> s_name_changes{0};
+static std::atomic<int> s_hosts_changes{0};
+static std::atomic<int> s_limits_changes{0};
+
+static void write_file(const std::string& path, int port, const std::string& name,
+                       const std::string& host, int limit){
+    std::ofstream ofs(path, std::ios::trunc);
+    ofs << "watch:\n"
+        << "  port: " << port << "\n"
+        << "  name: " << name << "\n"
+        << "  hosts:\n"
+        << "    - 127.0.0.1\n"
+        << "    - " << host << "\n"
+        << "  limits:\n"
+        << "    conn: " << limit << "\n"
+        << "    rps: 100\n";
+}
+
+/// @brief 像编辑器一样写到临时文件再rename覆盖
+static void replace_file(int port, const std::string& name, const std::string& host, int limit){
+    std::string tmp = std::string(FILENAME) + ".tmp";
+    write_file(tmp, port, name, host, limit);
+    GGO_ASSERT(rename(tmp.c_str(), FILENAME) == 0);
+}
+
+/// @brief 等待重新加载次数达到count
+static bool wait_reload(GGo::ConfigWatcher::ptr watcher, uint64_t count){
+    for(int i = 0; i < 300 && watcher->getReloadCount() < count; i++){
+        usleep(10 * 1000);
+    }
+    return watcher->getReloadCount() >= count;
+}
+
+/// @brief 只有子树发生变化的配置项被重新解析
+void test_diff(){
+    YAML::Node old_root = YAML::Load("watch: {port: 1, name: a, hosts: [x, y], limits: {conn: 1}}");
+    YAML::Node same = YAML::Load("watch: {name: a, port: 1, limits: {conn: 1}, hosts: [x, y]}");
+    GGO_ASSERT(GGo::Config::loadFromYamlDiff(old_root, same) == 0);
+    YAML::Node root = YAML::Load("watch: {port: 1, name: a, hosts: [x, z], limits: {conn: 1}}");
+    GGO_ASSERT(GGo::Config::loadFromYamlDiff(old_root, root) == 1);
+    GGO_ASSERT(g_hosts->getValue() == std::vector<std::string>({"x", "z"}));
+    // 新增的子项
+    YAML::Node added = YAML::Load("watch: {port: 1, name: a, hosts: [x, z], limits: {conn: 1, rps: 5}}");
+    GGO_ASSERT(GGo::Config::loadFromYamlDiff(root, added) == 1);
+    GGO_ASSERT(g_limits->getValue().at("rps") == 5);
+}
+
+/// @brief 修改文件后只通知变化的配置项，连续修改合并成一次加载
+void test_watch(){
+    write_file(FILENAME, 9000, "first", "10.0.0.1", 10);
+    GGo::IOScheduler iom(2, false, "config_watch");
+    GGo::ConfigWatcher::ptr watcher = std::make_shared<GGo::ConfigWatcher>(&iom, 100);
+    GGO_ASSERT(watcher->addFile(FILENAME));
+    GGO_ASSERT(g_port->getValue() == 9000 && g_name->getValue() == "first");
+    GGO_ASSERT(g_limits->getValue().at("conn") == 10);
+
+    g_port->addListener([](const int&, const int&){ s_port_changes++; });
+    g_name->addListener([](const std::string&, const std::string&){ s_name_changes++; });
+    g_hosts->addListener([](const std::vector<std::string>&, const std::vector<std::string>&){ s_hosts_changes++; });
+    g_limits->addListener([](const std::map<std::string, int>&, const std::map<std::string, int>&){ s_limits_changes++; });
+    GGO_ASSERT(watcher->start());
+
+    // 只改端口
+    write_file(FILENAME, 9001, "first", "10.0.0.1", 10);
+    GGO_ASSERT(wait_reload(watcher, 1));
+    GGO_ASSERT(g_port->getValue() == 9001);
+    GGO_ASSERT(s_port_changes == 1 && s_name_changes == 0 && s_hosts_changes == 0 && s_limits_changes == 0);
+
+    // 去抖时间内的多次修改只加载一次，取最后的内容
+    for(int i = 0; i < 5; i++){
+        replace_file(9001, "second", "10.0.0." + std::to_string(i), 10);
+        usleep(20 * 1000);
+    }
+    GGO_ASSERT(wait_reload(watcher, 2));
+    usleep(300 * 1000);
+    GGO_ASSERT(watcher->getReloadCount() == 2);
+    GGO_ASSERT(g_name->getValue() == "second" && g_hosts->getValue().back() == "10.0.0.4");
+    GGO_ASSERT(s_port_changes == 1 && s_name_changes == 1 && s_hosts_changes == 1 && s_limits_changes == 0);
+
+    // 格式错误时保留原来的配置
+    {
+        std::ofstream ofs(FILENAME, std::ios::trunc);
+        ofs << "watch: {port: [\n";
+    }
+    GGO_ASSERT(wait_reload(watcher, 3));
+    GGO_ASSERT(g_port->getValue() == 9001);
+    replace_file(9001, "second", "10.0.0.4", 20);
+    GGO_ASSERT(wait_reload(watcher, 4));
+    GGO_ASSERT(g_limits->getValue().at("conn") == 20);
+    GGO_ASSERT(s_port_changes == 1 && s_name_changes == 1 && s_hosts_changes == 1 && s_limits_changes == 1);
+
+    watcher->stop();
+    watcher.reset();
+    unlink(FILENAME);
+}
+
+int main(){
+    test_diff();
+    test_watch();
+    cout << "ConfigTest02 passed" << endl;
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include<iostream>
+#include<iomanip>
+#include<fstream>
+#include<sys/wait.h>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+/// @brief 读取/proc/self/status中的内存统计(kB)
+static uint64_t read_status_kb(const std::string& key){
+    std::ifstream ifs("/proc/self/status");
+    std::string line;
+    while(std::getline(ifs, line)){
+        if(line.compare(0, key.size(), key) == 0){
+            return std::stoull(line.substr(key.size() + 1));
+        }
+    }
+    return 0;
+}
+
+static std::atomic<uint64_t> s_corrupted{0};
+
+/// @brief 模拟一个挂起在recv上的连接：处理函数用掉一些栈，然后挂起
+static void parked_connection(){
+    volatile char frame[2048];
+    uint64_t id = GGo::Fiber::getFiberID();
+    for(size_t i = 0; i < sizeof(frame); i += 64){
+        frame[i] = (char)(i + id);
+    }
+    GGo::Fiber::getThis()->back();
+    // 恢复后栈内容必须完整
+    for(size_t i = 0; i < sizeof(frame); i += 64){
+        if(frame[i] != (char)(i + id)){
+            s_corrupted++;
+            break;
+        }
+    }
+}
+
+static void bench(bool shared, size_t count){
+    GGo::Fiber::getThis();
+    uint64_t rss_begin = read_status_kb("VmRSS:");
+    uint64_t vm_begin = read_status_kb("VmSize:");
+
+    std::vector<GGo::Fiber::ptr> fibers;
+    fibers.reserve(count);
+    for(size_t i = 0; i < count; i++){
+        GGo::Fiber::ptr fiber(new GGo::Fiber(&parked_connection, 0, true, shared));
+        fiber->call();
+        fibers.push_back(fiber);
+    }
+
+    uint64_t rss = read_status_kb("VmRSS:") - rss_begin;
+    uint64_t vm = read_status_kb("VmSize:") - vm_begin;
+    cout << std::setw(10) << (shared ? "shared" : "private")
+         << std::setw(12) << count
+         << std::setw(16) << std::fixed << std::setprecision(2) << rss * 1024.0 / count
+         << std::setw(16) << vm * 1024.0 / count << endl;
+
+    // 让所有协程正常结束
+    for(auto& fiber : fibers){
+        fiber->call();
+    }
+    if(s_corrupted){
+        cout << "  " << s_corrupted << " fibers found corrupted stacks" << endl;
+    }
+}
+
+int main(int argc, char** argv){
+    size_t count = argc > 1 ? std::stoull(argv[1]) : 10000;
+    cout << "memory per parked fiber" << endl;
+    cout << std::setw(10) << "mode"
+         << std::setw(12) << "fibers"
+         << std::setw(16) << "RSS bytes"
+         << std::setw(16) << "VM bytes" << endl;
+    // 每种模式在独立的子进程中测量，互不影响
+    for(bool shared : {false, true}){
+        pid_t pid = fork();
+        if(pid == 0){
+            bench(shared, count);
+            return 0;
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if(WIFSIGNALED(status)){
+            cout << (shared ? "shared" : "private") << " mode killed by signal "
+                 << WTERMSIG(status) << endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include<iostream>
+#include<iomanip>
+#include<chrono>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+static const size_t STACK_SIZE = 128 * 1024;
+static uint64_t s_rounds = 0;
+
+/// @brief 在两个裸上下文之间来回切换，统计每秒切换次数
+template<class Context>
+struct PingPong{
+    static Context s_main;
+    static Context s_peer;
+
+    static void peer(){
+        while(true){
+            Context::swap(s_peer, s_main);
+        }
+    }
+
+    static double run(uint64_t rounds){
+        char* stack = new char[STACK_SIZE];
+        s_main.init();
+        s_peer.make(stack, STACK_SIZE, &PingPong::peer);
+        auto begin = std::chrono::steady_clock::now();
+        for(uint64_t i = 0; i < rounds; i++){
+            Context::swap(s_main, s_peer);
+        }
+        std::chrono::duration<double> used = std::chrono::steady_clock::now() - begin;
+        delete[] stack;
+        // 每轮切入切出各一次
+        return rounds * 2 / used.count();
+    }
+};
+template<class Context> Context PingPong<Context>::s_main;
+template<class Context> Context PingPong<Context>::s_peer;
+
+void fiber_loop(){
+    for(uint64_t i = 0; i < s_rounds; i++){
+        GGo::Fiber::getThis()->back();
+    }
+}
+
+/// @brief 通过Fiber::call/back切换，统计当前编译所选实现的每秒切换次数
+double bench_fiber(uint64_t rounds){
+    s_rounds = rounds;
+    GGo::Fiber::getThis();
+    // 使用call/back语义的协程，结束时回到线程主协程
+    GGo::Fiber::ptr fiber(new GGo::Fiber(&fiber_loop, 0, true));
+    auto begin = std::chrono::steady_clock::now();
+    for(uint64_t i = 0; i <= rounds; i++){
+        fiber->call();
+    }
+    std::chrono::duration<double> used = std::chrono::steady_clock::now() - begin;
+    return rounds * 2 / used.count();
+}
+
+void report(const std::string& name, double switches){
+    cout << std::setw(24) << std::left << name
+         << std::setw(16) << std::right << (uint64_t)switches << " switches/s"
+         << std::setw(10) << std::fixed << std::setprecision(1) << 1e9 / switches << " ns/switch" << endl;
+}
+
+int main(int argc, char** argv){
+    uint64_t rounds = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    cout << "fiber context switch, " << rounds << " round trips" << endl;
+    report("ucontext", PingPong<GGo::UContext>::run(rounds));
+#ifdef GGO_ASM_CONTEXT_SUPPORTED
+    report("asm", PingPong<GGo::AsmContext>::run(rounds));
+#else
+    cout << "asm context not supported on this platform" << endl;
+#endif
+    report(std::string("Fiber(") + GGo::FiberContextName() + ")", bench_fiber(rounds));
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include<iostream>
+#include<signal.h>
+#include<sys/wait.h>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+static const size_t STACK_SIZE = 64 * 1024;
+static size_t s_page = sysconf(_SC_PAGESIZE);
+
+static void empty_fiber(){
+}
+
+/// @brief 结束的协程把栈还给线程缓存池，同样大小的新协程直接复用
+void test_stack_pool(){
+    GGo::Fiber::getThis();
+    uint64_t hits = GGo::Fiber::StackPoolHits();
+    uint64_t misses = GGo::Fiber::StackPoolMisses();
+
+    GGo::Fiber::ptr fiber(new GGo::Fiber(&empty_fiber, STACK_SIZE, true));
+    GGO_ASSERT(GGo::Fiber::StackPoolMisses() == misses + 1);
+    fiber->call();
+    fiber.reset();
+
+    // 不同大小的栈分开缓存
+    fiber.reset(new GGo::Fiber(&empty_fiber, STACK_SIZE * 2, true));
+    GGO_ASSERT(GGo::Fiber::StackPoolMisses() == misses + 2);
+    GGO_ASSERT(GGo::Fiber::StackPoolHits() == hits);
+    fiber->call();
+    fiber.reset();
+
+    for(int i = 0; i < 10; i++){
+        fiber.reset(new GGo::Fiber(&empty_fiber, STACK_SIZE, true));
+        fiber->call();
+        fiber.reset();
+    }
+    cout << "stack pool hits=" << GGo::Fiber::StackPoolHits() - hits
+         << " misses=" << GGo::Fiber::StackPoolMisses() - misses << endl;
+    GGO_ASSERT(GGo::Fiber::StackPoolHits() == hits + 10);
+    GGO_ASSERT(GGo::Fiber::StackPoolMisses() == misses + 2);
+}
+
+/// @brief 按栈顶所在页推出栈的最低地址，先写栈底再写下面的保护页
+static void touch_guard_page(){
+    volatile char local = 0;
+    uintptr_t top = ((uintptr_t)&local + s_page - 1) / s_page * s_page;
+    volatile char* bottom = (volatile char*)(top - STACK_SIZE);
+    // 栈底可以正常读写
+    bottom[0] = local;
+    // 保护页不可访问
+    bottom[-1] = local;
+}
+
+/// @brief 越过栈底访问保护页必须触发SIGSEGV，而不是写坏相邻的内存
+void test_guard_page(){
+    pid_t pid = fork();
+    if(pid == 0){
+        GGo::Fiber::getThis();
+        GGo::Fiber::ptr fiber(new GGo::Fiber(&touch_guard_page, STACK_SIZE, true));
+        fiber->call();
+        // 没有触发SIGSEGV
+        _exit(0);
+    }
+    int status = 0;
+    GGO_ASSERT(waitpid(pid, &status, 0) == pid);
+    cout << "guard page child " << (WIFSIGNALED(status) ? "killed by signal " : "exited with ")
+         << (WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status)) << endl;
+    GGO_ASSERT(WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV);
+}
+
+int main(){
+    test_stack_pool();
+    test_guard_page();
+    cout << "FiberTest02 passed" << endl;
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include<iostream>
+#include<iomanip>
+#include<chrono>
+#include<sys/socket.h>
+#include<netinet/in.h>
+#include<netinet/tcp.h>
+#include<arpa/inet.h>
+#include<unistd.h>
+#include<strings.h>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+/// @brief 压测examples/HTTPSever.cpp，类似wrk的流水线模式：
+///        每个连接一次发送depth个请求，收齐depth个响应后再发下一批
+/// 用法：HTTPPipelineBench [ip:port] [connections] [depth] [seconds] [path]
+
+/// @brief 从缓存中取出完整的响应，返回取出的个数
+static int consume(std::string& buf, size_t& pos){
+    int count = 0;
+    while(true){
+        size_t end = buf.find("\r\n\r\n", pos);
+        if(end == std::string::npos){
+            break;
+        }
+        size_t length = 0;
+        for(size_t i = buf.find("\r\n", pos); i < end; i = buf.find("\r\n", i + 2)){
+            if(strncasecmp(buf.c_str() + i + 2, "content-length:", 15) == 0){
+                length = strtoull(buf.c_str() + i + 17, nullptr, 10);
+                break;
+            }
+        }
+        if(buf.size() < end + 4 + length){
+            break;
+        }
+        pos = end + 4 + length;
+        count++;
+    }
+    if(pos == buf.size()){
+        buf.clear();
+        pos = 0;
+    }
+    return count;
+}
+
+/// @brief 单个连接的压测，返回完成的请求数
+static uint64_t run_connection(sockaddr_in addr, const std::string& batch, int depth,
+                               std::chrono::steady_clock::time_point deadline, bool& error){
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if(connect(fd, (sockaddr*)&addr, sizeof(addr))){
+        error = true;
+        close(fd);
+        return 0;
+    }
+    uint64_t done = 0;
+    std::string buf;
+    size_t pos = 0;
+    char data[64 * 1024];
+    while(std::chrono::steady_clock::now() < deadline){
+        if(send(fd, batch.c_str(), batch.size(), MSG_NOSIGNAL) != (ssize_t)batch.size()){
+            error = true;
+            break;
+        }
+        int left = depth;
+        while(left > 0){
+            ssize_t rt = recv(fd, data, sizeof(data), 0);
+            if(rt <= 0){
+                error = true;
+                break;
+            }
+            buf.append(data, rt);
+            left -= consume(buf, pos);
+        }
+        if(error){
+            break;
+        }
+        done += depth;
+    }
+    close(fd);
+    return done;
+}
+
+/// @brief connections个连接同时压测seconds秒，返回每秒请求数
+static double bench(sockaddr_in addr, const std::string& path, int connections, int depth, int seconds){
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: bench\r\nConnection: keep-alive\r\n\r\n";
+    std::string batch;
+    for(int i = 0; i < depth; i++){
+        batch += request;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    auto deadline = begin + std::chrono::seconds(seconds);
+    std::atomic<uint64_t> total{0};
+    std::atomic<bool> failed{false};
+    std::vector<GGo::Thread::ptr> threads;
+    for(int i = 0; i < connections; i++){
+        threads.emplace_back(new GGo::Thread([&](){
+            bool error = false;
+            total += run_connection(addr, batch, depth, deadline, error);
+            if(error){
+                failed = true;
+            }
+        }, "bench_" + std::to_string(i)));
+    }
+    for(auto& t : threads){
+        t->join();
+    }
+    std::chrono::duration<double> used = std::chrono::steady_clock::now() - begin;
+    if(failed){
+        cout << "depth " << depth << ": connection error" << endl;
+    }
+    return total / used.count();
+}
+
+int main(int argc, char** argv){
+    std::string host = argc > 1 ? argv[1] : "127.0.0.1:1145";
+    int connections = argc > 2 ? atoi(argv[2]) : 4;
+    int depth = argc > 3 ? atoi(argv[3]) : 16;
+    int seconds = argc > 4 ? atoi(argv[4]) : 3;
+    std::string path = argc > 5 ? argv[5] : "/";
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    size_t colon = host.rfind(':');
+    addr.sin_port = htons(atoi(host.c_str() + colon + 1));
+    if(colon == std::string::npos
+            || inet_pton(AF_INET, host.substr(0, colon).c_str(), &addr.sin_addr) != 1){
+        std::cerr << "invalid address: " << host << endl;
+        return 1;
+    }
+
+    cout << "http pipeline bench " << host << path << ", " << connections
+         << " connections, " << seconds << "s per run" << endl;
+    cout << std::setw(10) << "depth" << std::setw(16) << "requests/s" << endl;
+    double base = 0;
+    for(int d : {1, depth}){
+        double qps = bench(addr, path, connections, d, seconds);
+        if(d == 1){
+            base = qps;
+        }
+        cout << std::setw(10) << d << std::setw(16) << std::fixed << std::setprecision(0) << qps;
+        if(d != 1 && base > 0){
+            cout << std::setw(10) << std::setprecision(2) << qps / base << "x";
+        }
+        cout << endl;
+        if(depth == 1){
+            break;
+        }
+    }
+    return 0;
+}
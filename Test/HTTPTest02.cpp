@@ -0,0 +1,154 @@
+#include<iostream>
+#include<chrono>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+/// @brief 统计堆分配次数
+static thread_local uint64_t t_allocs = 0;
+void* operator new(size_t size){
+    t_allocs++;
+    if(void* ptr = malloc(size)){
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept{
+    free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept{
+    free(ptr);
+}
+
+static const char test_request_data[] = "POST /api/user/info?id=42&name=ggo#top HTTP/1.1\r\n"
+                                        "Host: www.inkgocloud.cn\r\n"
+                                        "User-Agent: curl/7.29.0\r\n"
+                                        "Accept: */*\r\n"
+                                        "Accept-Encoding: gzip, deflate\r\n"
+                                        "Accept-Language: zh-CN,zh;q=0.9\r\n"
+                                        "Cache-Control: no-cache\r\n"
+                                        "Cookie: session=abcdef; theme=dark\r\n"
+                                        "Connection: keep-alive\r\n"
+                                        "Content-Type: application/x-www-form-urlencoded\r\n"
+                                        "Content-Length: 10\r\n\r\n"
+                                        "1234567890";
+
+/// @brief view模式的字段指向输入缓存，转换出的HTTPRequest与原来的解析结果相同
+void test_view(){
+    std::string data = test_request_data;
+    GGo::HTTP::HTTPRequestParser parser(true);
+    size_t nparse = parser.excute(&data[0], data.size());
+    GGO_ASSERT(parser.isFinished() && !parser.hasError());
+    GGo::HTTP::HTTPRequestView::ptr view = parser.getView();
+    GGO_ASSERT(!parser.getData());
+    GGO_ASSERT(view->getMethod() == GGo::HTTP::HTTPMethod::POST);
+    GGO_ASSERT(view->getVersion() == 0x11);
+    GGO_ASSERT(view->getPath() == "/api/user/info");
+    GGO_ASSERT(view->getQuery() == "id=42&name=ggo");
+    GGO_ASSERT(view->getFragment() == "top");
+    GGO_ASSERT(view->getPath().data() >= data.data() && view->getPath().data() < data.data() + data.size());
+    GGO_ASSERT(view->getHeaders().size() == 10);
+    GGO_ASSERT(view->getHeader("HOST") == "www.inkgocloud.cn");
+    GGO_ASSERT(view->getHeader("accept") == "*/*");
+    GGO_ASSERT(view->getHeader("not-exist", "def") == "def");
+    GGO_ASSERT(!view->hasHeader("accept-"));
+    GGO_ASSERT(view->getContentLength() == 10);
+    GGO_ASSERT(!view->isAutoClose());
+    // 输入没有被移动
+    GGO_ASSERT(data == test_request_data);
+    view->setBody(std::string_view(data.data() + nparse, 10));
+
+    std::string owned = test_request_data;
+    GGo::HTTP::HTTPRequestParser old_parser;
+    old_parser.excute(&owned[0], owned.size());
+    GGo::HTTP::HTTPRequest::ptr expect = old_parser.getData();
+    expect->setBody("1234567890");
+    expect->init();
+    GGo::HTTP::HTTPRequest::ptr request = view->toRequest();
+    GGO_ASSERT(request->toString() == expect->toString());
+    GGO_ASSERT(request->getParam("name") == "ggo");
+    GGO_ASSERT(request->getCookies("theme") == "dark");
+}
+
+/// @brief 分多次到达的请求，字段被截断时在下一次完整解析
+void test_partial(){
+    std::string data = test_request_data;
+    GGo::HTTP::HTTPRequestParser parser(true);
+    size_t nparse = 0;
+    for(size_t len = 7; ; len += 7){
+        len = std::min(len, data.size());
+        nparse = parser.excute(&data[0], len);
+        GGO_ASSERT(!parser.hasError());
+        if(parser.isFinished() || len == data.size()){
+            break;
+        }
+    }
+    GGO_ASSERT(parser.isFinished());
+    GGO_ASSERT(nparse == data.size() - 10);
+    GGo::HTTP::HTTPRequestView::ptr view = parser.getView();
+    GGO_ASSERT(view->getPath() == "/api/user/info");
+    GGO_ASSERT(view->getHeader("cookie") == "session=abcdef; theme=dark");
+    GGO_ASSERT(view->getHeader("content-type") == "application/x-www-form-urlencoded");
+}
+
+/// @brief 头部单独序列化，与消息体拼起来和完整输出相同
+void test_serialize(){
+    GGo::HTTP::HTTPResponse::ptr rsp(new GGo::HTTP::HTTPResponse(0x11, false));
+    rsp->setHeader("Content-Type", "text/plain");
+    rsp->setCookie("id", "42");
+    std::string body(100000, 'b');
+    const char* data = body.data();
+    rsp->setBody(std::move(body));
+    // 接管内存，没有拷贝
+    GGO_ASSERT(rsp->getBody().data() == data);
+
+    std::string header;
+    rsp->serializeHeader(header);
+    GGO_ASSERT(header == "HTTP/1.1 200 OK\r\n"
+                         "Content-Type: text/plain\r\n"
+                         "Set-Cookie: id=42\r\n"
+                         "connection: keep-alive\r\n"
+                         "content-length: 100000\r\n\r\n");
+    GGO_ASSERT(header + rsp->getBody() == rsp->toString());
+
+    // 缓存复用时追加在后面
+    GGo::HTTP::HTTPResponse::ptr empty(new GGo::HTTP::HTTPResponse(0x10));
+    empty->setStatus(GGo::HTTP::HTTPStatus::NOT_FOUND);
+    size_t size = header.size();
+    empty->serializeHeader(header);
+    GGO_ASSERT(header.substr(size) == "HTTP/1.0 404 Not Found\r\nconnection: close\r\ncontent-length: 0\r\n\r\n");
+}
+
+/// @brief 比较两种解析方式的分配次数与耗时
+void bench(int count){
+    std::string input = test_request_data;
+    std::string data;
+    data.reserve(input.size());
+    for(bool view : {false, true}){
+        uint64_t allocs = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for(int i = 0; i < count; i++){
+            data.assign(input);
+            uint64_t before = t_allocs;
+            GGo::HTTP::HTTPRequestParser parser(view);
+            parser.excute(&data[0], data.size());
+            GGO_ASSERT(parser.isFinished());
+            allocs += t_allocs - before;
+        }
+        std::chrono::duration<double, std::nano> used = std::chrono::steady_clock::now() - begin;
+        cout << (view ? "view " : "owning ") << "parse: " << (double)allocs / count
+             << " allocs, " << used.count() / count << " ns per request" << endl;
+        if(view){
+            GGO_ASSERT(allocs / count <= 3);
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    test_view();
+    test_partial();
+    test_serialize();
+    bench(argc > 1 ? atoi(argv[1]) : 100000);
+    cout << "HTTPTest02 passed" << endl;
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include<iostream>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+/// @brief 统计read调用次数的会话
+class CountingSession : public GGo::HTTP::HTTPSession{
+public:
+    CountingSession(GGo::Socket::ptr sock)
+        :HTTPSession(sock){}
+    int read(void* buffer, size_t len) override{
+        m_reads++;
+        return HTTPSession::read(buffer, len);
+    }
+    int m_reads = 0;
+};
+
+static std::string make_request(const std::string& path, const std::string& body = ""){
+    std::string req = "POST " + path + " HTTP/1.1\r\nHost: ggo\r\nConnection: keep-alive\r\n";
+    if(!body.empty()){
+        req += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    return req + "\r\n" + body;
+}
+
+static bool s_done = false;
+
+static void server(GGo::Socket::ptr listener){
+    GGo::Socket::ptr client = listener->accept();
+    GGO_ASSERT(client);
+    std::shared_ptr<CountingSession> session(new CountingSession(client));
+
+    // 一次读入的三个请求依次解析，不再读取
+    std::vector<GGo::HTTP::HTTPRequestView::ptr> views;
+    for(int i = 0; i < 3; i++){
+        views.push_back(session->recvRequestView());
+        GGO_ASSERT(views.back());
+    }
+    GGO_ASSERT(session->m_reads == 1);
+    GGO_ASSERT(views[0]->getPath() == "/a" && views[0]->getBody().empty());
+    GGO_ASSERT(views[1]->getPath() == "/b" && views[1]->getBody() == "hello");
+    GGO_ASSERT(views[2]->getPath() == "/c" && views[2]->getBody() == "world!");
+
+    // 请求头被分成两次发送
+    GGo::HTTP::HTTPRequestView::ptr split = session->recvRequestView();
+    GGO_ASSERT(split && split->getPath() == "/split" && split->getHeader("host") == "ggo");
+
+    // 消息体超过缓存大小
+    GGo::HTTP::HTTPRequestView::ptr big = session->recvRequestView();
+    GGO_ASSERT(big && big->getPath() == "/big");
+    GGO_ASSERT(big->getBody() == std::string(10000, 'x'));
+
+    // 缓存被之前的请求引用时换新的缓存，之前的请求保持不变
+    GGO_ASSERT(views[1]->getBody() == "hello" && views[2]->getPath() == "/c");
+
+    // 转换为HTTPRequest之后缓存可以直接复用
+    views.clear();
+    split.reset();
+    big.reset();
+    for(int i = 0; i < 2; i++){
+        GGo::HTTP::HTTPRequest::ptr req = session->recvRequest();
+        GGO_ASSERT(req && req->getPath() == "/last" + std::to_string(i));
+        GGO_ASSERT(!req->isAutoClose());
+    }
+
+    // 只取缓存中完整的请求，消息体不完整时不读取也不移动读指针
+    GGo::HTTP::HTTPRequest::ptr req = session->recvRequest();
+    GGO_ASSERT(req && req->getPath() == "/p0");
+    GGO_ASSERT(!session->recvBufferedRequest());
+    std::vector<GGo::HTTP::HTTPResponse::ptr> responses;
+    responses.push_back(req->createResponse());
+    responses.back()->setBody("first");
+    req = session->recvRequest();
+    GGO_ASSERT(req && req->getPath() == "/p1" && req->getBody() == "body");
+    responses.push_back(req->createResponse());
+    responses.push_back(req->createResponse());
+    responses.back()->setBody("third");
+    GGO_ASSERT(session->sendResponses(responses) > 0);
+    GGO_ASSERT(!session->recvRequestView());
+    s_done = true;
+}
+
+static void client(GGo::Address::ptr addr){
+    GGo::Socket::ptr sock = GGo::Socket::CreateTCP(addr);
+    GGO_ASSERT(sock->connect(addr));
+    std::string data = make_request("/a") + make_request("/b", "hello") + make_request("/c", "world!");
+    GGO_ASSERT(sock->send(data.c_str(), data.size()) == (int)data.size());
+    usleep(50 * 1000);
+
+    data = make_request("/split");
+    sock->send(data.c_str(), 20);
+    usleep(50 * 1000);
+    sock->send(data.c_str() + 20, data.size() - 20);
+    usleep(50 * 1000);
+
+    data = make_request("/big", std::string(10000, 'x'));
+    GGO_ASSERT(sock->send(data.c_str(), data.size()) == (int)data.size());
+    usleep(50 * 1000);
+
+    data = make_request("/last0") + make_request("/last1");
+    GGO_ASSERT(sock->send(data.c_str(), data.size()) == (int)data.size());
+    usleep(50 * 1000);
+
+    data = make_request("/p0") + make_request("/p1", "body");
+    sock->send(data.c_str(), data.size() - 2);
+    usleep(50 * 1000);
+    sock->send(data.c_str() + data.size() - 2, 2);
+
+    // 三个响应一起到达，空消息体的响应也带长度
+    std::string expect;
+    for(auto& body : {"first", "", "third"}){
+        expect += "HTTP/1.1 200 OK\r\nconnection: keep-alive\r\ncontent-length: "
+                + std::to_string(strlen(body)) + "\r\n\r\n" + body;
+    }
+    std::string buffer(expect.size(), '\0');
+    size_t len = 0;
+    while(len < expect.size()){
+        int rt = sock->recv(&buffer[len], buffer.size() - len);
+        GGO_ASSERT(rt > 0);
+        len += rt;
+    }
+    GGO_ASSERT(buffer == expect);
+    sock->close();
+}
+
+int main(){
+    {
+        GGo::IOScheduler iom(2, false, "http_test03");
+        GGo::Address::ptr addr = GGo::Address::LookupAnyIPAddress("127.0.0.1:0");
+        GGo::Socket::ptr listener = GGo::Socket::CreateTCP(addr);
+        GGO_ASSERT(listener->bind(addr) && listener->listen());
+        GGo::Address::ptr local = listener->getLocalAddress();
+        iom.schedule(std::bind(&server, listener));
+        iom.schedule(std::bind(&client, local));
+    }
+    GGO_ASSERT(s_done);
+    cout << "HTTPTest03 passed" << endl;
+    return 0;
+}
@@ -0,0 +1,223 @@
+#include<iostream>
+#include<fstream>
+#include<strings.h>
+#include<fcntl.h>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+static std::string s_root;
+static std::string s_content;
+static bool s_done = false;
+// 大于INT_MAX的稀疏文件，末尾写入标记
+static const uint64_t s_largeSize = (1ull << 31) + 100;
+static const char s_largeTail[] = "ggo-end";
+
+/// @brief 收到的响应
+struct Response{
+    int status = 0;
+    std::map<std::string, std::string, GGo::HTTP::StringComparator> headers;
+    std::string body;
+};
+
+static std::string s_buffer;
+
+/// @brief 发送一个请求并读取响应头部
+static Response requestHeader(GGo::Socket::ptr sock, const std::string& method, const std::string& path
+                        , const std::string& headers){
+    std::string req = method + " " + path + " HTTP/1.1\r\nHost: ggo\r\nConnection: keep-alive\r\n" + headers + "\r\n";
+    GGO_ASSERT(sock->send(req.c_str(), req.size()) == (int)req.size());
+
+    size_t end;
+    char data[16 * 1024];
+    while((end = s_buffer.find("\r\n\r\n")) == std::string::npos){
+        int rt = sock->recv(data, sizeof(data));
+        GGO_ASSERT(rt > 0);
+        s_buffer.append(data, rt);
+    }
+    Response rsp;
+    rsp.status = atoi(s_buffer.c_str() + 9);
+    for(size_t pos = s_buffer.find("\r\n") + 2; pos < end; ){
+        size_t line_end = s_buffer.find("\r\n", pos);
+        size_t colon = s_buffer.find(':', pos);
+        rsp.headers[s_buffer.substr(pos, colon - pos)] = GGo::StringUtil::trim(s_buffer.substr(colon + 1, line_end - colon - 1));
+        pos = line_end + 2;
+    }
+    s_buffer.erase(0, end + 4);
+    return rsp;
+}
+
+/// @brief 发送一个请求并读取响应，HEAD与304响应没有消息体
+static Response request(GGo::Socket::ptr sock, const std::string& method, const std::string& path
+                        , const std::string& headers = "", bool has_body = true){
+    Response rsp = requestHeader(sock, method, path, headers);
+    size_t length = has_body ? std::stoull(rsp.headers["content-length"]) : 0;
+    char data[16 * 1024];
+    while(s_buffer.size() < length){
+        int rt = sock->recv(data, sizeof(data));
+        GGO_ASSERT(rt > 0);
+        s_buffer.append(data, rt);
+    }
+    rsp.body = s_buffer.substr(0, length);
+    s_buffer.erase(0, length);
+    return rsp;
+}
+
+static void server(GGo::Socket::ptr listener){
+    GGo::HTTP::ServletDispatch::ptr dispatch(new GGo::HTTP::ServletDispatch);
+    dispatch->addGlobServlet("/static/*", std::make_shared<GGo::HTTP::StaticFileServlet>(s_root, "/static", 0));
+    GGo::Socket::ptr client = listener->accept();
+    GGO_ASSERT(client);
+    GGo::HTTP::HTTPSession::ptr session(new GGo::HTTP::HTTPSession(client));
+    while(GGo::HTTP::HTTPRequest::ptr req = session->recvRequest()){
+        GGo::HTTP::HTTPResponse::ptr rsp = req->createResponse();
+        dispatch->handle(req, rsp, session);
+        // 文件内容不经过消息体，由sendfile发送
+        if(rsp->getStatus() == GGo::HTTP::HTTPStatus::OK && req->getMethod() == GGo::HTTP::HTTPMethod::GET){
+            GGO_ASSERT(rsp->getFileBody() && rsp->getBody().empty());
+        }
+        int64_t rt = session->sendResponse(rsp);
+        GGO_ASSERT(rt > 0);
+        // 超过2G的文件返回完整的发送长度
+        if(rsp->getFileBody() && rsp->getFileBody()->length == s_largeSize){
+            GGO_ASSERT(rt > (int64_t)s_largeSize);
+        }
+    }
+}
+
+static void client(GGo::Address::ptr addr){
+    GGo::Socket::ptr sock = GGo::Socket::CreateTCP(addr);
+    GGO_ASSERT(sock->connect(addr));
+
+    // 完整文件
+    Response rsp = request(sock, "GET", "/static/data.bin");
+    GGO_ASSERT(rsp.status == 200 && rsp.body == s_content);
+    GGO_ASSERT(rsp.headers["content-type"] == "application/octet-stream");
+    GGO_ASSERT(rsp.headers["accept-ranges"] == "bytes");
+    std::string etag = rsp.headers["etag"];
+    std::string last_modified = rsp.headers["last-modified"];
+    GGO_ASSERT(!etag.empty() && !last_modified.empty());
+
+    // 目录默认返回index.html
+    rsp = request(sock, "GET", "/static/");
+    GGO_ASSERT(rsp.status == 200 && rsp.body == "<html>ggo</html>");
+    GGO_ASSERT(rsp.headers["content-type"] == "text/html; charset=utf-8");
+
+    // 区间请求
+    rsp = request(sock, "GET", "/static/data.bin", "Range: bytes=100-199\r\n");
+    GGO_ASSERT(rsp.status == 206 && rsp.body == s_content.substr(100, 100));
+    GGO_ASSERT(rsp.headers["content-range"] == "bytes 100-199/" + std::to_string(s_content.size()));
+    rsp = request(sock, "GET", "/static/data.bin", "Range: bytes=-10\r\n");
+    GGO_ASSERT(rsp.status == 206 && rsp.body == s_content.substr(s_content.size() - 10));
+    rsp = request(sock, "GET", "/static/data.bin", "Range: bytes=1000000-\r\n");
+    GGO_ASSERT(rsp.status == 206 && rsp.body == s_content.substr(1000000));
+    rsp = request(sock, "GET", "/static/data.bin", "Range: bytes=99999999-\r\n");
+    GGO_ASSERT(rsp.status == 416 && rsp.body.empty());
+    GGO_ASSERT(rsp.headers["content-range"] == "bytes */" + std::to_string(s_content.size()));
+    // 多个区间按完整文件返回
+    rsp = request(sock, "GET", "/static/data.bin", "Range: bytes=0-1,5-6\r\n");
+    GGO_ASSERT(rsp.status == 200 && rsp.body == s_content);
+    // If-Range不匹配时返回完整文件
+    rsp = request(sock, "GET", "/static/data.bin", "Range: bytes=0-9\r\nIf-Range: \"old\"\r\n");
+    GGO_ASSERT(rsp.status == 200 && rsp.body == s_content);
+    rsp = request(sock, "GET", "/static/data.bin", "Range: bytes=0-9\r\nIf-Range: " + etag + "\r\n");
+    GGO_ASSERT(rsp.status == 206 && rsp.body == s_content.substr(0, 10));
+
+    // 条件请求
+    rsp = request(sock, "GET", "/static/data.bin", "If-None-Match: \"x\", " + etag + "\r\n", false);
+    GGO_ASSERT(rsp.status == 304 && rsp.headers["etag"] == etag);
+    rsp = request(sock, "GET", "/static/data.bin", "If-Modified-Since: " + last_modified + "\r\n", false);
+    GGO_ASSERT(rsp.status == 304);
+    rsp = request(sock, "GET", "/static/data.bin", "If-Modified-Since: Thu, 01 Jan 1970 00:00:00 GMT\r\n");
+    GGO_ASSERT(rsp.status == 200 && rsp.body == s_content);
+    // If-None-Match优先于If-Modified-Since
+    rsp = request(sock, "GET", "/static/data.bin", "If-None-Match: \"x\"\r\nIf-Modified-Since: " + last_modified + "\r\n");
+    GGO_ASSERT(rsp.status == 200 && rsp.body == s_content);
+
+    // HEAD只返回长度
+    rsp = request(sock, "HEAD", "/static/data.bin", "", false);
+    GGO_ASSERT(rsp.status == 200 && rsp.headers["content-length"] == std::to_string(s_content.size()));
+
+    // 不存在的文件、跳出根目录与不支持的方法
+    rsp = request(sock, "GET", "/static/none.txt");
+    GGO_ASSERT(rsp.status == 404);
+    rsp = request(sock, "GET", "/static/../HTTPTest04.cpp");
+    GGO_ASSERT(rsp.status == 404);
+    rsp = request(sock, "GET", "/static/%2e%2e/data.bin");
+    GGO_ASSERT(rsp.status == 404);
+    rsp = request(sock, "POST", "/static/data.bin");
+    GGO_ASSERT(rsp.status == 405 && rsp.headers["allow"] == "GET, HEAD");
+
+    // 大于INT_MAX的文件发送完后连接依然保持
+    rsp = requestHeader(sock, "GET", "/static/large.bin", "");
+    GGO_ASSERT(rsp.status == 200 && rsp.headers["content-length"] == std::to_string(s_largeSize));
+    {
+        std::string tail;
+        uint64_t received = 0;
+        // 协程栈只有128K，缓存放在堆上
+        std::vector<char> data(256 * 1024);
+        while(received + s_buffer.size() < s_largeSize){
+            received += s_buffer.size();
+            s_buffer.clear();
+            int rt = sock->recv(&data[0], std::min((uint64_t)data.size(), s_largeSize - received));
+            GGO_ASSERT(rt > 0);
+            s_buffer.assign(&data[0], rt);
+        }
+        size_t left = s_largeSize - received;
+        tail = s_buffer.substr(left - (sizeof(s_largeTail) - 1), sizeof(s_largeTail) - 1);
+        GGO_ASSERT(tail == s_largeTail);
+        s_buffer.erase(0, left);
+    }
+    rsp = request(sock, "GET", "/static/large.bin", "Range: bytes=-7\r\n");
+    GGO_ASSERT(rsp.status == 206 && rsp.body == s_largeTail);
+
+    // 文件变化后重新打开
+    {
+        std::ofstream ofs(s_root + "/data.bin", std::ios::trunc);
+        ofs << "changed";
+    }
+    rsp = request(sock, "GET", "/static/data.bin");
+    GGO_ASSERT(rsp.status == 200 && rsp.body == "changed" && rsp.headers["etag"] != etag);
+
+    sock->close();
+    s_done = true;
+}
+
+int main(){
+    char dir[] = "/tmp/ggo_static_XXXXXX";
+    GGO_ASSERT(mkdtemp(dir));
+    s_root = dir;
+    s_content.resize(3 * 1024 * 1024);
+    for(size_t i = 0; i < s_content.size(); i++){
+        s_content[i] = 'a' + (i * 7 + i / 1000) % 26;
+    }
+    {
+        std::ofstream ofs(s_root + "/data.bin");
+        ofs << s_content;
+        std::ofstream index(s_root + "/index.html");
+        index << "<html>ggo</html>";
+    }
+    {
+        int fd = open((s_root + "/large.bin").c_str(), O_CREAT | O_WRONLY, 0644);
+        GGO_ASSERT(fd >= 0);
+        size_t len = sizeof(s_largeTail) - 1;
+        GGO_ASSERT(pwrite(fd, s_largeTail, len, s_largeSize - len) == (ssize_t)len);
+        close(fd);
+    }
+    {
+        GGo::IOScheduler iom(2, false, "http_test04");
+        GGo::Address::ptr addr = GGo::Address::LookupAnyIPAddress("127.0.0.1:0");
+        GGo::Socket::ptr listener = GGo::Socket::CreateTCP(addr);
+        GGO_ASSERT(listener->bind(addr) && listener->listen());
+        GGo::Address::ptr local = listener->getLocalAddress();
+        iom.schedule(std::bind(&server, listener));
+        iom.schedule(std::bind(&client, local));
+    }
+    GGO_ASSERT(s_done);
+    unlink((s_root + "/data.bin").c_str());
+    unlink((s_root + "/index.html").c_str());
+    unlink((s_root + "/large.bin").c_str());
+    rmdir(dir);
+    cout << "HTTPTest04 passed" << endl;
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "GGo.h"
+#include<set>
+#include<sys/socket.h>
+#include<netinet/in.h>
+#include<arpa/inet.h>
+#include<unistd.h>
+
+GGo::Logger::ptr g_logger = GGO_LOG_NAME("system");
+
+static const int CLIENT_COUNT = 32;
+static const int MESSAGE_COUNT = 100;
+
+static std::atomic<uint64_t> s_echoed{0};
+static std::atomic<uint64_t> s_wrong_thread{0};
+static std::atomic<uint64_t> s_timeouts{0};
+static GGo::Mutex s_mutex;
+static std::set<int> s_accept_threads;
+
+/// @brief 回显服务器，检查连接是否始终在接受它的线程上处理
+class EchoSever : public GGo::TCPSever{
+public:
+    using ptr = std::shared_ptr<EchoSever>;
+
+    EchoSever(GGo::IOScheduler* worker)
+        :TCPSever(worker, worker, worker){}
+
+protected:
+    void handleCilent(GGo::Socket::ptr cilent) override{
+        int thread = GGo::GetThreadID();
+        {
+            GGo::Mutex::Lock lock(s_mutex);
+            s_accept_threads.insert(thread);
+        }
+        char buf[256];
+        while(true){
+            int rt = cilent->recv(buf, sizeof(buf));
+            if(GGo::GetThreadID() != thread){
+                s_wrong_thread++;
+            }
+            if(rt <= 0){
+                if(rt < 0 && errno == ETIMEDOUT){
+                    s_timeouts++;
+                }
+                break;
+            }
+            cilent->send(buf, rt);
+            s_echoed++;
+        }
+        cilent->close();
+    }
+};
+
+/// @brief 阻塞的客户端，运行在调度器之外的线程上
+void run_client(uint16_t port, int id){
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr.s_addr);
+    GGO_ASSERT(connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0);
+
+    std::string msg = "hello from client " + std::to_string(id);
+    char buf[256];
+    for(int i = 0; i < MESSAGE_COUNT; i++){
+        GGO_ASSERT(write(fd, msg.c_str(), msg.size()) == (ssize_t)msg.size());
+        size_t got = 0;
+        while(got < msg.size()){
+            ssize_t rt = read(fd, buf + got, sizeof(buf) - got);
+            GGO_ASSERT(rt > 0);
+            got += rt;
+        }
+        GGO_ASSERT(std::string(buf, got) == msg);
+    }
+    close(fd);
+}
+
+/// @brief 连接后不发送数据，服务端的读超时需要生效
+void run_idle_client(uint16_t port){
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr.s_addr);
+    GGO_ASSERT(connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0);
+    char buf[16];
+    // 服务端超时后关闭连接，这里读到EOF
+    GGO_ASSERT(read(fd, buf, sizeof(buf)) == 0);
+    close(fd);
+}
+
+/// @brief 在指定后端上运行回显测试
+/// @param per_thread_timer 工作线程是否使用私有定时器存储（读超时定时器由连接所在线程持有）
+void test_echo(const std::string& backend, bool per_thread_timer){
+    s_echoed = 0;
+    s_wrong_thread = 0;
+    s_timeouts = 0;
+    s_accept_threads.clear();
+    GGo::Config::Lookup<bool>("io_scheduler.per_thread_epoll", false)->setValue(true);
+    GGo::Config::Lookup<std::string>("io_scheduler.backend", "epoll")->setValue(backend);
+    GGo::Config::Lookup<bool>("io_scheduler.per_thread_timer", false)->setValue(per_thread_timer);
+    GGo::IOScheduler ios(4, false, backend);
+    GGO_ASSERT(ios.isPerThreadPoller());
+    GGO_ASSERT(ios.isPerThreadTimer() == per_thread_timer);
+    GGO_LOG_INFO(g_logger) << backend << " backend=" << ios.getBackend()
+                           << " per_thread_timer=" << per_thread_timer;
+
+    EchoSever::ptr sever(new EchoSever(&ios));
+    sever->setRecvTimeout(200);
+    std::atomic<uint16_t> port{0};
+    // socket需要在开启hook的线程上创建，才会被设为非阻塞交给调度器管理
+    ios.schedule([&](){
+        auto addr = GGo::Address::LookupAny("127.0.0.1:0");
+        GGO_ASSERT(sever->bind(addr));
+        // 每个事件循环线程各有一个SO_REUSEPORT监听socket
+        GGO_ASSERT(sever->getSocks().size() == ios.getPollerThreads().size());
+        sever->start();
+        port = std::dynamic_pointer_cast<GGo::IPAddress>(
+                    sever->getSocks()[0]->getLocalAddress())->getPort();
+    });
+    while(port == 0){
+        usleep(1000);
+    }
+    uint16_t sever_port = port;
+
+    std::vector<GGo::Thread::ptr> clients;
+    for(int i = 0; i < CLIENT_COUNT; i++){
+        clients.emplace_back(new GGo::Thread(std::bind(run_client, sever_port, i),
+                                            "client_" + std::to_string(i)));
+    }
+    for(auto& t : clients){
+        t->join();
+    }
+    GGo::Thread idle_client(std::bind(run_idle_client, sever_port), "idle_client");
+    idle_client.join();
+
+    sever->stop();
+    GGO_LOG_INFO(g_logger) << backend << " echoed=" << s_echoed
+                           << " wrong_thread=" << s_wrong_thread
+                           << " timeouts=" << s_timeouts
+                           << " accept_threads=" << s_accept_threads.size();
+    GGO_ASSERT(s_echoed == (uint64_t)CLIENT_COUNT * MESSAGE_COUNT);
+    GGO_ASSERT(s_wrong_thread == 0);
+    GGO_ASSERT(s_timeouts == 1);
+}
+
+/// @brief 定时器由工作线程创建，在调度器之外的线程上取消与重置
+void test_cross_thread_timer(){
+    const int COUNT = 64;
+    GGo::Config::Lookup<bool>("io_scheduler.per_thread_timer", false)->setValue(true);
+    GGo::IOScheduler ios(4, false, "cross_timer");
+    GGO_ASSERT(ios.isPerThreadTimer());
+
+    std::atomic<int> fired{0};
+    std::atomic<int> wrong_thread{0};
+    std::vector<GGo::Timer::ptr> timers(COUNT);
+    std::atomic<int> created{0};
+    for(int i = 0; i < COUNT; i++){
+        ios.schedule([&, i](){
+            int thread = GGo::GetThreadID();
+            timers[i] = ios.addTimer(100, [&, thread](){
+                if(GGo::GetThreadID() != thread){
+                    wrong_thread++;
+                }
+                fired++;
+            });
+            created++;
+        });
+    }
+    while(created < COUNT){
+        usleep(1000);
+    }
+    // 偶数取消，奇数中的一半推迟，推迟的仍要在拥有者线程上触发
+    for(int i = 0; i < COUNT; i += 2){
+        GGO_ASSERT(timers[i]->cancel());
+        GGO_ASSERT(!timers[i]->cancel());
+    }
+    for(int i = 1; i < COUNT; i += 4){
+        GGO_ASSERT(timers[i]->reset(300, true));
+    }
+    usleep(200 * 1000);
+    GGO_ASSERT(fired == COUNT / 4);
+    usleep(250 * 1000);
+    GGO_LOG_INFO(g_logger) << "cross thread timer fired=" << fired
+                           << " wrong_thread=" << wrong_thread;
+    GGO_ASSERT(fired == COUNT / 2);
+    GGO_ASSERT(wrong_thread == 0);
+    GGO_ASSERT(!ios.hasTimer());
+    GGo::Config::Lookup<bool>("io_scheduler.per_thread_timer", false)->setValue(false);
+}
+
+/// @brief use_caller时调用线程在stop()之前注册的事件，要由工作线程的poller处理
+void test_caller_event(){
+    GGo::Config::Lookup<bool>("io_scheduler.per_thread_epoll", false)->setValue(true);
+    GGo::Config::Lookup<std::string>("io_scheduler.backend", "epoll")->setValue("epoll");
+    GGo::IOScheduler ios(3, true, "caller_event");
+    GGO_ASSERT(ios.isPerThreadPoller());
+
+    const int COUNT = 16;
+    int pipes[COUNT][2];
+    std::atomic<int> fired{0};
+    for(int i = 0; i < COUNT; i++){
+        GGO_ASSERT(pipe(pipes[i]) == 0);
+        // 不同的fd取模后覆盖所有poller
+        GGO_ASSERT(ios.addEvent(pipes[i][0], GGo::IOScheduler::Event::READ, [&fired](){
+            fired++;
+        }) == 0);
+    }
+    ios.schedule([&pipes](){
+        for(int i = 0; i < COUNT; i++){
+            GGO_ASSERT(write(pipes[i][1], "x", 1) == 1);
+        }
+    });
+    // 调用线程没有进入stop()，事件也要在1s内触发
+    for(int i = 0; i < 1000 && fired < COUNT; i++){
+        usleep(1000);
+    }
+    GGO_LOG_INFO(g_logger) << "caller event fired=" << fired;
+    GGO_ASSERT(fired == COUNT);
+    ios.stop();
+    for(int i = 0; i < COUNT; i++){
+        close(pipes[i][0]);
+        close(pipes[i][1]);
+    }
+}
+
+/// @brief 忙于执行任务的工作线程上创建的定时器，不能因为缓存时间过期而提前触发
+void test_busy_worker_timer(){
+    const uint64_t BUSY_MS = 300;
+    const uint64_t TIMEOUT_MS = 100;
+    GGo::IOScheduler ios(1, false, "busy_timer");
+    std::atomic<int> fired{0};
+    std::atomic<int> early{0};
+    auto add_timer = [&](){
+        uint64_t start = GGo::now();
+        ios.addTimer(TIMEOUT_MS, [&, start](){
+            uint64_t elapsed = GGo::now() - start;
+            GGO_LOG_INFO(g_logger) << "busy worker timer elapsed=" << elapsed;
+            if(elapsed < TIMEOUT_MS){
+                early++;
+            }
+            fired++;
+        });
+    };
+    std::atomic<int64_t> lag{-1};
+    // 任务执行中途创建的定时器
+    ios.schedule([&](){
+        uint64_t begin = GGo::now();
+        while(GGo::now() - begin < BUSY_MS){
+        }
+        add_timer();
+    });
+    // 排在长任务之后的任务读到的缓存时间已经刷新
+    ios.schedule([&](){
+        lag = GGo::now() - GGo::now(GGo::COARSE);
+        add_timer();
+    });
+    for(int i = 0; i < 2000 && fired < 2; i++){
+        usleep(1000);
+    }
+    GGO_LOG_INFO(g_logger) << "busy worker timer fired=" << fired << " early=" << early
+                           << " coarse lag=" << lag;
+    GGO_ASSERT(fired == 2 && early == 0);
+    GGO_ASSERT(lag >= 0 && lag < (int64_t)TIMEOUT_MS);
+}
+
+int main(){
+    test_echo("epoll", false);
+    test_echo("epoll", true);
+    test_echo("io_uring", true);
+    test_cross_thread_timer();
+    test_caller_event();
+    test_busy_worker_timer();
+    return 0;
+}
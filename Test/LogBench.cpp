@@ -0,0 +1,83 @@
+#include<iostream>
+#include<iomanip>
+#include<chrono>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+/// @brief 只格式化不输出的appender，用来单独测量日志事件与格式化的开销
+class NullLogAppender : public GGo::LogAppender{
+public:
+    /// @param legacy 是否使用流式格式化
+    NullLogAppender(bool legacy)
+        :m_legacy(legacy){}
+
+    void log(GGo::Logger::ptr logger, GGo::LogLevel level, GGo::LogEvent::ptr event) override{
+        if(m_legacy){
+            std::stringstream ss;
+            m_formatter->format(ss, logger, level, event);
+            m_bytes += ss.str().size();
+        }else{
+            char buf[4096];
+            m_bytes += m_formatter->format(buf, sizeof(buf), logger, level, *event);
+        }
+    }
+
+    std::string toYamlString() override { return ""; }
+
+    uint64_t m_bytes = 0;
+private:
+    bool m_legacy;
+};
+
+/// @brief 原来的路径：每条日志分配事件与字符串流，格式器逐项写入另一个流
+static double legacy(GGo::Logger::ptr logger, uint64_t lines){
+    auto begin = std::chrono::steady_clock::now();
+    for(uint64_t i = 0; i < lines; i++){
+        GGo::LogEventWrap(GGo::LogEvent::ptr(new GGo::LogEvent(logger, GGo::LogLevel::INFO,
+                __FILE__, __LINE__, 0, GGo::GetThreadID(), GGo::GetFiberID(),
+                time(0), GGo::Thread::GetThisName())))
+            .getSS() << "request " << i << " from " << "127.0.0.1" << " cost " << 3.5 << "ms";
+    }
+    std::chrono::duration<double, std::nano> used = std::chrono::steady_clock::now() - begin;
+    return used.count() / lines;
+}
+
+/// @brief 新的路径：复用线程缓存的事件，按片段直接格式化到定长缓冲区
+static double fast(GGo::Logger::ptr logger, uint64_t lines){
+    auto begin = std::chrono::steady_clock::now();
+    for(uint64_t i = 0; i < lines; i++){
+        GGO_LOG_INFO(logger) << "request " << i << " from " << "127.0.0.1" << " cost " << 3.5 << "ms";
+    }
+    std::chrono::duration<double, std::nano> used = std::chrono::steady_clock::now() - begin;
+    return used.count() / lines;
+}
+
+int main(int argc, char** argv){
+    uint64_t lines = argc > 1 ? std::stoull(argv[1]) : 1000000;
+
+    GGo::Logger::ptr legacy_logger(new GGo::Logger("bench_legacy"));
+    std::shared_ptr<NullLogAppender> legacy_appender(new NullLogAppender(true));
+    legacy_logger->addAppender(legacy_appender);
+    GGo::Logger::ptr fast_logger(new GGo::Logger("bench_fast"));
+    std::shared_ptr<NullLogAppender> fast_appender(new NullLogAppender(false));
+    fast_logger->addAppender(fast_appender);
+
+    // 预热
+    legacy(legacy_logger, 1000);
+    fast(fast_logger, 1000);
+
+    double legacy_ns = legacy(legacy_logger, lines);
+    double fast_ns = fast(fast_logger, lines);
+    cout << "log line (event + format, no output), " << lines << " lines" << endl;
+    cout << std::setw(16) << "legacy ns/line"
+         << std::setw(16) << "fast ns/line"
+         << std::setw(12) << "speedup" << endl;
+    cout << std::setw(16) << std::fixed << std::setprecision(1) << legacy_ns
+         << std::setw(16) << fast_ns
+         << std::setw(12) << std::setprecision(2) << legacy_ns / fast_ns << endl;
+    // 两条路径只有日志器名称不同
+    GGO_ASSERT(legacy_appender->m_bytes - fast_appender->m_bytes
+               == (lines + 1000) * (strlen("bench_legacy") - strlen("bench_fast")));
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include<iostream>
+#include<fstream>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+static const int THREAD_COUNT = 8;
+static const int LINE_COUNT = 20000;
+
+/// @brief 统计文件行数
+static size_t count_lines(const std::string& filename){
+    std::ifstream ifs(filename);
+    std::string line;
+    size_t count = 0;
+    while(std::getline(ifs, line)){
+        count++;
+    }
+    return count;
+}
+
+/// @brief 多个线程写同一个异步appender
+static void write_lines(GGo::Logger::ptr logger){
+    std::vector<GGo::Thread::ptr> threads;
+    for(int i = 0; i < THREAD_COUNT; i++){
+        threads.emplace_back(new GGo::Thread([logger, i](){
+            for(int j = 0; j < LINE_COUNT; j++){
+                GGO_LOG_INFO(logger) << "thread " << i << " line " << j;
+            }
+        }, "writer_" + std::to_string(i)));
+    }
+    for(auto& t : threads){
+        t->join();
+    }
+}
+
+/// @brief BLOCK策略下缓冲区很小也不能丢日志
+void test_block(){
+    std::string filename = "/tmp/ggo_async_block.log";
+    GGo::FSUtil::unLink(filename);
+    GGo::Logger::ptr logger(new GGo::Logger("async_block"));
+    GGo::AsyncFileLogAppender::ptr appender(new GGo::AsyncFileLogAppender(
+                filename, 4096, 10, GGo::AsyncFileLogAppender::BLOCK));
+    logger->addAppender(appender);
+    write_lines(logger);
+    appender->flush();
+    size_t lines = count_lines(filename);
+    cout << "block lines=" << lines << " dropped=" << appender->getDropped() << endl;
+    GGO_ASSERT(lines == (size_t)THREAD_COUNT * LINE_COUNT);
+    GGO_ASSERT(appender->getDropped() == 0);
+}
+
+/// @brief DROP策略下写入的行数加上丢弃的数量等于总数，丢弃数量会记录在文件中
+void test_drop(){
+    std::string filename = "/tmp/ggo_async_drop.log";
+    GGo::FSUtil::unLink(filename);
+    GGo::Logger::ptr logger(new GGo::Logger("async_drop"));
+    GGo::AsyncFileLogAppender::ptr appender(new GGo::AsyncFileLogAppender(
+                filename, 4096, 1000, GGo::AsyncFileLogAppender::DROP));
+    logger->addAppender(appender);
+    write_lines(logger);
+    appender->flush();
+    uint64_t dropped = appender->getDropped();
+    std::ifstream ifs(filename);
+    std::string line;
+    size_t lines = 0;
+    uint64_t reported = 0;
+    while(std::getline(ifs, line)){
+        const std::string prefix = "AsyncFileLogAppender dropped ";
+        if(line.compare(0, prefix.size(), prefix) == 0){
+            reported += std::stoull(line.substr(prefix.size()));
+        }else{
+            lines++;
+        }
+    }
+    cout << "drop lines=" << lines << " dropped=" << dropped << " reported=" << reported << endl;
+    GGO_ASSERT(lines + dropped == (size_t)THREAD_COUNT * LINE_COUNT);
+    GGO_ASSERT(reported == dropped);
+}
+
+/// @brief 从配置加载异步appender
+void test_config(){
+    std::string filename = "/tmp/ggo_async_config.log";
+    GGo::FSUtil::unLink(filename);
+    YAML::Node node = YAML::Load(
+        "logs:\n"
+        "    - name: async_config\n"
+        "      level: info\n"
+        "      appenders:\n"
+        "          - type: AsyncFileLogAppender\n"
+        "            file: " + filename + "\n"
+        "            buffer_size: 65536\n"
+        "            flush_interval: 50\n"
+        "            policy: block\n");
+    GGo::Config::loadFromYaml(node);
+    auto logger = GGO_LOG_NAME("async_config");
+    cout << logger->toYamlString() << endl;
+    GGO_LOG_INFO(logger) << "hello async";
+    // 等待后台线程按间隔写出
+    usleep(300 * 1000);
+    GGO_ASSERT(count_lines(filename) == 1);
+}
+
+/// @brief 线程交替写两个异步appender，线程退出后缓冲区写完即释放
+void test_thread_exit(){
+    std::string filename[2] = {"/tmp/ggo_async_exit0.log", "/tmp/ggo_async_exit1.log"};
+    GGo::Logger::ptr logger[2];
+    GGo::AsyncFileLogAppender::ptr appender[2];
+    for(int i = 0; i < 2; i++){
+        GGo::FSUtil::unLink(filename[i]);
+        logger[i].reset(new GGo::Logger("async_exit" + std::to_string(i)));
+        appender[i].reset(new GGo::AsyncFileLogAppender(filename[i], 65536, 10, GGo::AsyncFileLogAppender::BLOCK));
+        logger[i]->addAppender(appender[i]);
+    }
+    std::vector<GGo::Thread::ptr> threads;
+    for(int i = 0; i < THREAD_COUNT; i++){
+        threads.emplace_back(new GGo::Thread([&logger, i](){
+            for(int j = 0; j < LINE_COUNT / 10; j++){
+                GGO_LOG_INFO(logger[j % 2]) << "thread " << i << " line " << j;
+            }
+        }, "exit_" + std::to_string(i)));
+    }
+    for(auto& t : threads){
+        t->join();
+    }
+    for(int i = 0; i < 2; i++){
+        // 第一轮写出剩余内容并移除，之后不再有这些线程的缓冲区
+        appender[i]->flush();
+        appender[i]->flush();
+        cout << "exit buffers=" << appender[i]->getBufferCount() << endl;
+        GGO_ASSERT(appender[i]->getBufferCount() == 0);
+        GGO_ASSERT(count_lines(filename[i]) == (size_t)THREAD_COUNT * LINE_COUNT / 20);
+    }
+}
+
+/// @brief 读取进程的常驻内存(KB)
+static size_t rss_kb(){
+    std::ifstream ifs("/proc/self/status");
+    std::string line;
+    while(std::getline(ifs, line)){
+        if(line.compare(0, 6, "VmRSS:") == 0){
+            return std::stoull(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+/// @brief 常驻线程反复写重新创建的appender（例如配置重新加载），旧实例的缓冲区不能累积
+void test_recreate(){
+    const int WRITERS = 4;
+    const int ROUNDS = 100;
+    const size_t BUFFER_SIZE = 65536;
+    std::string filename = "/tmp/ggo_async_recreate.log";
+    GGo::FSUtil::unLink(filename);
+    GGo::Logger::ptr logger(new GGo::Logger("async_recreate"));
+    size_t live = GGo::AsyncFileLogAppender::GetLiveBufferCount();
+
+    std::atomic<int> round{0};
+    std::atomic<int> done{0};
+    std::atomic<bool> stop{false};
+    std::vector<GGo::Thread::ptr> threads;
+    for(int i = 0; i < WRITERS; i++){
+        threads.emplace_back(new GGo::Thread([&, i](){
+            // 每轮写满一个缓冲区，数据区的每一页都被访问过，泄漏会体现在常驻内存上
+            std::string text(500, 'a' + i);
+            for(int r = 1; !stop; r++){
+                while(round < r && !stop){
+                    usleep(100);
+                }
+                if(stop){
+                    break;
+                }
+                for(size_t j = 0; j < BUFFER_SIZE / text.size(); j++){
+                    GGO_LOG_INFO(logger) << text;
+                }
+                done++;
+            }
+        }, "recreate_" + std::to_string(i)));
+    }
+
+    size_t rss_begin = 0;
+    for(int r = 1; r <= ROUNDS; r++){
+        GGo::AsyncFileLogAppender::ptr appender(new GGo::AsyncFileLogAppender(
+                    filename, BUFFER_SIZE, 10, GGo::AsyncFileLogAppender::BLOCK));
+        logger->addAppender(appender);
+        round = r;
+        while(done < WRITERS * r){
+            usleep(100);
+        }
+        GGO_ASSERT(GGo::AsyncFileLogAppender::GetLiveBufferCount() == live + WRITERS);
+        logger->clearAppenders();
+        appender.reset();
+        // 实例析构后，仍在运行的线程缓存中不再占用它的缓冲区
+        GGO_ASSERT(GGo::AsyncFileLogAppender::GetLiveBufferCount() == live);
+        if(r == 10){
+            rss_begin = rss_kb();
+        }
+    }
+    size_t rss_end = rss_kb();
+    stop = true;
+    for(auto& t : threads){
+        t->join();
+    }
+    cout << "recreate rss begin=" << rss_begin << "KB end=" << rss_end << "KB" << endl;
+    // 泄漏时每轮增加WRITERS * BUFFER_SIZE，即256KB
+    GGO_ASSERT(rss_end < rss_begin + 4096);
+    GGO_ASSERT(count_lines(filename) == (size_t)ROUNDS * WRITERS * (BUFFER_SIZE / 500));
+}
+
+int main(int argc, char** argv){
+    test_block();
+    test_drop();
+    test_config();
+    test_thread_exit();
+    test_recreate();
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include<iostream>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+/// @brief 只计数的appender
+class CountLogAppender : public GGo::LogAppender{
+public:
+    using ptr = std::shared_ptr<CountLogAppender>;
+    void log(GGo::Logger::ptr logger, GGo::LogLevel level, GGo::LogEvent::ptr event) override{
+        if(level >= m_level){
+            m_count++;
+        }
+    }
+    std::string toYamlString() override { return ""; }
+    int m_count = 0;
+};
+
+static int s_evaluated = 0;
+
+/// @brief 只有日志真正输出时才会被调用
+static int side_effect(){
+    return ++s_evaluated;
+}
+
+/// @brief 同一个调用点，日志器和级别都可以不同
+static void log_at(GGo::Logger::ptr logger, GGo::LogLevel level){
+    GGO_LOG_LEVEL(logger, level) << "value=" << side_effect();
+}
+
+/// @brief 固定的调用点，级别改变后缓存要失效
+void test_set_level(){
+    GGo::Logger::ptr logger(new GGo::Logger("site_level"));
+    CountLogAppender::ptr appender(new CountLogAppender);
+    logger->addAppender(appender);
+    s_evaluated = 0;
+    for(int i = 0; i < 10; i++){
+        GGO_LOG_DEBUG(logger) << side_effect();
+    }
+    GGO_ASSERT(appender->m_count == 10 && s_evaluated == 10);
+    logger->setLevel(GGo::LogLevel::INFO);
+    for(int i = 0; i < 10; i++){
+        GGO_LOG_DEBUG(logger) << side_effect();
+    }
+    // 关闭的日志不会对参数求值
+    GGO_ASSERT(appender->m_count == 10 && s_evaluated == 10);
+    logger->setLevel(GGo::LogLevel::DEBUG);
+    GGO_LOG_DEBUG(logger) << side_effect();
+    GGO_ASSERT(appender->m_count == 11 && s_evaluated == 11);
+}
+
+/// @brief 同一个调用点交替使用不同的日志器和级别
+void test_shared_site(){
+    GGo::Logger::ptr debug_logger(new GGo::Logger("site_debug"));
+    GGo::Logger::ptr error_logger(new GGo::Logger("site_error"));
+    CountLogAppender::ptr debug_appender(new CountLogAppender);
+    CountLogAppender::ptr error_appender(new CountLogAppender);
+    debug_logger->addAppender(debug_appender);
+    error_logger->addAppender(error_appender);
+    error_logger->setLevel(GGo::LogLevel::ERROR);
+    for(int i = 0; i < 10; i++){
+        log_at(debug_logger, GGo::LogLevel::DEBUG);
+        log_at(error_logger, GGo::LogLevel::DEBUG);
+        log_at(error_logger, GGo::LogLevel::FATAL);
+    }
+    GGO_ASSERT(debug_appender->m_count == 10);
+    GGO_ASSERT(error_appender->m_count == 10);
+}
+
+/// @brief 没有目标的日志器交给root输出，root的级别同样生效
+void test_root(){
+    GGo::Logger::ptr root(new GGo::Logger("site_root"));
+    CountLogAppender::ptr appender(new CountLogAppender);
+    root->addAppender(appender);
+    GGo::Logger::ptr child(new GGo::Logger("site_child"));
+    child->setRootLogger(root);
+    log_at(child, GGo::LogLevel::INFO);
+    GGO_ASSERT(appender->m_count == 1);
+    root->setLevel(GGo::LogLevel::WARN);
+    s_evaluated = 0;
+    log_at(child, GGo::LogLevel::INFO);
+    GGO_ASSERT(appender->m_count == 1 && s_evaluated == 0);
+    // 子日志器有了自己的目标后不再受root级别限制
+    CountLogAppender::ptr own(new CountLogAppender);
+    child->addAppender(own);
+    log_at(child, GGo::LogLevel::INFO);
+    GGO_ASSERT(own->m_count == 1);
+}
+
+/// @brief 配置改变时缓存失效
+void test_config(){
+    auto logger = GGO_LOG_NAME("site_config");
+    CountLogAppender::ptr appender(new CountLogAppender);
+    YAML::Node node = YAML::Load(
+        "logs:\n"
+        "    - name: site_config\n"
+        "      level: error\n");
+    GGo::Config::loadFromYaml(node);
+    logger->addAppender(appender);
+    log_at(logger, GGo::LogLevel::INFO);
+    GGO_ASSERT(appender->m_count == 0);
+    node = YAML::Load(
+        "logs:\n"
+        "    - name: site_config\n"
+        "      level: info\n");
+    GGo::Config::loadFromYaml(node);
+    // 配置重建了目标，重新添加计数目标
+    logger->addAppender(appender);
+    log_at(logger, GGo::LogLevel::INFO);
+    GGO_ASSERT(appender->m_count == 1);
+}
+
+// 之后的日志语句在编译期去掉INFO及以下
+#undef GGO_LOG_MIN_LEVEL
+#define GGO_LOG_MIN_LEVEL 3
+
+/// @brief 编译期去掉的日志语句不会输出，参数也不会求值
+void test_min_level(){
+    GGo::Logger::ptr logger(new GGo::Logger("site_min"));
+    CountLogAppender::ptr appender(new CountLogAppender);
+    logger->addAppender(appender);
+    s_evaluated = 0;
+    GGO_LOG_DEBUG(logger) << side_effect();
+    GGO_LOG_INFO(logger) << side_effect();
+    GGO_LOG_WARN(logger) << side_effect();
+    GGO_ASSERT(appender->m_count == 1 && s_evaluated == 1);
+}
+
+int main(int argc, char** argv){
+    test_set_level();
+    test_shared_site();
+    test_root();
+    test_config();
+    test_min_level();
+    cout << "log site test passed" << endl;
+    return 0;
+}
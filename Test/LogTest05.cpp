@@ -0,0 +1,190 @@
+#include<iostream>
+#include<algorithm>
+#include<unistd.h>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+static const char* FILENAME = "/tmp/ggo_log_test05.blog";
+
+/// @brief 把日志格式化成文本保存下来，用来与二进制解码的结果比较
+class TextLogAppender : public GGo::LogAppender{
+public:
+    using ptr = std::shared_ptr<TextLogAppender>;
+    TextLogAppender(GGo::LogFormatter::ptr formatter)
+        :m_fmt(formatter){}
+    void log(GGo::Logger::ptr logger, GGo::LogLevel level, GGo::LogEvent::ptr event) override{
+        GGo::Mutex::Lock lock(m_lock);
+        m_lines.push_back(m_fmt->format(logger, level, event));
+    }
+    std::string toYamlString() override { return ""; }
+    std::vector<std::string> m_lines;
+private:
+    GGo::LogFormatter::ptr m_fmt;
+    GGo::Mutex m_lock;
+};
+
+/// @brief 只有operator<<的类型
+struct Point{
+    int x;
+    int y;
+};
+std::ostream& operator<<(std::ostream& os, const Point& p){
+    return os << "(" << p.x << "," << p.y << ")";
+}
+
+/// @brief 读出文件中全部日志并格式化
+static std::vector<std::string> decode(GGo::LogFormatter::ptr formatter, bool& error){
+    std::vector<std::string> lines;
+    GGo::BinaryLogReader reader;
+    GGO_ASSERT(reader.open(FILENAME));
+    while(GGo::LogEvent::ptr event = reader.next()){
+        lines.push_back(formatter->format(event->getLogger(), event->getLevel(), event));
+    }
+    error = reader.hasError();
+    return lines;
+}
+
+/// @brief {}按顺序替换为参数，参数保存原始类型
+void test_format(){
+    GGo::LogFormatter::ptr formatter(new GGo::LogFormatter("%m"));
+    GGo::Logger::ptr logger(new GGo::Logger("fmt"));
+    TextLogAppender::ptr appender(new TextLogAppender(formatter));
+    logger->addAppender(appender);
+
+    std::string host = "127.0.0.1";
+    GGO_LOG_FMT_INFO(logger, "request {} from {} cost {}ms", 42, host, 3.5);
+    GGO_LOG_FMT_INFO(logger, "no args");
+    GGO_LOG_FMT_INFO(logger, "missing {} {}", -1);
+    GGO_LOG_FMT_INFO(logger, "extra {}", 1u, 'c', true, Point{1, 2});
+    GGO_ASSERT(appender->m_lines.size() == 4);
+    GGO_ASSERT(appender->m_lines[0] == "request 42 from 127.0.0.1 cost 3.5ms");
+    GGO_ASSERT(appender->m_lines[1] == "no args");
+    GGO_ASSERT(appender->m_lines[2] == "missing -1 {}");
+    GGO_ASSERT(appender->m_lines[3] == "extra 1 c 1 (1,2)");
+
+    // 复用的线程事件不能带上上一条日志的参数
+    GGO_LOG_INFO(logger) << "stream " << 7;
+    GGO_ASSERT(appender->m_lines.back() == "stream 7");
+}
+
+/// @brief 写入二进制文件再解码，结果与文本输出完全相同
+void test_round_trip(){
+    unlink(FILENAME);
+    GGo::LogFormatter::ptr formatter(new GGo::LogFormatter(
+                "%d{%Y-%m-%d %H:%M:%S}%T%t%T%N%T%F%T[%p]%T[%c]%T%f:%L%T%m%n"));
+    GGo::Logger::ptr access(new GGo::Logger("access"));
+    GGo::Logger::ptr system(new GGo::Logger("system"));
+    TextLogAppender::ptr text(new TextLogAppender(formatter));
+    access->addAppender(text);
+    system->addAppender(text);
+    {
+        GGo::BinaryLogAppender::ptr binary(new GGo::BinaryLogAppender(FILENAME, 4096));
+        access->addAppender(binary);
+        system->addAppender(binary);
+        auto work = [&](){
+            for(int i = 0; i < 1000; i++){
+                GGO_LOG_FMT_INFO(access, "GET /index.html {} {} {}us", 200, (uint64_t)i * 1000, 0.25 * i);
+                if(i % 100 == 0){
+                    GGO_LOG_WARN(system) << "slow request " << i;
+                    GGO_LOG_FMT_ERROR(system, "{} failed", std::string("upstream"));
+                }
+            }
+        };
+        GGo::Thread t1(work, "worker_1");
+        GGo::Thread t2(work, "worker_2");
+        t1.join();
+        t2.join();
+        work();
+        access->clearAppenders();
+        system->clearAppenders();
+    }
+
+    std::vector<std::string> expect = text->m_lines;
+    bool error = false;
+    std::vector<std::string> lines = decode(formatter, error);
+    GGO_ASSERT(!error);
+    GGO_ASSERT(lines.size() == expect.size());
+    // 两个appender各自加锁，不同线程的日志在两种输出中的先后可能不同
+    std::sort(lines.begin(), lines.end());
+    std::sort(expect.begin(), expect.end());
+    size_t text_bytes = 0;
+    for(size_t i = 0; i < lines.size(); i++){
+        GGO_ASSERT(lines[i] == expect[i]);
+        text_bytes += expect[i].size();
+    }
+    GGo::ByteArray ba;
+    ba.readFromFile(FILENAME);
+    cout << lines.size() << " lines, text " << text_bytes << " bytes, binary "
+         << ba.getSize() << " bytes" << endl;
+    GGO_ASSERT(ba.getSize() * 3 < text_bytes);
+}
+
+/// @brief 最后一条记录不完整时读出之前的全部日志
+void test_truncated(){
+    GGo::LogFormatter::ptr formatter(new GGo::LogFormatter("%m"));
+    bool error = false;
+    size_t count = decode(formatter, error).size();
+    GGo::ByteArray ba;
+    ba.readFromFile(FILENAME);
+    GGO_ASSERT(truncate(FILENAME, ba.getSize() - 3) == 0);
+    std::vector<std::string> lines = decode(formatter, error);
+    GGO_ASSERT(error);
+    GGO_ASSERT(lines.size() == count - 1);
+}
+
+/// @brief 文件被移走后重新打开，新文件重新写入文件头与定义
+void test_reopen(){
+    unlink(FILENAME);
+    GGo::LogFormatter::ptr formatter(new GGo::LogFormatter("%c %N %m"));
+    GGo::Logger::ptr logger(new GGo::Logger("reopen"));
+    GGo::BinaryLogAppender::ptr binary(new GGo::BinaryLogAppender(FILENAME));
+    logger->addAppender(binary);
+    for(int i = 0; i < 2; i++){
+        GGO_LOG_FMT_INFO(logger, "line {}", i);
+    }
+    std::string moved = std::string(FILENAME) + ".1";
+    GGO_ASSERT(rename(FILENAME, moved.c_str()) == 0);
+    GGO_ASSERT(binary->reopen());
+    for(int i = 2; i < 4; i++){
+        GGO_LOG_FMT_INFO(logger, "line {}", i);
+    }
+    bool error = false;
+    std::vector<std::string> lines = decode(formatter, error);
+    GGO_ASSERT(!error);
+    GGO_ASSERT(lines.size() == 2);
+    GGO_ASSERT(lines[0] == "reopen " + GGo::Thread::GetThisName() + " line 2");
+    GGO_ASSERT(lines[1] == "reopen " + GGo::Thread::GetThisName() + " line 3");
+    unlink(moved.c_str());
+    unlink(FILENAME);
+}
+
+/// @brief 之后没有新日志时，缓冲的日志也由后台线程按间隔写出
+void test_quiet_flush(){
+    unlink(FILENAME);
+    GGo::LogFormatter::ptr formatter(new GGo::LogFormatter("%c %m"));
+    GGo::Logger::ptr logger(new GGo::Logger("quiet"));
+    GGo::BinaryLogAppender::ptr binary(new GGo::BinaryLogAppender(FILENAME, 64 * 1024, 50));
+    logger->addAppender(binary);
+    GGO_LOG_FMT_INFO(logger, "quiet {}", 1);
+    std::vector<std::string> lines;
+    bool error = false;
+    for(int i = 0; i < 100 && lines.empty(); i++){
+        usleep(10 * 1000);
+        lines = decode(formatter, error);
+    }
+    cout << "quiet flush lines=" << lines.size() << endl;
+    GGO_ASSERT(!error);
+    GGO_ASSERT(lines.size() == 1 && lines[0] == "quiet quiet 1");
+    unlink(FILENAME);
+}
+
+int main(){
+    test_format();
+    test_round_trip();
+    test_truncated();
+    test_reopen();
+    test_quiet_flush();
+    cout << "LogTest05 passed" << endl;
+    return 0;
+}
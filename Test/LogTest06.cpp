@@ -0,0 +1,118 @@
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<unistd.h>
+#include<sys/wait.h>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+static const char* FILENAME = "/tmp/ggo_log_test06/mmap.log";
+static const size_t SEGMENT_SIZE = 16 * 1024;
+static const uint32_t SEGMENT_COUNT = 3;
+
+/// @brief 读出分段文件的全部内容
+static std::string read_segment(uint32_t index){
+    std::ifstream ifs(std::string(FILENAME) + "." + std::to_string(index), std::ios::binary);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+static void remove_segments(){
+    for(uint32_t i = 0; i < SEGMENT_COUNT; i++){
+        unlink((std::string(FILENAME) + "." + std::to_string(i)).c_str());
+    }
+}
+
+static GGo::Logger::ptr create_logger(GGo::MmapFileLogAppender::ptr appender){
+    GGo::Logger::ptr logger(new GGo::Logger("mmap"));
+    appender->setFormatter(GGo::LogFormatter::ptr(new GGo::LogFormatter("%m%n")));
+    logger->addAppender(appender);
+    return logger;
+}
+
+/// @brief 写满后循环使用分段，每个分段中都是完整的行，旧的日志被覆盖
+void test_rotate(){
+    remove_segments();
+    const int THREADS = 4;
+    const int LINES = 5000;
+    {
+        GGo::MmapFileLogAppender::ptr appender(new GGo::MmapFileLogAppender(FILENAME, SEGMENT_SIZE, SEGMENT_COUNT));
+        GGo::Logger::ptr logger = create_logger(appender);
+        std::vector<GGo::Thread::ptr> threads;
+        for(int t = 0; t < THREADS; t++){
+            threads.emplace_back(new GGo::Thread([logger, t](){
+                for(int i = 0; i < LINES; i++){
+                    GGO_LOG_INFO(logger) << "thread " << t << " line " << i;
+                }
+            }, "mmap_" + std::to_string(t)));
+        }
+        for(auto& t : threads){
+            t->join();
+        }
+        GGO_ASSERT(appender->getDropped() == 0);
+        logger->clearAppenders();
+    }
+
+    // 关闭后分段截断到实际长度，没有预分配的0
+    size_t total = 0;
+    for(uint32_t i = 0; i < SEGMENT_COUNT; i++){
+        std::string data = read_segment(i);
+        GGO_ASSERT(data.size() <= SEGMENT_SIZE);
+        GGO_ASSERT(data.find('\0') == std::string::npos);
+        std::stringstream ss(data);
+        std::string line;
+        while(std::getline(ss, line)){
+            int t = -1, n = -1;
+            GGO_ASSERT(sscanf(line.c_str(), "thread %d line %d", &t, &n) == 2);
+            GGO_ASSERT(t >= 0 && t < THREADS && n >= 0 && n < LINES);
+            total++;
+        }
+    }
+    // 只保留了最近的几个分段
+    GGO_ASSERT(total > 0 && total < (size_t)THREADS * LINES);
+}
+
+/// @brief 进程崩溃后写入的日志仍在文件中，重新打开后跳过末尾的0接着写
+void test_crash(){
+    remove_segments();
+    pid_t pid = fork();
+    if(pid == 0){
+        GGo::MmapFileLogAppender::ptr appender(new GGo::MmapFileLogAppender(FILENAME, SEGMENT_SIZE, SEGMENT_COUNT));
+        GGo::Logger::ptr logger = create_logger(appender);
+        for(int i = 0; i < 100; i++){
+            GGO_LOG_INFO(logger) << "before crash " << i;
+        }
+        // 不执行析构，分段保持预分配的大小
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    GGo::MmapFileLogAppender::ptr appender(new GGo::MmapFileLogAppender(FILENAME, SEGMENT_SIZE, SEGMENT_COUNT));
+    uint32_t index = appender->getCurrentIndex();
+    std::string data = read_segment(index);
+    GGO_ASSERT(data.size() == SEGMENT_SIZE);
+    GGo::Logger::ptr logger = create_logger(appender);
+    GGO_LOG_INFO(logger) << "after crash";
+    logger->clearAppenders();
+    appender.reset();
+
+    std::ifstream ifs(std::string(FILENAME) + "." + std::to_string(index));
+    std::string line;
+    for(int i = 0; i < 100; i++){
+        GGO_ASSERT(std::getline(ifs, line));
+        GGO_ASSERT(line == "before crash " + std::to_string(i));
+    }
+    GGO_ASSERT(std::getline(ifs, line) && line == "after crash");
+    GGO_ASSERT(!std::getline(ifs, line));
+}
+
+int main(){
+    test_rotate();
+    test_crash();
+    remove_segments();
+    cout << "LogTest06 passed" << endl;
+    return 0;
+}
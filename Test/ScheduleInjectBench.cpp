@@ -0,0 +1,89 @@
+#include<iostream>
+#include<iomanip>
+#include<chrono>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+/// @brief 跨线程调度基准：调度器之外的producers个线程并发调用Scheduler::schedule，
+///        工作线程执行完全部任务为止，比较无锁注入队列与加锁的任务队列
+/// 用法：ScheduleInjectBench [missions] [workers]
+
+static std::atomic<uint64_t> s_executed{0};
+
+static void on_run(){
+    s_executed.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// @brief 一次运行的结果
+struct Result{
+    // 每秒提交的任务数（到所有producer返回为止）
+    double submit;
+    // 每秒完成的任务数（到所有任务执行完为止）
+    double complete;
+};
+
+/// @brief 运行一轮
+/// @param inject_size 注入队列容量，0表示关闭，外部线程提交的任务全部走加锁的队列
+static Result bench(uint32_t inject_size, int producers, int workers, uint64_t total){
+    GGo::Config::Lookup<uint32_t>("scheduler.inject_queue_size", 1024u, "")->setValue(inject_size);
+    GGo::Scheduler scheduler(workers, false, inject_size ? "inject" : "mutex");
+    scheduler.start();
+
+    uint64_t per_producer = total / producers;
+    uint64_t expect = per_producer * producers;
+    s_executed = 0;
+    std::atomic<bool> go{false};
+    std::vector<GGo::Thread::ptr> threads;
+    for(int i = 0; i < producers; i++){
+        threads.emplace_back(new GGo::Thread([&](){
+            while(!go){}
+            for(uint64_t j = 0; j < per_producer; j++){
+                scheduler.schedule(&on_run);
+            }
+        }, "producer_" + std::to_string(i)));
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    go = true;
+    for(auto& t : threads){
+        t->join();
+    }
+    std::chrono::duration<double> submitted = std::chrono::steady_clock::now() - begin;
+    while(s_executed.load(std::memory_order_relaxed) < expect){
+        sched_yield();
+    }
+    std::chrono::duration<double> completed = std::chrono::steady_clock::now() - begin;
+    scheduler.stop();
+    GGO_ASSERT(s_executed == expect);
+    return {expect / submitted.count(), expect / completed.count()};
+}
+
+int main(int argc, char** argv){
+    uint64_t total = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    int workers = argc > 2 ? atoi(argv[2]) : 4;
+    // 调度器启停与配置查找的日志会混进结果
+    GGO_LOG_NAME("system")->setLevel(GGo::LogLevel::ERROR);
+    GGO_LOG_ROOT()->setLevel(GGo::LogLevel::ERROR);
+    cout << "cross-thread Scheduler::schedule, " << total << " missions per run, "
+         << workers << " workers" << endl;
+    cout << std::setw(10) << "producers"
+         << std::setw(16) << "mutex submit"
+         << std::setw(16) << "inject submit"
+         << std::setw(10) << "speedup"
+         << std::setw(16) << "mutex done"
+         << std::setw(16) << "inject done"
+         << std::setw(10) << "speedup" << "   (ops/s)" << endl;
+    for(int producers : {1, 4, 16, 64}){
+        Result old_result = bench(0, producers, workers, total);
+        Result new_result = bench(1024, producers, workers, total);
+        cout << std::setw(10) << producers
+             << std::setw(16) << (uint64_t)old_result.submit
+             << std::setw(16) << (uint64_t)new_result.submit
+             << std::setw(10) << std::setprecision(3) << new_result.submit / old_result.submit
+             << std::setw(16) << (uint64_t)old_result.complete
+             << std::setw(16) << (uint64_t)new_result.complete
+             << std::setw(10) << std::setprecision(3) << new_result.complete / old_result.complete << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "GGo.h"
+
+GGo::Logger::ptr g_logger = GGO_LOG_NAME("system");
+
+static std::atomic<uint64_t> s_done{0};
+static std::atomic<uint64_t> s_wrong_thread{0};
+
+// 普通任务，会被任意线程执行或窃取
+void plain_mission(){
+    s_done++;
+}
+
+// 指定线程的任务，只能在目标线程上执行
+void pinned_mission(int thread){
+    if(GGo::GetThreadID() != thread){
+        s_wrong_thread++;
+    }
+    s_done++;
+}
+
+static std::atomic<uint64_t> s_corrupted{0};
+
+// 在工作线程上批量产生任务，其余线程需要从它的队列里窃取
+void producer(){
+    // 切换前后栈上的数据必须保持不变（共享栈模式下会被换出再换入）
+    volatile uint64_t stamp[64];
+    for(int j = 0; j < 64; j++){
+        stamp[j] = GGo::Fiber::getFiberID() + j;
+    }
+    for(int i = 0; i < 1000; i++){
+        GGo::Scheduler::getThis()->schedule(&plain_mission);
+        if(i % 100 == 0){
+            GGo::Fiber::yieldToReady();
+        }
+    }
+    for(int j = 0; j < 64; j++){
+        if(stamp[j] != GGo::Fiber::getFiberID() + j){
+            s_corrupted++;
+            break;
+        }
+    }
+}
+
+void test_work_stealing(bool use_caller){
+    s_done = 0;
+    s_wrong_thread = 0;
+    GGo::Scheduler scheduler(4, use_caller, "steal");
+    scheduler.start();
+    for(int i = 0; i < 10; i++){
+        scheduler.schedule(&producer);
+    }
+    for(int i = 0; i < 1000; i++){
+        scheduler.schedule(&plain_mission);
+    }
+    scheduler.schedule([&scheduler](){
+        int self = GGo::GetThreadID();
+        for(int i = 0; i < 100; i++){
+            GGo::Scheduler::getThis()->schedule(std::bind(&pinned_mission, self), self);
+        }
+    });
+    scheduler.stop();
+    GGO_LOG_INFO(g_logger) << "use_caller=" << use_caller
+                           << " done=" << s_done
+                           << " expect=" << 10 * 1000 + 1000 + 100
+                           << " wrong_thread=" << s_wrong_thread
+                           << " corrupted=" << s_corrupted
+                           << " fibers created=" << GGo::Fiber::CreatedFibers()
+                           << " reused=" << GGo::Fiber::ReusedFibers();
+    GGO_ASSERT(s_done == 10 * 1000 + 1000 + 100);
+    GGO_ASSERT(s_wrong_thread == 0);
+    GGO_ASSERT(s_corrupted == 0);
+}
+
+int main(){
+    test_work_stealing(false);
+    test_work_stealing(true);
+
+    // 共享栈模式
+    GGo::Config::Lookup<bool>("fiber.shared_stack", false)->setValue(true);
+    test_work_stealing(false);
+    test_work_stealing(true);
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include<iostream>
+#include<iomanip>
+#include<chrono>
+#include<random>
+#include "GGo.h"
+using std::cout;
+using std::endl;
+
+/// @brief 只用于测试的定时器管理器
+class BenchTimerManager : public GGo::TimerManager{
+protected:
+    void onTimerInsertedAtFront() override {}
+};
+
+static void noop(){}
+
+/// @brief 按配置创建使用有序集合或时间轮的管理器
+static std::shared_ptr<BenchTimerManager> create(bool wheel){
+    GGo::Config::Lookup<bool>("timer.wheel", false)->setValue(wheel);
+    return std::make_shared<BenchTimerManager>();
+}
+
+/// @brief 预先放入connections个长超时定时器，threads个线程不断取消并重新添加，
+///        模拟每次socket读写都会创建并取消一个超时定时器，返回每秒操作数
+static double churn(bool wheel, int threads, size_t connections, uint64_t ops){
+    auto manager = create(wheel);
+    std::vector<GGo::Timer::ptr> timers(connections);
+    std::mt19937 rng(1);
+    for(auto& timer : timers){
+        timer = manager->addTimer(5000 + rng() % 25000, &noop);
+    }
+
+    uint64_t per_thread = ops / threads;
+    size_t slice = connections / threads;
+    std::atomic<bool> go{false};
+    std::vector<GGo::Thread::ptr> workers;
+    for(int i = 0; i < threads; i++){
+        workers.emplace_back(new GGo::Thread([&, i](){
+            std::mt19937 rng(i + 1);
+            while(!go){}
+            for(uint64_t j = 0; j < per_thread; j++){
+                size_t index = i * slice + rng() % slice;
+                timers[index]->cancel();
+                timers[index] = manager->addTimer(5000 + rng() % 25000, &noop);
+                if((j & 1023) == 0){
+                    std::vector<std::function<void()>> cbs;
+                    manager->listExpriedCb(cbs);
+                    manager->getNextTimer();
+                }
+            }
+        }, "churn_" + std::to_string(i)));
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    go = true;
+    for(auto& t : workers){
+        t->join();
+    }
+    std::chrono::duration<double> used = std::chrono::steady_clock::now() - begin;
+    return per_thread * threads / used.count();
+}
+
+/// @brief 检查定时器不会提前触发（以定时器使用的粗粒度时钟为准），并且全部都会触发
+static void check(bool wheel){
+    auto manager = create(wheel);
+    const int COUNT = 10000;
+    std::atomic<int> fired{0};
+    std::atomic<int> early{0};
+    std::mt19937 rng(7);
+    std::vector<GGo::Timer::ptr> cancelled;
+    for(int i = 0; i < COUNT; i++){
+        uint64_t ms = rng() % 300;
+        uint64_t deadline = GGo::now(GGo::COARSE) + ms;
+        manager->addTimer(ms, [&fired, &early, deadline](){
+            if(GGo::now(GGo::COARSE) < deadline){
+                early++;
+            }
+            fired++;
+        });
+        // 再加一个之后取消的定时器，不能被触发
+        cancelled.push_back(manager->addTimer(ms, [&early](){ early++; }));
+    }
+    for(auto& timer : cancelled){
+        GGO_ASSERT(timer->cancel());
+    }
+    while(fired < COUNT){
+        uint64_t next = manager->getNextTimer();
+        GGO_ASSERT(next != ~0ull);
+        usleep(std::min<uint64_t>(next, 5) * 1000);
+        std::vector<std::function<void()>> cbs;
+        manager->listExpriedCb(cbs);
+        for(auto& cb : cbs){
+            cb();
+        }
+    }
+    GGO_ASSERT(early == 0);
+    GGO_ASSERT(!manager->hasTimer());
+    GGO_ASSERT(manager->getNextTimer() == ~0ull);
+}
+
+int main(int argc, char** argv){
+    size_t connections = argc > 1 ? std::stoull(argv[1]) : 100000;
+    uint64_t ops = argc > 2 ? std::stoull(argv[2]) : 2000000;
+    check(false);
+    check(true);
+
+    cout << "timer churn (cancel + add), " << connections << " live timers, "
+         << ops << " ops per run" << endl;
+    cout << std::setw(10) << "threads"
+         << std::setw(20) << "set ops/s"
+         << std::setw(20) << "wheel ops/s"
+         << std::setw(12) << "speedup" << endl;
+    for(int threads : {1, 4, 16}){
+        double set_ops = churn(false, threads, connections, ops);
+        double wheel_ops = churn(true, threads, connections, ops);
+        cout << std::setw(10) << threads
+             << std::setw(20) << (uint64_t)set_ops
+             << std::setw(20) << (uint64_t)wheel_ops
+             << std::setw(12) << std::setprecision(3) << wheel_ops / set_ops << endl;
+    }
+    return 0;
+}
@@ -36,12 +36,32 @@ void test_backtrace(){
     func0();
 }
 
+/// @brief 测试精确时钟与缓存时钟
+void test_clock(){
+    uint64_t ms = GGo::getCurrentMS();
+    uint64_t us = GGo::getCurrentUS();
+    GGO_ASSERT(us / 1000 >= ms && us / 1000 - ms < 10);
+    // 没有事件循环刷新时，粗粒度时钟与精确时钟相差不超过一个tick
+    uint64_t coarse = GGo::now(GGo::COARSE);
+    uint64_t precise = GGo::now(GGo::PRECISE);
+    GGO_ASSERT(coarse <= precise && precise - coarse < 20);
+    // 刷新后读到的是缓存值，不再随时间变化
+    uint64_t cached = GGo::updateCoarseClock();
+    usleep(30 * 1000);
+    GGO_ASSERT(GGo::now(GGo::COARSE) == cached);
+    GGO_ASSERT(GGo::now() >= cached + 30);
+    GGo::clearCoarseClock();
+    GGO_ASSERT(GGo::now(GGo::COARSE) >= cached + 20);
+    GGO_LOG_INFO(g_logger) << "clock ms=" << ms << " us=" << us << " coarse=" << coarse;
+}
+
 void test_assert(){
     GGO_ASSERT(1==2);
     return;
 }
 
 int main(){
+    test_clock();
     YAML::Node node = YAML::LoadFile("/root/workspace/GGoSeverFrame/Test/conf/log.yml");
     GGo::Config::loadFromYaml(node);
     test_assert();
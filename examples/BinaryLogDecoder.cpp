@@ -0,0 +1,30 @@
+#include<iostream>
+#include "logSystem.h"
+
+/// @brief 把BinaryLogAppender输出的文件还原成文本
+/// 用法：BinaryLogDecoder <file> [pattern]，pattern同LogFormatter，默认与文本日志相同
+int main(int argc, char** argv){
+    if(argc < 2){
+        std::cerr << "usage: " << argv[0] << " <file> [pattern]" << std::endl;
+        return 1;
+    }
+    std::string pattern = argc > 2 ? argv[2] : "%d{%Y-%m-%d %H:%M:%S}%T%t%T%N%T%F%T[%p]%T[%c]%T%f:%L%T%m%n";
+    GGo::LogFormatter::ptr formatter(new GGo::LogFormatter(pattern));
+    if(formatter->isError()){
+        std::cerr << "invalid pattern: " << pattern << std::endl;
+        return 1;
+    }
+    GGo::BinaryLogReader reader;
+    if(!reader.open(argv[1])){
+        std::cerr << argv[1] << " is not a binary log file" << std::endl;
+        return 1;
+    }
+    while(GGo::LogEvent::ptr event = reader.next()){
+        formatter->format(std::cout, event->getLogger(), event->getLevel(), event);
+    }
+    if(reader.hasError()){
+        std::cerr << argv[1] << ": truncated or corrupted record, stopped" << std::endl;
+        return 2;
+    }
+    return 0;
+}